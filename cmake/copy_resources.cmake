@@ -1,26 +1,19 @@
 # ===================================================
-# Copy resources folder into output dir - https://www.youtube.com/watch?v=sTuIRzrB2dA
+# Pack the resources folder into an archive in the output dir. Only reruns when a resource (or the packer)
+# changes, instead of deleting and copying everything on every build.
 # ===================================================
 set(TMP_OUT_DIR "${CMAKE_RUNTIME_OUTPUT_DIRECTORY}/tmp")
-set(RES_OUT_DIR "${CMAKE_RUNTIME_OUTPUT_DIRECTORY}/res/${PROJECT_NAME}")
 set(RES_SOURCE_DIR "${CMAKE_CURRENT_SOURCE_DIR}/res/${PROJECT_NAME}")
-set(RES_SHADER_OUT_DIR "${CMAKE_RUNTIME_OUTPUT_DIRECTORY}/res/${PROJECT_NAME}/shaders")
+set(RES_ARCHIVE_OUT "${CMAKE_RUNTIME_OUTPUT_DIRECTORY}/res/${PROJECT_NAME}.pak")
+file(GLOB_RECURSE RES_SOURCE_FILES CONFIGURE_DEPENDS "${RES_SOURCE_DIR}/*")
 
-add_custom_target("${PROJECT_NAME}_delete_tmp_out" ALL
-    COMMAND ${CMAKE_COMMAND} -E remove_directory
-    ${TMP_OUT_DIR}
-    COMMENT "Cleaning output tmp folder: ${TMP_OUT_DIR}")
-add_custom_target("${PROJECT_NAME}_delete_resources_out" ALL
-    COMMAND ${CMAKE_COMMAND} -E remove_directory
-    ${RES_OUT_DIR}
-    COMMENT "Cleaning output resource folder: ${RES_OUT_DIR}")
-add_custom_target("${PROJECT_NAME}_copy_resources_to_out" ALL
-    COMMAND ${CMAKE_COMMAND} -E copy_directory
-    ${RES_SOURCE_DIR}
-    ${RES_OUT_DIR}
-    COMMENT "Copying resource folder to output:\n${RES_SOURCE_DIR} -> ${RES_INTERM_DIR}")
+# The shader cache only checks whether a .spv exists, so it goes whenever the sources might have changed
+add_custom_command(
+    OUTPUT ${RES_ARCHIVE_OUT}
+    COMMAND ${CMAKE_COMMAND} -E remove_directory ${TMP_OUT_DIR}/shader_cache
+    COMMAND foxy_pack ${RES_SOURCE_DIR} ${RES_ARCHIVE_OUT}
+    DEPENDS foxy_pack ${RES_SOURCE_FILES}
+    COMMENT "Packing resource folder:\n${RES_SOURCE_DIR} -> ${RES_ARCHIVE_OUT}")
+add_custom_target("${PROJECT_NAME}_pack_resources" ALL DEPENDS ${RES_ARCHIVE_OUT})
 
-# These will execute in reverse order due to dependency graph
-add_dependencies("${PROJECT_NAME}" "${PROJECT_NAME}_copy_resources_to_out")
-add_dependencies("${PROJECT_NAME}_copy_resources_to_out" "${PROJECT_NAME}_delete_resources_out")
-add_dependencies("${PROJECT_NAME}_delete_resources_out" "${PROJECT_NAME}_delete_tmp_out")
+add_dependencies("${PROJECT_NAME}" "${PROJECT_NAME}_pack_resources")
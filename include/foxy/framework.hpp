@@ -8,6 +8,7 @@
   FOXY LIBRARIES
 ----------------------*/
 #include "koyote.hpp"
+#include "kitsune.hpp"
 #include "ookami.hpp"
 #include "neko.hpp"
 #include "inferno.hpp"
@@ -16,4 +17,7 @@
   FOXY FRAMEWORK
 ----------------------*/
 #include "foxy/app.hpp"
+#include "foxy/frame_arena.hpp"
+#include "foxy/vfs.hpp"
+#include "foxy/asset_manager.hpp"
 #include "foxy/version.hpp"
\ No newline at end of file
@@ -1,3 +1,4 @@
 #pragma once
 
-#include "inferno/window.hpp"
\ No newline at end of file
+#include "inferno/window.hpp"
+#include "inferno/input.hpp"
\ No newline at end of file
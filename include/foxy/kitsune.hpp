@@ -0,0 +1,4 @@
+#pragma once
+
+#include "kitsune/profiler.hpp"
+#include "kitsune/cpu_time.hpp"
\ No newline at end of file
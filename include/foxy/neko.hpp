@@ -1,4 +1,6 @@
 #pragma once
 
 #include "neko/ecs.hpp"
-#include "inu/job_system.hpp"
\ No newline at end of file
+#include "inu/job_system.hpp"
+#include "inu/task.hpp"
+#include "inu/async_io.hpp"
\ No newline at end of file
@@ -1,3 +1,9 @@
 #pragma once
 
-#include "ookami/render_engine.hpp"
\ No newline at end of file
+#include "ookami/render_engine.hpp"
+#include "ookami/render_world.hpp"
+#include "ookami/mesh/mesh.hpp"
+#include "ookami/mesh/obj_importer.hpp"
+#include "ookami/mesh/mesh_optimizer.hpp"
+#include "ookami/mesh/meshlet.hpp"
+#include "ookami/mesh/cluster_culling.hpp"
\ No newline at end of file
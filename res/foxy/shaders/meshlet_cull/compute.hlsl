@@ -0,0 +1,95 @@
+// meshlet cull compute
+// The GPU side of ookami/mesh/cluster_culling.hpp: one thread per meshlet, frustum and normal cone tests in
+// object space, survivors appended as VkDrawIndexedIndirectCommands for vkCmdDrawIndexedIndirectCount.
+// Buffer layouts match Meshlet, MeshletBounds, and DrawIndexedIndirectCommand on the CPU.
+// https://advances.realtimerendering.com/s2015/aaltonenhaar_siggraph2015_combined_final_footer_220dpi.pdf
+
+static const uint FRUSTUM_CULLING = 1;
+static const uint BACKFACE_CULLING = 2;
+
+struct Meshlet {
+  uint vertex_offset;
+  uint triangle_offset;
+  uint vertex_count;
+  uint triangle_count;
+};
+
+struct MeshletBounds {
+  float3 center;
+  float radius;
+  float3 cone_axis;
+  float cone_cutoff;
+  float3 cone_apex;
+  float reserved;
+};
+
+struct DrawIndexedIndirectCommand {
+  uint index_count;
+  uint instance_count;
+  uint first_index;
+  int vertex_offset;
+  uint first_instance;
+};
+
+// ClusterCullInfo, 128 bytes so it fits the guaranteed push constant range
+struct CullConstants {
+  float4 frustum_planes[6];
+  float3 eye;
+  uint meshlet_count;
+  uint first_index;
+  uint instance;
+  uint flags;
+  uint padding;
+};
+
+[[vk::push_constant]] CullConstants constants;
+
+[[vk::binding(0)]] StructuredBuffer<Meshlet> meshlets;
+[[vk::binding(1)]] StructuredBuffer<MeshletBounds> bounds;
+[[vk::binding(2)]] RWStructuredBuffer<DrawIndexedIndirectCommand> draws;
+// Zeroed before the dispatch
+[[vk::binding(3)]] RWStructuredBuffer<uint> draw_count;
+
+bool outside_frustum(MeshletBounds b) {
+  for (uint i = 0; i < 6; ++i) {
+    float4 plane = constants.frustum_planes[i];
+    if (dot(plane.xyz, b.center) + plane.w < -b.radius * length(plane.xyz)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool backfacing(MeshletBounds b) {
+  float3 view = b.cone_apex - constants.eye;
+  float distance = length(view);
+  return distance > 0.0f && dot(view, b.cone_axis) >= b.cone_cutoff * distance;
+}
+
+[numthreads(64, 1, 1)]
+void main(uint3 id: SV_DispatchThreadID) {
+  uint index = id.x;
+  if (index >= constants.meshlet_count) {
+    return;
+  }
+
+  MeshletBounds b = bounds[index];
+  if ((constants.flags & FRUSTUM_CULLING) != 0 && outside_frustum(b)) {
+    return;
+  }
+  if ((constants.flags & BACKFACE_CULLING) != 0 && backfacing(b)) {
+    return;
+  }
+
+  Meshlet meshlet = meshlets[index];
+  uint slot;
+  InterlockedAdd(draw_count[0], 1, slot);
+
+  DrawIndexedIndirectCommand draw;
+  draw.index_count = meshlet.triangle_count * 3;
+  draw.instance_count = 1;
+  draw.first_index = constants.first_index + meshlet.triangle_offset * 3;
+  draw.vertex_offset = 0;
+  draw.first_instance = constants.instance;
+  draws[slot] = draw;
+}
@@ -1,11 +1,24 @@
 #include "app.hpp"
 
 #include "version.hpp"
+#include "frame_pipeline.hpp"
+#include "frame_limiter.hpp"
+#include "frame_arena.hpp"
+#include "vfs.hpp"
+#include "asset_manager.hpp"
+#include "parallel_stage.hpp"
 
 #include <inferno/window.hpp>
+#include <inferno/input.hpp>
 #include <ookami/render_engine.hpp>
+#include <ookami/render_world.hpp>
+#include <ookami/mesh/mesh.hpp>
 #include <inu/job_system.hpp>
+#include <inu/task.hpp>
+#include <inu/async_io.hpp>
 #include <neko/ecs.hpp>
+#include <kitsune/profiler.hpp>
+#include <kitsune/cpu_time.hpp>
 
 namespace fx {
   struct AppLoggingHelper {
@@ -45,8 +58,10 @@ namespace fx {
   public:
     explicit Impl(App& app, const CreateInfo& create_info):
       app_{ app },
+      headless_{ create_info.headless },
+      vfs_{ mount_resources() },
       window_{
-        std::make_shared<Window>(
+        headless_ ? nullptr : std::make_shared<Window>(
           Window::CreateInfo{
             .title = create_info.title,
             .width = create_info.width,
@@ -57,9 +72,45 @@ namespace fx {
           }
         )
       },
-      render_engine_{ std::make_unique<RenderEngine>(window_) }
+      render_engine_{
+        headless_ ? nullptr : std::make_unique<RenderEngine>(
+          window_,
+          [vfs = vfs_.get()](const std::filesystem::path& path) { return vfs->read_text(path); }
+        )
+      },
+      wait_for_events_{ create_info.wait_for_events },
+      power_policy_{ create_info.power_policy },
+      low_latency_{ create_info.low_latency },
+      job_system_{
+        JobSystem::CreateInfo{
+          .worker_count = worker_count(create_info),
+          .background_workers = create_info.background_workers,
+          .pin_workers = create_info.pin_workers,
+        }
+      },
+      io_{ job_system_ },
+      assets_{
+        job_system_, io_, *vfs_,
+        AssetManager::CreateInfo{
+          .memory_budget = create_info.asset_memory_budget,
+          .uploads_per_frame = create_info.asset_uploads_per_frame,
+        }
+      },
+      frame_pipeline_{ create_info.max_frames_ahead },
+      // One world per frame that can be in flight between extraction and rendering, so the game thread never
+      // writes into the one the render thread is reading (two with the default single frame of lead)
+      render_worlds_(create_info.max_frames_ahead + 1),
+      frame_limiter_{ create_info.target_frame_rate, !create_info.headless }
     {
-      window_->set_hidden(false);
+      if (headless_) {
+        Log::info("Running headless, no window or renderer");
+      } else {
+        window_->set_hidden(false);
+      }
+      assets_.register_loader<Mesh>({
+        .decode = [](const std::span<const std::byte> bytes) { return Mesh::from_bytes(bytes); },
+        .size = [](const Mesh& mesh) { return mesh.size_bytes(); },
+      });
       set_callbacks();
     }
     
@@ -75,171 +126,561 @@ namespace fx {
       stage_callback(stage).add_callback(std::forward<StageCallback>(callback));
     }
     
+    void add_function_to_stage(const Stage stage, StageCallback&& callback, StageCallbackInfo&& info)
+    {
+      if (!info.parallel) {
+        add_function_to_stage(stage, std::forward<StageCallback>(callback));
+        return;
+      }
+      
+      auto& parallel_stage{ parallel_stages_[static_cast<std::size_t>(stage)] };
+      if (!parallel_stage) {
+        parallel_stage = std::make_unique<ParallelStage>(job_system_);
+      }
+      parallel_stage->add(std::move(info.name), std::forward<StageCallback>(callback), std::move(info.after), std::move(info.before));
+    }
+    
+    void spawn(Task<>&& task)
+    {
+      tasks_.spawn(std::move(task));
+    }
+    
+    // Any thread, a task may be waiting for a stage from a worker
+    void add_stage_waiter(const Stage stage, const std::coroutine_handle<> handle)
+    {
+      std::scoped_lock lock{ stage_waiters_mutex_ };
+      stage_waiters_[static_cast<std::size_t>(stage)].push_back(handle);
+    }
+    
+    [[nodiscard]] auto job_system() -> JobSystem&
+    {
+      return job_system_;
+    }
+    
+    [[nodiscard]] auto io() -> AsyncIO&
+    {
+      return io_;
+    }
+    
+    [[nodiscard]] auto vfs() -> Vfs&
+    {
+      return *vfs_;
+    }
+    
+    [[nodiscard]] auto assets() -> AssetManager&
+    {
+      return assets_;
+    }
+    
     [[nodiscard]] auto user_data() -> shared<void>
     {
       return user_data_;
     }
     
+    [[nodiscard]] auto input() const -> const InputState&
+    {
+      return input_;
+    }
+    
+    [[nodiscard]] auto render_world() -> RenderWorld&
+    {
+      return render_worlds_[extract_frame_ % render_worlds_.size()];
+    }
+    
     void run()
     {
-      thread_pool_.push_task(FOXY_LAMBDA(game_loop));
+      FOXY_PROFILE_BEGIN_SESSION("foxy_trace.json");
+      FOXY_PROFILE_THREAD("main");
+      
+      if (headless_) {
+        // Nothing to poll and nothing to render, so the calling thread simply becomes the game thread
+        game_loop();
+        log_pacing_stats();
+        log_frame_arena_stats();
+        log_asset_stats();
+        FOXY_PROFILE_END_SESSION();
+        return;
+      }
+      
+      render_thread_ = std::jthread{ [this] { render_loop(); } };
+      game_thread_ = std::jthread{ [this] { game_loop(); } };
       main_loop();
-      thread_pool_.wait_for_tasks();
+      game_thread_.join();
+      if (render_thread_.joinable()) {
+        render_thread_.join();
+      }
+      
+      const auto stats{ frame_pipeline_.stats() };
+      Log::debug(
+        "Frame pipeline: {} frames | simulate {:.3f}ms, render {:.3f}ms, game waited {:.3f}ms, render waited {:.3f}ms | concurrency {:.2f}x",
+        stats.frames_rendered, stats.simulate_ms, stats.render_ms, stats.game_wait_ms, stats.render_wait_ms, stats.concurrency
+      );
+      log_pacing_stats();
+      log_frame_arena_stats();
+      log_asset_stats();
+      
+      FOXY_PROFILE_END_SESSION();
+    }
+    
+    void stop()
+    {
+      request_stop();
+      if (!headless_) {
+        // The window's close flag belongs to the main thread
+        job_system_.submit_to_main_thread([this] { window_->close(); });
+      }
+    }
+    
+    [[nodiscard]] auto headless() const -> bool
+    {
+      return headless_;
     }
   
   private:
+    // Only used for the title bar readout when no frame rate target is set
     const double frame_time_goal_{ 1. / 250. };
+    // Upper bound on how long the main thread sleeps, so its own update callbacks (profiler flush) still run
+    const double event_wait_timeout_{ 0.25 };
     
     shared<void> user_data_;
     App& app_;
     
+    const bool headless_;
+    // Before the renderer, which loads its shaders through it
+    unique<Vfs> vfs_;
+    // Both null when headless
     shared<Window> window_;
     unique<RenderEngine> render_engine_;
-    
-    BS::thread_pool thread_pool_{ std::thread::hardware_concurrency() - 1 };
+    const bool wait_for_events_;
+    const PowerPolicy power_policy_;
+    const bool low_latency_;
+    
+    // Declared before the job system so they outlive it: its workers may still resume tasks while draining.
+    // Whatever never finished is destroyed along with the scope.
+    TaskScope tasks_{};
+    std::mutex stage_waiters_mutex_;
+    std::array<std::vector<std::coroutine_handle<>>, static_cast<std::size_t>(Stage::Asleep) + 1> stage_waiters_{};
+    // Game thread only, swapped with a stage's waiters so resuming never allocates
+    std::vector<std::coroutine_handle<>> resuming_{};
+    
+    // Main, game and render threads are dedicated, everything else goes through the job system
+    JobSystem job_system_;
+    // Goes before the job system, its completions still need workers while it drains
+    AsyncIO io_;
+    // And this goes before both, for the same reason
+    AssetManager assets_;
+    std::jthread game_thread_;
+    // Main thread polls input, the game thread simulates frame N+1, and the render thread records frame N
+    FramePipeline frame_pipeline_;
+    std::jthread render_thread_;
+    std::vector<RenderWorld> render_worlds_;
+    // Waited on by the render thread after present, or by the game thread before input in low latency mode
+    FrameLimiter frame_limiter_;
+    // Cleared by stop() from any thread, or by the main thread once the window closes
+    std::atomic<bool> running_{ true };
+    // GameLoop watches a plain bool, so the game thread mirrors running_ into this once per update
+    bool game_running_{ true };
+    // Game thread only
+    u64 extract_frame_{ 0 };
+    InputState input_{};
+    // Set once the first tick of a loop iteration has drained input, cleared by the update that ends it
+    bool input_drained_{ false };
+    
+    enum class PowerState {
+      Foreground,
+      // Unfocused, still visible
+      Background,
+      // Hidden or minimized, nothing to render into
+      Hidden,
+    };
+    // Game thread only, the window's atomics are the source of truth
+    PowerState power_state_{ PowerState::Foreground };
+    // Cuts a background throttle short the moment the window comes back
+    std::mutex power_mutex_;
+    std::condition_variable power_cv_;
     
     // Main Thread events
-    Event<const Time&> main_awake_event_;
-    Event<const Time&> main_start_event_;
-    Event<const Time&> main_poll_event_;
-    Event<const Time&> main_update_event_;
-    Event<const Time&> main_stop_event_;
+    StageEvent<const Time&> main_awake_event_;
+    StageEvent<const Time&> main_start_event_;
+    StageEvent<const Time&> main_poll_event_;
+    StageEvent<const Time&> main_update_event_;
+    StageEvent<const Time&> main_stop_event_;
     // Game Thread events
-    Event<App&, const Time&> awake_event_;
-    Event<App&, const Time&> start_event_;
-    Event<App&, const Time&> early_tick_event_;
-    Event<App&, const Time&> tick_event_;
-    Event<App&, const Time&> late_tick_event_;
-    Event<App&, const Time&> early_update_event_;
-    Event<App&, const Time&> update_event_;
-    Event<App&, const Time&> late_update_event_;
-    Event<App&, const Time&> stop_event_;
-    Event<App&, const Time&> asleep_event_;
-    
-    Event<App&, const Time&> reserved_event_;
+    StageEvent<App&, const Time&> awake_event_;
+    StageEvent<App&, const Time&> start_event_;
+    StageEvent<App&, const Time&> early_tick_event_;
+    StageEvent<App&, const Time&> tick_event_;
+    StageEvent<App&, const Time&> late_tick_event_;
+    StageEvent<App&, const Time&> early_update_event_;
+    StageEvent<App&, const Time&> update_event_;
+    StageEvent<App&, const Time&> late_update_event_;
+    StageEvent<App&, const Time&> extract_event_;
+    StageEvent<App&, const Time&> stop_event_;
+    StageEvent<App&, const Time&> asleep_event_;
+    
+    StageEvent<App&, const Time&> reserved_event_;
+    // Callbacks registered as parallel, one graph per stage (created on first use)
+    std::array<unique<ParallelStage>, static_cast<std::size_t>(Stage::Asleep) + 1> parallel_stages_{};
     
   private:
     void main_loop()
     {
+      const kitsune::ThreadCpuMeter cpu_meter{};
+      
       GameLoop{
         .start = [this](const Time& time) {
           main_awake_event_(time);
           main_start_event_(time);
         },
         .update = [this](const Time& time) { // Update
+          FOXY_PROFILE_SCOPE("Main update");
           main_poll_event_(time);
+          job_system_.run_main_thread_jobs();
           main_update_event_(time);
+          if (!window_->should_continue() && running_.load(std::memory_order_relaxed)) {
+            request_stop();
+          }
         },
         .stop = [this](const Time& time) {
           main_stop_event_(time);
         }
       }(window_->should_continue());
+      
+      const auto cpu{ cpu_meter.sample() };
+      Log::debug(
+        "Main thread ({}): {:.1f}ms CPU over {:.1f}ms wall | {:.1f}% of a core",
+        wait_for_events_ ? "waiting on events" : "polling", cpu.cpu_ms, cpu.wall_ms, cpu.utilization * 100.
+      );
     }
     
     void game_loop()
     {
       Log::set_thread_name("game");
+      FOXY_PROFILE_THREAD("game");
       Log::trace("Starting game thread...");
       
       try {
         GameLoop{
           .start = [this](const Time& time) {
-            awake_event_(app_, time);
-            start_event_(app_, time);
+            FOXY_PROFILE_SCOPE("Start");
+            run_stage(Stage::Awake, time);
+            run_stage(Stage::Start, time);
           },
           .tick = [this](const Time& time) { // Tick
-            early_tick_event_(app_, time);
-            tick_event_(app_, time);
-            late_tick_event_(app_, time);
+            FOXY_PROFILE_SCOPE("Tick");
+            {
+              FOXY_PROFILE_SCOPE("EarlyTick");
+              // A fixed step can tick several times per update, only the first tick drains so the rest (and
+              // Update) still see its edges and deltas
+              if (!low_latency_ && !headless_ && !input_drained_) {
+                window_->drain_input(input_);
+                input_drained_ = true;
+              }
+              run_stage(Stage::EarlyTick, time);
+            }
+            {
+              FOXY_PROFILE_SCOPE("Tick stage");
+              run_stage(Stage::Tick, time);
+            }
+            {
+              FOXY_PROFILE_SCOPE("LateTick");
+              run_stage(Stage::LateTick, time);
+            }
           },
           .update = [this](const Time& time) { // Update
-            early_update_event_(app_, time);
-            update_event_(app_, time);
-            late_update_event_(app_, time);
-            render_engine_->draw_frame();
+            if (!low_latency_ && !headless_ && !std::exchange(input_drained_, false)) {
+              // No tick this time around
+              window_->drain_input(input_);
+            }
+            if (headless_) {
+              // The calling thread doubles as the main thread
+              job_system_.run_main_thread_jobs();
+            }
+            game_running_ = running_.load(std::memory_order_relaxed);
+            update_power_state();
+            const bool render{
+              !headless_ && (
+                power_state_ == PowerState::Foreground
+                  || (power_state_ == PowerState::Background && power_policy_.render_when_unfocused)
+              )
+            };
+            if (render && !frame_pipeline_.begin_simulation()) {
+              return;
+            }
+            if (low_latency_ && !headless_) {
+              if (render) {
+                FOXY_PROFILE_SCOPE("Frame limiter");
+                frame_limiter_.wait();
+              }
+              window_->drain_input(input_);
+            }
+            FOXY_PROFILE_SCOPE("Update");
+            // Finished loads become visible (and get uploaded) before anything this frame looks at them
+            assets_.update();
+            {
+              FOXY_PROFILE_SCOPE("EarlyUpdate");
+              run_stage(Stage::EarlyUpdate, time);
+            }
+            {
+              FOXY_PROFILE_SCOPE("Update stage");
+              run_stage(Stage::Update, time);
+            }
+            {
+              FOXY_PROFILE_SCOPE("LateUpdate");
+              run_stage(Stage::LateUpdate, time);
+            }
+            if (render) {
+              {
+                FOXY_PROFILE_SCOPE("Extract");
+                auto& world{ render_world() };
+                world.clear();
+                world.set_frame(extract_frame_);
+                run_stage(Stage::Extract, time);
+              }
+              ++extract_frame_;
+              frame_pipeline_.publish();
+            }
+            if (power_state_ != PowerState::Foreground) {
+              throttle_background();
+            }
+            if (headless_) {
+              FOXY_PROFILE_SCOPE("Frame limiter");
+              frame_limiter_.wait();
+            }
+            // Every stage (and the jobs they started) has finished, so nothing can still hold frame memory
+            FrameArena::advance_frame();
           },
           .stop = [this](const Time& time) {
-            render_engine_->wait_idle();
-            stop_event_(app_, time);
-            asleep_event_(app_, time);
+            FOXY_PROFILE_SCOPE("Stop");
+            // Let the render thread drain whatever was already published before anything gets torn down
+            frame_pipeline_.stop();
+            if (render_thread_.joinable()) {
+              render_thread_.join();
+            }
+            run_stage(Stage::Stop, time);
+            run_stage(Stage::Asleep, time);
+            // The main thread may be asleep waiting for events, make sure it notices we're done
+            if (!headless_) {
+              window_->wake();
+            }
           }
-        }(window_->should_continue());
+        }(should_continue());
       } catch (const std::exception& e) {
         Log::error(e.what());
+        // Otherwise the render thread waits forever for the next frame, and the main thread for the window to close
+        frame_pipeline_.stop();
+        stop();
       }
       
       Log::trace("Joining game thread into main thread...");
     }
     
-    void awake(App& app, const Time& time)
+    void resume_stage_waiters(const Stage stage)
     {
-    
+      {
+        std::scoped_lock lock{ stage_waiters_mutex_ };
+        // Tasks that wait for this stage again while resuming land in the fresh list and run next time around
+        std::swap(resuming_, stage_waiters_[static_cast<std::size_t>(stage)]);
+      }
+      for (const auto handle: resuming_) {
+        handle.resume();
+      }
+      resuming_.clear();
     }
     
-    void start(App& app, const Time& time)
+    // Game thread only
+    [[nodiscard]] auto should_continue() const -> const bool&
     {
-    
+      return game_running_;
     }
     
-    void early_tick(App& app, const Time& time)
+    // Wakes the game thread if it's throttled, otherwise it notices on its next update
+    void request_stop()
     {
-    
+      {
+        std::scoped_lock lock{ power_mutex_ };
+        running_.store(false, std::memory_order_relaxed);
+      }
+      power_cv_.notify_all();
     }
     
-    void tick(App& app, const Time& time)
+    // Loose files under res/ first, then every archive next to them on top of those (res/foxy.pak shows up as
+    // res/foxy), so packed resources win over stale loose copies
+    [[nodiscard]] static auto mount_resources() -> unique<Vfs>
     {
-    
+      namespace fs = std::filesystem;
+      auto vfs{ std::make_unique<Vfs>() };
+      const fs::path root{ "res" };
+      if (!is_directory(root)) {
+        Log::warn("No resource directory at {}", absolute(root).string());
+        return vfs;
+      }
+      
+      vfs->mount_directory(root, root);
+      for (const auto& item: fs::directory_iterator{ root }) {
+        if (item.is_regular_file() && item.path().extension() == ".pak") {
+          vfs->mount_archive(item.path(), root / item.path().stem());
+        }
+      }
+      return vfs;
     }
     
-    void late_tick(App& app, const Time& time)
+    [[nodiscard]] static auto worker_count(const CreateInfo& create_info) -> u32
     {
-    
+      if (create_info.worker_count != 0) {
+        return create_info.worker_count;
+      }
+      return create_info.headless ? 1 : JobSystem::default_worker_count();
     }
     
-    void early_update(App& app, const Time& time)
+    void log_frame_arena_stats() const
     {
+      const auto arenas{ FrameArena::stats() };
+      Log::debug(
+        "Frame arenas: {} threads | {} KiB last frame, {} KiB peak on one thread, {} KiB reserved",
+        arenas.threads, arenas.last_frame_bytes / 1024, arenas.peak_frame_bytes / 1024, arenas.reserved_bytes / 1024
+      );
+    }
     
+    void log_asset_stats() const
+    {
+      const auto assets{ assets_.stats() };
+      Log::debug(
+        "Assets: {} loaded, {} failed, {} cache hits, {} evicted | {} resident ({} KiB) | latency mean {:.3f}ms, max {:.3f}ms",
+        assets.loads_completed, assets.loads_failed, assets.cache_hits, assets.evictions,
+        assets.resident, assets.resident_bytes / 1024, assets.mean_latency_ms, assets.max_latency_ms
+      );
     }
     
-    void update(App& app, const Time& time)
+    void log_pacing_stats() const
     {
-      #if defined(FOXY_PERF_TITLE)
-      show_perf_stats(time);
-      #endif
+      const auto pacing{ frame_limiter_.stats() };
+      Log::debug(
+        "Frame pacing ({}): {:.3f}ms mean, {:.3f}ms stddev, {:.3f}-{:.3f}ms | {:.1f}us from deadline, {:.0f}us spin margin",
+        headless_ ? "headless" : low_latency_ ? "low latency" : "after present", pacing.mean_ms, pacing.stddev_ms,
+        pacing.min_ms, pacing.max_ms, pacing.mean_error_us, pacing.spin_margin_us
+      );
     }
     
-    void late_update(App& app, const Time& time)
+    [[nodiscard]] auto current_power_state() const -> PowerState
     {
+      if (headless_) {
+        return PowerState::Foreground;
+      }
+      if (window_->hidden() || window_->minimized()) {
+        return PowerState::Hidden;
+      }
+      if (power_policy_.throttle_when_unfocused && !window_->focused()) {
+        return PowerState::Background;
+      }
+      return PowerState::Foreground;
+    }
     
+    void update_power_state()
+    {
+      const auto state{ current_power_state() };
+      if (state == power_state_) {
+        return;
+      }
+      
+      if (state == PowerState::Foreground) {
+        Log::trace("Entering foreground, resuming full rate...");
+        job_system_.set_active_workers(job_system_.worker_count());
+      } else if (power_state_ == PowerState::Foreground) {
+        Log::trace("Entering background, throttling...");
+        job_system_.set_active_workers(power_policy_.background_workers);
+      }
+      power_state_ = state;
     }
     
-    void stop(App& app, const Time& time)
+    // Sleeps out the rest of a background update period, or until the window comes back
+    void throttle_background()
     {
+      if (power_policy_.background_update_rate <= 0.) {
+        return;
+      }
+      
+      FOXY_PROFILE_SCOPE("Background throttle");
+      const std::chrono::duration<double> period{ 1. / power_policy_.background_update_rate };
+      std::unique_lock lock{ power_mutex_ };
+      power_cv_.wait_for(lock, period, [this] {
+        return current_power_state() != power_state_ || !running_.load(std::memory_order_relaxed);
+      });
+    }
     
+    // Tasks waiting on the stage resume first, then the serial callbacks on the game thread, then the parallel
+    // ones as jobs, then the stage barrier
+    void run_stage(const Stage stage, const Time& time)
+    {
+      resume_stage_waiters(stage);
+      stage_callback(stage)(app_, time);
+      if (const auto& parallel_stage{ parallel_stages_[static_cast<std::size_t>(stage)] }) {
+        (*parallel_stage)(app_, time);
+      }
     }
     
-    void asleep(App& app, const Time& time)
+    void render_loop()
     {
+      Log::set_thread_name("render");
+      FOXY_PROFILE_THREAD("render");
+      Log::trace("Starting render thread...");
+      
+      try {
+        while (const auto frame{ frame_pipeline_.acquire_render() }) {
+          FOXY_PROFILE_SCOPE("Render frame");
+          render_engine_->draw_frame(render_worlds_[*frame % render_worlds_.size()]);
+          frame_pipeline_.release_render();
+          if (!low_latency_) {
+            FOXY_PROFILE_SCOPE("Frame limiter");
+            frame_limiter_.wait();
+          }
+        }
+        render_engine_->wait_idle();
+      } catch (const std::exception& e) {
+        Log::error(e.what());
+        frame_pipeline_.stop();
+      }
+      
+      Log::trace("Joining render thread into main thread...");
+    }
     
+    void update(App& app, const Time& time)
+    {
+      #if defined(FOXY_PERF_TITLE)
+      show_perf_stats(time);
+      #endif
     }
     
     void set_callbacks()
     {
-      main_poll_event_.add_callback([this](const Time& time){ window_->poll_events(); });
-      
-      awake_event_.add_callback(FOXY_LAMBDA(awake));
-      start_event_.add_callback(FOXY_LAMBDA(start));
-      
-      early_tick_event_.add_callback(FOXY_LAMBDA(early_tick));
-      tick_event_.add_callback(FOXY_LAMBDA(tick));
-      late_tick_event_.add_callback(FOXY_LAMBDA(late_tick));
+      if (headless_) {
+        // No main loop to hang these off, so the game thread takes care of them
+        #if defined(FOXY_PROFILING)
+        update_event_.add_callback([this](App& app, const Time& time) { flush_profiler(time); });
+        #endif
+        return;
+      }
       
-      early_update_event_.add_callback(FOXY_LAMBDA(early_update));
-      update_event_.add_callback(FOXY_LAMBDA(update));
-      late_update_event_.add_callback(FOXY_LAMBDA(late_update));
+      // GLFW calls from other threads get routed through the main thread queue, which needs to interrupt event waits
+      job_system_.set_main_thread_notifier([this] { window_->wake(); });
+      if (wait_for_events_) {
+        main_poll_event_.add_callback([this](const Time& time){ window_->wait_events(event_wait_timeout_); });
+      } else {
+        main_poll_event_.add_callback([this](const Time& time){ window_->poll_events(); });
+      }
+      // Main thread, fires on focus/minimize/hide changes
+      window_->add_visibility_callback([this] {
+        { std::scoped_lock lock{ power_mutex_ }; }
+        power_cv_.notify_all();
+      });
+      #if defined(FOXY_PROFILING)
+      main_update_event_.add_callback(FOXY_LAMBDA(flush_profiler));
+      #endif
       
-      stop_event_.add_callback(FOXY_LAMBDA(stop));
-      asleep_event_.add_callback(FOXY_LAMBDA(asleep));
+      // Only stages with real work get a callback, an empty stage dispatches nothing
+      #if defined(FOXY_PERF_TITLE)
+      update_event_.add_callback(StageCallback::bind<&Impl::update>(*this));
+      #endif
     }
     
     void show_perf_stats(const Time& time)
@@ -253,15 +694,45 @@ namespace fx {
                    << std::fixed << std::setfill(' ') << std::setw(12) << std::setprecision(9)
                    << frame_time << "s | % of target frametime ceiling: "
                    << std::defaultfloat << std::setfill(' ') << std::setw(9) << std::setprecision(4)
-                   << (frame_time / frame_time_goal_) * 100. << '%';
+                   << (frame_time / frame_time_goal()) * 100. << '%';
+        
+        const auto pacing{ frame_limiter_.stats() };
+        perf_stats << " | pacing: "
+                   << std::fixed << std::setprecision(3) << pacing.mean_ms << "ms +/- " << pacing.stddev_ms << "ms";
+        perf_stats << " | frame arena: " << FrameArena::stats().last_frame_bytes / 1024 << "KiB";
+        
+        // GPU scopes lag a couple of frames behind, which is fine for a title bar readout
+        if (const auto stats{ render_engine_->frame_stats() }; !stats.gpu_scopes.empty()) {
+          perf_stats << " | gpu: "
+                     << std::fixed << std::setprecision(3) << stats.gpu_scopes.front().gpu_time_ms << "ms";
+        }
+        perf_stats << " | sim/render overlap: "
+                   << std::fixed << std::setprecision(2) << frame_pipeline_.stats().concurrency << 'x';
   
         // Log::info("PERF STATS | {}", perf_stats.str());
-        window_->set_subtitle(perf_stats.str());
+        // GLFW window calls are main thread only
+        job_system_.submit_to_main_thread([this, subtitle = perf_stats.str()] { window_->set_subtitle(subtitle); });
+        timer = 0;
+      }
+    }
+    
+    [[nodiscard]] auto frame_time_goal() const -> double
+    {
+      const auto target{ frame_limiter_.target_frame_time() };
+      return target > 0. ? target : frame_time_goal_;
+    }
+    
+    void flush_profiler(const Time& time)
+    {
+      // Often enough that the per-thread rings never fill up, rarely enough to stay out of the way
+      static double timer{ 0 };
+      if (0.5 <= (timer += time.delta<secs>())) {
+        FOXY_PROFILE_FLUSH();
         timer = 0;
       }
     }
     
-    [[nodiscard]] constexpr auto stage_callback(const Stage stage) -> Event<App&, const Time&>&
+    [[nodiscard]] constexpr auto stage_callback(const Stage stage) -> StageEvent<App&, const Time&>&
     {
       switch (stage) {
         case Stage::Awake:
@@ -280,6 +751,8 @@ namespace fx {
           return update_event_;
         case Stage::LateUpdate:
           return late_update_event_;
+        case Stage::Extract:
+          return extract_event_;
         case Stage::Stop:
           return stop_event_;
         case Stage::Asleep:
@@ -312,16 +785,83 @@ namespace fx {
     return *this;
   }
   
+  auto App::add_function_to_stage(const Stage stage, StageCallback&& callback, StageCallbackInfo&& info) -> App&
+  {
+    p_impl_->add_function_to_stage(stage, std::forward<StageCallback>(callback), std::move(info));
+    return *this;
+  }
+  
+  auto App::spawn(Task<>&& task) -> App&
+  {
+    p_impl_->spawn(std::move(task));
+    return *this;
+  }
+  
+  auto App::next(const Stage stage) -> StageAwaiter
+  {
+    return StageAwaiter{ .app = *this, .stage = stage };
+  }
+  
+  void App::StageAwaiter::await_suspend(const std::coroutine_handle<> handle)
+  {
+    app.p_impl_->add_stage_waiter(stage, handle);
+  }
+  
   auto App::user_data_ptr() -> shared<void>
   {
     return p_impl_->user_data();
   }
   
+  auto App::render_world() -> RenderWorld&
+  {
+    return p_impl_->render_world();
+  }
+  
+  auto App::input() const -> const InputState&
+  {
+    return p_impl_->input();
+  }
+  
+  auto App::frame_arena() -> FrameArena&
+  {
+    return FrameArena::local();
+  }
+  
+  auto App::job_system() -> JobSystem&
+  {
+    return p_impl_->job_system();
+  }
+  
+  auto App::io() -> AsyncIO&
+  {
+    return p_impl_->io();
+  }
+  
+  auto App::vfs() -> Vfs&
+  {
+    return p_impl_->vfs();
+  }
+  
+  auto App::assets() -> AssetManager&
+  {
+    return p_impl_->assets();
+  }
+  
   void App::run()
   {
     p_impl_->run();
   }
   
+  void App::stop()
+  {
+    p_impl_->stop();
+  }
+  
+  auto App::headless() const -> bool
+  {
+    return p_impl_->headless();
+  }
+  
   auto App::operator()() -> void
   {
     return p_impl_->run();
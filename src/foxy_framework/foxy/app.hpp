@@ -4,9 +4,33 @@
 
 #pragma once
 
+#include "foxy/delegate.hpp"
+
 namespace fx {
+  class RenderWorld;
+  class InputState;
+  class FrameArena;
+  class JobSystem;
+  class AsyncIO;
+  class Vfs;
+  class AssetManager;
+  template<class T>
+  class Task;
+  
   class App {
   public:
+    // What the app does while it's in the background: hidden, minimized, or (optionally) unfocused
+    struct PowerPolicy {
+      // Game thread updates per second in the background, 0 leaves the update rate alone
+      double background_update_rate{ 10. };
+      // Treat losing focus like being minimized, not just hidden/minimized windows
+      bool throttle_when_unfocused{ true };
+      // Keep rendering while visible but unfocused. Hidden and minimized windows never render.
+      bool render_when_unfocused{ false };
+      // Job system workers left awake in the background, the rest are parked until the app comes back
+      u32 background_workers{ 1 };
+    };
+    
     struct CreateInfo {
       int argc{ 0 };
       char** argv{ nullptr };
@@ -16,6 +40,32 @@ namespace fx {
       bool vsync{ true };
       bool fullscreen{ false };
       bool borderless{ false };
+      // How many frames the game thread may simulate ahead of the frame being rendered (0 = no overlap)
+      u32 max_frames_ahead{ 1 };
+      // Main thread sleeps until an OS event arrives instead of polling in a loop. Off busy-polls, which
+      // keeps a core pinned but is handy for comparing main thread CPU time.
+      bool wait_for_events{ true };
+      // Frames per second to pace to, 0 for unlimited
+      double target_frame_rate{ 0. };
+      // Pace the game thread right before input is sampled instead of the render thread after present, so each
+      // frame simulates the freshest input possible. Pairs best with max_frames_ahead = 0.
+      bool low_latency{ false };
+      // Simulation only: no window, no renderer, no GLFW or Vulkan at all (dedicated servers, batch sims). The game
+      // loop runs on the thread that calls run(), at target_frame_rate or as fast as possible when that's 0.
+      bool headless{ false };
+      // Job system workers, 0 picks a default: all but three hardware threads, or just one when headless so
+      // that many instances can share a machine
+      u32 worker_count{ 0 };
+      // Workers allowed to run background jobs at once, 0 for all but one
+      u32 background_workers{ 0 };
+      // Pin workers to cpus spread across physical cores and caches, leaving the first few for the main, game,
+      // and render threads. Best on dedicated many-core machines, unpinned lets the OS juggle shared ones.
+      bool pin_workers{ false };
+      PowerPolicy power_policy{};
+      // Unreferenced assets get evicted (least recently used first) while more than this is resident
+      u64 asset_memory_budget{ 256 * 1024 * 1024 };
+      // Asset upload steps run per frame, so a burst of loads is spread over several frames
+      u32 asset_uploads_per_frame{ 4 };
     };
 
     enum class Stage {
@@ -27,21 +77,73 @@ namespace fx {
       EarlyUpdate,
       Update,
       LateUpdate,
+      // Copies render-relevant state into App::render_world() once simulation for the frame is done
+      Extract,
       Stop,
       Asleep,
     };
 
-    using StageCallback = std::function<void(App&, const Time&)>;
+    // co_await app.next(Stage::Update) resumes the coroutine on the game thread the next time that stage runs,
+    // before any of the stage's callbacks
+    struct StageAwaiter {
+      App& app;
+      Stage stage;
+
+      [[nodiscard]] auto await_ready() const noexcept -> bool { return false; }
+      void await_suspend(std::coroutine_handle<> handle);
+      void await_resume() const noexcept {}
+    };
+
+    // Callables must fit the delegate's inline buffer (a captured this or a few references), nothing is heap allocated
+    using StageCallback = Delegate<void(App&, const Time&)>;
 
     explicit App(CreateInfo&& create_info);
     ~App();
 
     auto set_user_data_ptr(shared<void> data) -> App&;
+    struct StageCallbackInfo {
+      std::string name{};
+      // Run as a job alongside the stage's other parallel callbacks instead of in order on the game thread.
+      // Parallel callbacks start after the stage's serial ones, and the stage waits for all of them to finish.
+      bool parallel{ false };
+      // Names of parallel callbacks in the same stage that this one must run after/before
+      std::vector<std::string> after{};
+      std::vector<std::string> before{};
+    };
+
     auto add_function_to_stage(Stage stage, StageCallback&& callback) -> App&;
+    auto add_function_to_stage(Stage stage, StageCallback&& callback, StageCallbackInfo&& info) -> App&;
+    // Callbacks fixed at compile time, registered as a single stage callback that calls each of them directly:
+    // app.add_baked_to_stage<&physics_step, &animate>(Stage::Tick)
+    template<auto... Callbacks>
+    auto add_baked_to_stage(const Stage stage) -> App&
+    {
+      return add_function_to_stage(stage, BakedEvent<Callbacks...>::template delegate<App&, const Time&>());
+    }
+    // Starts a fire-and-forget coroutine on the calling thread. The app owns it until it finishes.
+    auto spawn(Task<void>&& task) -> App&;
+    [[nodiscard]] auto next(Stage stage) -> StageAwaiter;
     
     [[nodiscard]] auto user_data_ptr() -> shared<void>;
+    // The world being extracted into. Only valid inside Extract stage callbacks.
+    [[nodiscard]] auto render_world() -> RenderWorld&;
+    // Input snapshot, refreshed once per update: before the first EarlyTick since the last update (or before
+    // EarlyUpdate if there was no tick, and always there in low latency mode). Game thread only.
+    [[nodiscard]] auto input() const -> const InputState&;
+    // The calling thread's scratch memory for this frame, usable as a std::pmr resource. Rewound every frame.
+    [[nodiscard]] auto frame_arena() -> FrameArena&;
+    [[nodiscard]] auto job_system() -> JobSystem&;
+    // Async file reads, completions run as jobs
+    [[nodiscard]] auto io() -> AsyncIO&;
+    // Everything under res/, packed archives included. Thread safe.
+    [[nodiscard]] auto vfs() -> Vfs&;
+    // Background asset loading, register loaders during Awake/Start. Uploads run on the game thread before EarlyUpdate.
+    [[nodiscard]] auto assets() -> AssetManager&;
   
     void run();
+    // Asks the app to finish its current frame and shut down. Safe to call from any thread.
+    void stop();
+    [[nodiscard]] auto headless() const -> bool;
   
     auto operator()() -> void;
     
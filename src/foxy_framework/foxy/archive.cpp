@@ -0,0 +1,428 @@
+#include "archive.hpp"
+
+#include "lz4.hpp"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fx {
+  static_assert(std::endian::native == std::endian::little, "Archives are stored little endian");
+
+  namespace archive {
+    auto normalize_path(const std::filesystem::path& path) -> std::string
+    {
+      auto normalized{ path.lexically_normal().generic_string() };
+      while (normalized.starts_with("./")) {
+        normalized.erase(0, 2);
+      }
+      if (normalized == ".") {
+        normalized.clear();
+      }
+      while (normalized.ends_with('/')) {
+        normalized.pop_back();
+      }
+      return normalized;
+    }
+
+    auto hash_path(const std::string_view normalized_path) -> u64
+    {
+      // FNV-1a
+      u64 hash{ 14695981039346656037ULL };
+      for (const auto c: normalized_path) {
+        hash ^= static_cast<u8>(c);
+        hash *= 1099511628211ULL;
+      }
+      return hash;
+    }
+  }
+
+  class Archive::Impl {
+  public:
+    explicit Impl(std::filesystem::path path):
+      path_{ std::move(path) } {}
+
+    ~Impl()
+    {
+      #if defined(_WIN32)
+      if (bytes_.data()) {
+        UnmapViewOfFile(bytes_.data());
+      }
+      if (mapping_) {
+        CloseHandle(mapping_);
+      }
+      if (file_ != INVALID_HANDLE_VALUE) {
+        CloseHandle(file_);
+      }
+      #else
+      if (bytes_.data()) {
+        munmap(const_cast<std::byte*>(bytes_.data()), bytes_.size());
+      }
+      #endif
+    }
+
+    [[nodiscard]] auto map() -> bool
+    {
+      #if defined(_WIN32)
+      file_ = CreateFileW(
+        path_.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr
+      );
+      if (file_ == INVALID_HANDLE_VALUE) {
+        return false;
+      }
+      LARGE_INTEGER size{};
+      if (!GetFileSizeEx(file_, &size) || size.QuadPart == 0) {
+        return false;
+      }
+      mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (!mapping_) {
+        return false;
+      }
+      const auto* data{ MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0) };
+      if (!data) {
+        return false;
+      }
+      bytes_ = { static_cast<const std::byte*>(data), static_cast<std::size_t>(size.QuadPart) };
+      #else
+      const auto fd{ ::open(path_.c_str(), O_RDONLY | O_CLOEXEC) };
+      if (fd < 0) {
+        return false;
+      }
+      struct stat info{};
+      if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return false;
+      }
+      // The mapping keeps the file alive on its own
+      auto* data{ mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0) };
+      close(fd);
+      if (data == MAP_FAILED) {
+        return false;
+      }
+      bytes_ = { static_cast<const std::byte*>(data), static_cast<std::size_t>(info.st_size) };
+      #endif
+      return true;
+    }
+
+    // Everything is bounds checked once here so lookups can trust the index afterwards
+    [[nodiscard]] auto validate() -> bool
+    {
+      if (bytes_.size() < sizeof(archive::Header)) {
+        return false;
+      }
+      archive::Header header{};
+      std::memcpy(&header, bytes_.data(), sizeof(header));
+      if (header.magic != archive::magic || header.version != archive::version) {
+        return false;
+      }
+
+      const auto index_size{ static_cast<u64>(header.entry_count) * sizeof(archive::Entry) };
+      if (header.index_offset % alignof(archive::Entry) != 0 || !in_bounds(header.index_offset, index_size) ||
+          !in_bounds(header.strings_offset, header.strings_size)) {
+        return false;
+      }
+      entries_ = {
+        reinterpret_cast<const archive::Entry*>(bytes_.data() + header.index_offset),
+        static_cast<std::size_t>(header.entry_count)
+      };
+      strings_ = {
+        reinterpret_cast<const char*>(bytes_.data() + header.strings_offset),
+        static_cast<std::size_t>(header.strings_size)
+      };
+
+      for (u64 previous_hash{ 0 }; const auto& entry: entries_) {
+        if (!in_bounds(entry.offset, entry.stored_size) ||
+            static_cast<u64>(entry.path_offset) + entry.path_size > strings_.size() ||
+            entry.hash < previous_hash || entry.hash != archive::hash_path(path(entry)) ||
+            (entry.compression == archive::Compression::None && entry.stored_size != entry.size) ||
+            entry.compression > archive::Compression::Lz4) {
+          return false;
+        }
+        previous_hash = entry.hash;
+      }
+      return true;
+    }
+
+    [[nodiscard]] auto find(const std::string_view path) const -> const archive::Entry*
+    {
+      const auto hash{ archive::hash_path(path) };
+      auto it{ std::ranges::lower_bound(entries_, hash, {}, &archive::Entry::hash) };
+      for (; it != entries_.end() && it->hash == hash; ++it) {
+        if (this->path(*it) == path) {
+          return &*it;
+        }
+      }
+      return nullptr;
+    }
+
+    [[nodiscard]] auto stored(const archive::Entry& entry) const -> std::span<const std::byte>
+    {
+      return bytes_.subspan(static_cast<std::size_t>(entry.offset), static_cast<std::size_t>(entry.stored_size));
+    }
+
+    [[nodiscard]] auto extract(const archive::Entry& entry, std::vector<std::byte>& out) const -> bool
+    {
+      const auto data{ stored(entry) };
+      switch (entry.compression) {
+        case archive::Compression::None: {
+          out.assign(data.begin(), data.end());
+          return true;
+        }
+        case archive::Compression::Lz4: {
+          out.resize(static_cast<std::size_t>(entry.size));
+          if (!lz4::decompress(data, out)) {
+            Log::error("Archive entry {} in {} is corrupt", path(entry), path_.string());
+            return false;
+          }
+          return true;
+        }
+        default: return false;  // NOLINT(clang-diagnostic-covered-switch-default)
+      }
+    }
+
+    [[nodiscard]] auto entries() const -> std::span<const archive::Entry>
+    {
+      return entries_;
+    }
+
+    [[nodiscard]] auto path(const archive::Entry& entry) const -> std::string_view
+    {
+      return strings_.substr(entry.path_offset, entry.path_size);
+    }
+
+  private:
+    std::filesystem::path path_;
+    std::span<const std::byte> bytes_{};
+    std::span<const archive::Entry> entries_{};
+    std::string_view strings_{};
+    #if defined(_WIN32)
+    HANDLE file_{ INVALID_HANDLE_VALUE };
+    HANDLE mapping_{ nullptr };
+    #endif
+
+    [[nodiscard]] auto in_bounds(const u64 offset, const u64 size) const -> bool
+    {
+      return offset <= bytes_.size() && size <= bytes_.size() - offset;
+    }
+  };
+
+  class ArchiveWriter::Impl {
+  public:
+    explicit Impl(const CreateInfo& create_info):
+      create_info_{ create_info } {}
+
+    void add(const std::filesystem::path& archive_path, std::vector<std::byte>&& bytes)
+    {
+      files_.insert_or_assign(archive::normalize_path(archive_path), std::move(bytes));
+    }
+
+    auto add_directory(const std::filesystem::path& directory, const std::filesystem::path& prefix) -> u32
+    {
+      namespace fs = std::filesystem;
+      u32 count{ 0 };
+      for (const auto& item: fs::recursive_directory_iterator{ directory }) {
+        if (!item.is_regular_file()) {
+          continue;
+        }
+        std::ifstream file{ item.path(), std::ios::binary };
+        std::vector<std::byte> bytes(static_cast<std::size_t>(item.file_size()));
+        if (!file.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()))) {
+          Log::error("Failed to read {}", item.path().string());
+          continue;
+        }
+        add(prefix / item.path().lexically_relative(directory), std::move(bytes));
+        ++count;
+      }
+      return count;
+    }
+
+    [[nodiscard]] auto write(const std::filesystem::path& path) const -> bool
+    {
+      struct Packed {
+        archive::Entry entry{};
+        std::span<const std::byte> data{};
+        std::vector<std::byte> compressed{};
+      };
+
+      std::vector<Packed> packed;
+      packed.reserve(files_.size());
+      std::string strings;
+      u64 raw_bytes{ 0 };
+      for (const auto& [file_path, bytes]: files_) {
+        auto& item{ packed.emplace_back() };
+        item.entry = archive::Entry{
+          .hash = archive::hash_path(file_path),
+          .size = bytes.size(),
+          .path_offset = static_cast<u32>(strings.size()),
+          .path_size = static_cast<u32>(file_path.size()),
+          .compression = archive::Compression::None,
+        };
+        item.data = bytes;
+        strings += file_path;
+        raw_bytes += bytes.size();
+
+        if (create_info_.compress && !bytes.empty()) {
+          auto compressed{ lz4::compress(bytes) };
+          const auto limit{ static_cast<double>(bytes.size()) * (1. - create_info_.min_savings) };
+          if (static_cast<double>(compressed.size()) <= limit) {
+            item.compressed = std::move(compressed);
+            item.data = item.compressed;
+            item.entry.compression = archive::Compression::Lz4;
+          }
+        }
+        item.entry.stored_size = item.data.size();
+      }
+      std::ranges::sort(packed, [&](const Packed& a, const Packed& b) {
+        return a.entry.hash != b.entry.hash ? a.entry.hash < b.entry.hash : a.entry.path_offset < b.entry.path_offset;
+      });
+
+      const u64 alignment{ std::bit_ceil(std::max(create_info_.alignment, 1U)) };
+      const auto align{ [alignment](const u64 offset) { return (offset + alignment - 1) & ~(alignment - 1); } };
+      const archive::Header header{
+        .magic = archive::magic,
+        .version = archive::version,
+        .entry_count = static_cast<u32>(packed.size()),
+        .alignment = static_cast<u32>(alignment),
+        .index_offset = sizeof(archive::Header),
+        .strings_offset = sizeof(archive::Header) + packed.size() * sizeof(archive::Entry),
+        .strings_size = strings.size(),
+      };
+      auto offset{ header.strings_offset + header.strings_size };
+      for (auto& item: packed) {
+        offset = align(offset);
+        item.entry.offset = offset;
+        offset += item.entry.stored_size;
+      }
+
+      // Written next to the target and swapped in, so a running app never maps a half written archive
+      auto temp_path{ path };
+      temp_path += ".tmp";
+      {
+        std::ofstream file{ temp_path, std::ios::binary | std::ios::trunc };
+        if (!file) {
+          Log::error("Failed to open {} for writing", temp_path.string());
+          return false;
+        }
+        const auto write_bytes{ [&file](const void* data, const std::size_t size) {
+          file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        } };
+        write_bytes(&header, sizeof(header));
+        for (const auto& item: packed) {
+          write_bytes(&item.entry, sizeof(item.entry));
+        }
+        write_bytes(strings.data(), strings.size());
+        // Gaps can be as large as the alignment, which may be bigger than the zero block
+        const std::array<char, 4096> padding{};
+        for (const auto& item: packed) {
+          for (auto gap{ item.entry.offset - static_cast<u64>(file.tellp()) }; gap > 0 && file;) {
+            const auto size{ std::min<u64>(gap, padding.size()) };
+            write_bytes(padding.data(), static_cast<std::size_t>(size));
+            gap -= size;
+          }
+          write_bytes(item.data.data(), item.data.size());
+        }
+        if (!file) {
+          Log::error("Failed to write {}", temp_path.string());
+          return false;
+        }
+      }
+
+      std::error_code error;
+      std::filesystem::rename(temp_path, path, error);
+      if (error) {
+        Log::error("Failed to move {} into place: {}", path.string(), error.message());
+        return false;
+      }
+
+      Log::info(
+        "Packed {} files into {} ({} bytes, {} uncompressed)",
+        packed.size(), path.string(), offset, raw_bytes
+      );
+      return true;
+    }
+
+  private:
+    const CreateInfo create_info_;
+    // Sorted by path, so the same inputs always produce the same archive
+    std::map<std::string, std::vector<std::byte>> files_;
+  };
+
+  //
+  //  Archive
+  //
+
+  Archive::Archive(unique<Impl>&& impl):
+    p_impl_{ std::move(impl) } {}
+
+  Archive::~Archive() = default;
+
+  auto Archive::open(const std::filesystem::path& path) -> unique<Archive>
+  {
+    auto impl{ std::make_unique<Impl>(path) };
+    if (!impl->map()) {
+      Log::error("Failed to map archive {}", path.string());
+      return nullptr;
+    }
+    if (!impl->validate()) {
+      Log::error("{} is not a valid archive", path.string());
+      return nullptr;
+    }
+    Log::trace("Mapped archive {} ({} entries)", path.string(), impl->entries().size());
+    return unique<Archive>{ new Archive{ std::move(impl) } };
+  }
+
+  auto Archive::find(const std::string_view path) const -> const archive::Entry*
+  {
+    return p_impl_->find(path);
+  }
+
+  auto Archive::stored(const archive::Entry& entry) const -> std::span<const std::byte>
+  {
+    return p_impl_->stored(entry);
+  }
+
+  auto Archive::extract(const archive::Entry& entry, std::vector<std::byte>& out) const -> bool
+  {
+    return p_impl_->extract(entry, out);
+  }
+
+  auto Archive::entries() const -> std::span<const archive::Entry>
+  {
+    return p_impl_->entries();
+  }
+
+  auto Archive::path(const archive::Entry& entry) const -> std::string_view
+  {
+    return p_impl_->path(entry);
+  }
+
+  //
+  //  ArchiveWriter
+  //
+
+  ArchiveWriter::ArchiveWriter():
+    ArchiveWriter{ CreateInfo{} } {}
+
+  ArchiveWriter::ArchiveWriter(const CreateInfo& create_info):
+    p_impl_{ std::make_unique<Impl>(create_info) } {}
+
+  ArchiveWriter::~ArchiveWriter() = default;
+
+  void ArchiveWriter::add(const std::filesystem::path& archive_path, std::vector<std::byte>&& bytes)
+  {
+    p_impl_->add(archive_path, std::move(bytes));
+  }
+
+  auto ArchiveWriter::add_directory(const std::filesystem::path& directory, const std::filesystem::path& prefix) -> u32
+  {
+    return p_impl_->add_directory(directory, prefix);
+  }
+
+  auto ArchiveWriter::write(const std::filesystem::path& path) const -> bool
+  {
+    return p_impl_->write(path);
+  }
+}
@@ -0,0 +1,106 @@
+//
+// Foxy's packed resource archive (.pak): a header, an index sorted by path hash, a string table with every
+// path, then each file's data at an aligned offset. Readers map the whole archive into memory and binary
+// search the index, so an uncompressed entry is just a span into the mapping. Entries can be LZ4 compressed
+// one by one, which trades the zero-copy read for a smaller file.
+//
+// Sources:
+// https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+// http://www.isthe.com/chongo/tech/comp/fnv/
+//
+
+#pragma once
+
+namespace fx {
+  namespace archive {
+    inline constexpr u32 magic{ 0x4B505846 }; // "FXPK"
+    inline constexpr u32 version{ 1 };
+
+    enum class Compression: u32 {
+      None,
+      Lz4,
+    };
+
+    struct Header {
+      u32 magic;
+      u32 version;
+      u32 entry_count;
+      u32 alignment;
+      u64 index_offset;
+      u64 strings_offset;
+      u64 strings_size;
+    };
+
+    struct Entry {
+      u64 hash;
+      // From the start of the archive
+      u64 offset;
+      u64 stored_size;
+      u64 size;
+      // Into the string table, not null terminated
+      u32 path_offset;
+      u32 path_size;
+      Compression compression;
+      u32 reserved;
+    };
+
+    static_assert(sizeof(Header) == 40 && sizeof(Entry) == 48, "Archive layout is on disk, keep it packed");
+
+    // Archive paths are relative, forward slashed, and case sensitive
+    [[nodiscard]] auto normalize_path(const std::filesystem::path& path) -> std::string;
+    [[nodiscard]] auto hash_path(std::string_view normalized_path) -> u64;
+  }
+
+  class Archive {
+  public:
+    ~Archive();
+
+    Archive(const Archive& other) = delete;
+    auto operator=(const Archive& other) -> Archive& = delete;
+
+    // Null (and an error log) when the file can't be mapped or isn't a valid archive
+    [[nodiscard]] static auto open(const std::filesystem::path& path) -> unique<Archive>;
+
+    // Takes a normalized path, see archive::normalize_path
+    [[nodiscard]] auto find(std::string_view path) const -> const archive::Entry*;
+    // The bytes as stored, which for uncompressed entries is the file itself. Valid while the archive lives.
+    [[nodiscard]] auto stored(const archive::Entry& entry) const -> std::span<const std::byte>;
+    // Copies out (and decompresses) the entry
+    [[nodiscard]] auto extract(const archive::Entry& entry, std::vector<std::byte>& out) const -> bool;
+
+    [[nodiscard]] auto entries() const -> std::span<const archive::Entry>;
+    [[nodiscard]] auto path(const archive::Entry& entry) const -> std::string_view;
+
+  private:
+    class Impl;
+    unique<Impl> p_impl_;
+
+    explicit Archive(unique<Impl>&& impl);
+  };
+
+  // Builds archives, used by the foxy_pack tool
+  class ArchiveWriter {
+  public:
+    struct CreateInfo {
+      // Every entry starts on a multiple of this (power of two)
+      u32 alignment{ 16 };
+      bool compress{ false };
+      // Compressed entries are only kept when they save at least this fraction, otherwise stored as is
+      double min_savings{ 0.125 };
+    };
+
+    ArchiveWriter();
+    explicit ArchiveWriter(const CreateInfo& create_info);
+    ~ArchiveWriter();
+
+    // Replaces anything added earlier under the same path
+    void add(const std::filesystem::path& archive_path, std::vector<std::byte>&& bytes);
+    // Adds every file under the directory, with paths relative to it (under prefix). Returns how many.
+    auto add_directory(const std::filesystem::path& directory, const std::filesystem::path& prefix = {}) -> u32;
+    [[nodiscard]] auto write(const std::filesystem::path& path) const -> bool;
+
+  private:
+    class Impl;
+    unique<Impl> p_impl_;
+  };
+}
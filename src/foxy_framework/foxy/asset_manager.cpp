@@ -0,0 +1,455 @@
+#include "asset_manager.hpp"
+
+#include "archive.hpp"
+#include "vfs.hpp"
+#include <inu/job_system.hpp>
+#include <inu/async_io.hpp>
+#include <kitsune/profiler.hpp>
+
+namespace fx {
+  struct AssetSlot {
+    // Cleared if the manager goes away while handles still point here
+    std::atomic<AssetManager::Impl*> owner{ nullptr };
+    std::atomic<u32> references{ 0 };
+    std::atomic<AssetState> state{ AssetState::Loading };
+    // Written before state turns Ready (release), so readers that saw Ready can use it
+    shared<void> data{};
+    std::string path{};
+    std::type_index type{ typeid(void) };
+    u32 index{ 0 };
+    u64 size{ 0 };
+    std::chrono::steady_clock::time_point requested{};
+    // Set while the asset is resident with nothing referencing it
+    std::optional<std::list<u32>::iterator> lru{};
+    // On the free list. Two handles racing to drop a failed asset can both get to on_unreferenced.
+    bool free{ false };
+  };
+
+  class AssetManager::Impl {
+  public:
+    Impl(JobSystem& jobs, AsyncIO& io, const Vfs& vfs, const CreateInfo& create_info):
+      jobs_{ jobs },
+      io_{ io },
+      vfs_{ vfs },
+      create_info_{ create_info } {}
+
+    ~Impl()
+    {
+      {
+        std::unique_lock lock{ idle_mutex_ };
+        idle_.wait(lock, [this] { return in_flight_.load(std::memory_order_acquire) == 0; });
+      }
+
+      const auto referenced{ std::ranges::count_if(*slots_, [](const AssetSlot& slot) {
+        return slot.references.load(std::memory_order_relaxed) != 0;
+      }) };
+      if (referenced != 0) {
+        // Leaked on purpose so the handles stay safe to use and drop
+        Log::warn("{} assets still referenced when the asset manager was destroyed", referenced);
+        for (auto& slot: *slots_) {
+          slot.owner.store(nullptr, std::memory_order_release);
+        }
+        static_cast<void>(slots_.release());
+      }
+    }
+
+    void register_loader(const std::type_index type, ErasedLoader&& loader)
+    {
+      std::scoped_lock lock{ mutex_ };
+      loaders_.insert_or_assign(type, std::make_shared<const ErasedLoader>(std::move(loader)));
+    }
+
+    [[nodiscard]] auto load(const std::filesystem::path& path, const std::type_index type) -> AssetRef
+    {
+      auto normalized{ archive::normalize_path(path) };
+
+      std::unique_lock lock{ mutex_ };
+      if (const auto found{ by_path_.find(normalized) }; found != by_path_.end()) {
+        auto& slot{ (*slots_)[found->second] };
+        if (slot.type != type) {
+          Log::error("{} is already loaded as a different asset type", normalized);
+          return AssetRef{};
+        }
+        if (slot.references.fetch_add(1, std::memory_order_relaxed) == 0 && slot.lru) {
+          lru_.erase(*slot.lru);
+          slot.lru.reset();
+        }
+        ++cache_hits_;
+        return AssetRef{ &slot };
+      }
+
+      const auto loader{ loaders_.find(type) };
+      if (loader == loaders_.end()) {
+        Log::error("No asset loader registered for {} ({})", normalized, type.name());
+        return AssetRef{};
+      }
+
+      auto& slot{ allocate_slot() };
+      slot.owner.store(this, std::memory_order_relaxed);
+      slot.references.store(1, std::memory_order_relaxed);
+      slot.state.store(AssetState::Loading, std::memory_order_relaxed);
+      slot.path = normalized;
+      slot.type = type;
+      slot.size = 0;
+      slot.requested = std::chrono::steady_clock::now();
+      by_path_.emplace(std::move(normalized), slot.index);
+      ++loading_;
+      in_flight_.fetch_add(1, std::memory_order_relaxed);
+      lock.unlock();
+
+      start_load(slot, loader->second);
+      return AssetRef{ &slot };
+    }
+
+    // The last reference just went away
+    void on_unreferenced(AssetSlot& slot)
+    {
+      std::scoped_lock lock{ mutex_ };
+      // load() may have handed it out again in the meantime, or another handle already freed it
+      if (slot.free || slot.references.load(std::memory_order_relaxed) != 0) {
+        return;
+      }
+      switch (slot.state.load(std::memory_order_relaxed)) {
+        case AssetState::Ready: {
+          if (!slot.lru) {
+            slot.lru = lru_.insert(lru_.end(), slot.index);
+          }
+          break;
+        }
+        // Forget failures so the next load tries again
+        case AssetState::Failed: free_slot(slot); break;
+        // Lands in the LRU list once it's done
+        default: break;
+      }
+    }
+
+    void update()
+    {
+      FOXY_PROFILE_SCOPE("Asset uploads");
+      {
+        std::scoped_lock lock{ mutex_ };
+        u64 bytes{ 0 };
+        while (!upload_queue_.empty() && uploading_.size() < create_info_.uploads_per_frame) {
+          const auto size{ upload_queue_.front().slot->size };
+          if (!uploading_.empty() && bytes + size > create_info_.upload_bytes_per_frame) {
+            break;
+          }
+          bytes += size;
+          uploading_.push_back(std::move(upload_queue_.front()));
+          upload_queue_.pop_front();
+        }
+      }
+
+      for (auto& upload: uploading_) {
+        auto& slot{ *upload.slot };
+        bool uploaded{ false };
+        try {
+          uploaded = upload.loader->upload(slot.data.get());
+        } catch (const std::exception& e) {
+          Log::error("Uploading {} threw: {}", slot.path, e.what());
+        }
+        if (uploaded) {
+          finish(slot);
+        } else {
+          fail(slot, "upload failed");
+        }
+      }
+      uploading_.clear();
+
+      std::scoped_lock lock{ mutex_ };
+      evict();
+    }
+
+    [[nodiscard]] auto stats() const -> Stats
+    {
+      std::scoped_lock lock{ mutex_ };
+      return Stats{
+        .loading = loading_,
+        .upload_queue = static_cast<u32>(upload_queue_.size()),
+        .resident = resident_,
+        .resident_bytes = resident_bytes_,
+        .loads_completed = loads_completed_,
+        .loads_failed = loads_failed_,
+        .cache_hits = cache_hits_,
+        .evictions = evictions_,
+        .mean_latency_ms = loads_completed_ == 0 ? 0. : total_latency_ms_ / static_cast<double>(loads_completed_),
+        .max_latency_ms = max_latency_ms_,
+      };
+    }
+
+  private:
+    // Same hash the archive index uses, paths are normalized before they get here
+    struct PathHash {
+      [[nodiscard]] auto operator()(const std::string& path) const -> std::size_t
+      {
+        return static_cast<std::size_t>(archive::hash_path(path));
+      }
+    };
+
+    struct Upload {
+      AssetSlot* slot;
+      shared<const ErasedLoader> loader;
+    };
+
+    JobSystem& jobs_;
+    AsyncIO& io_;
+    const Vfs& vfs_;
+    const CreateInfo create_info_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::type_index, shared<const ErasedLoader>> loaders_;
+    // Deque so slots never move: handles and loads in flight point straight at them, and only index it under the lock
+    unique<std::deque<AssetSlot>> slots_{ std::make_unique<std::deque<AssetSlot>>() };
+    std::vector<u32> free_slots_;
+    std::unordered_map<std::string, u32, PathHash> by_path_;
+    // Unreferenced resident assets, least recently released at the front
+    std::list<u32> lru_;
+    std::deque<Upload> upload_queue_;
+    // Game thread only, reused every update
+    std::vector<Upload> uploading_;
+    // Reads and decodes that may still touch this manager. The last one out decrements and notifies under
+    // idle_mutex_, which the destructor waits on, so it can't notify a destroyed Impl.
+    std::atomic<u32> in_flight_{ 0 };
+    std::mutex idle_mutex_;
+    std::condition_variable idle_;
+
+    u32 loading_{ 0 };
+    u32 resident_{ 0 };
+    u64 resident_bytes_{ 0 };
+    u64 loads_completed_{ 0 };
+    u64 loads_failed_{ 0 };
+    u64 cache_hits_{ 0 };
+    u64 evictions_{ 0 };
+    double total_latency_ms_{ 0. };
+    double max_latency_ms_{ 0. };
+
+    [[nodiscard]] auto allocate_slot() -> AssetSlot&
+    {
+      if (!free_slots_.empty()) {
+        const auto index{ free_slots_.back() };
+        free_slots_.pop_back();
+        auto& slot{ (*slots_)[index] };
+        slot.free = false;
+        return slot;
+      }
+      auto& slot{ slots_->emplace_back() };
+      slot.index = static_cast<u32>(slots_->size() - 1);
+      return slot;
+    }
+
+    void free_slot(AssetSlot& slot)
+    {
+      if (slot.free) {
+        return;
+      }
+      slot.free = true;
+      by_path_.erase(slot.path);
+      slot.data.reset();
+      slot.path.clear();
+      free_slots_.push_back(slot.index);
+    }
+
+    // Archive entries are read in place on a background job, loose files go through AsyncIO so no worker blocks
+    void start_load(AssetSlot& slot, const shared<const ErasedLoader>& loader)
+    {
+      if (auto disk_path{ vfs_.disk_path(slot.path) }) {
+        io_.read(*disk_path, [this, &slot, loader](const AsyncIO::Result& result) {
+          if (result.error) {
+            fail(slot, result.error.message());
+          } else {
+            decode(slot, loader, result.data);
+          }
+          end_load();
+        });
+        return;
+      }
+
+      jobs_.submit([this, &slot, loader] {
+        if (const auto file{ vfs_.open(slot.path) }) {
+          decode(slot, loader, file->bytes());
+        } else {
+          fail(slot, "not found");
+        }
+        end_load();
+      }, nullptr, JobSystem::Priority::Background);
+    }
+
+    void end_load()
+    {
+      std::scoped_lock lock{ idle_mutex_ };
+      if (in_flight_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        idle_.notify_all();
+      }
+    }
+
+    void decode(AssetSlot& slot, const shared<const ErasedLoader>& loader, const std::span<const std::byte> bytes)
+    {
+      FOXY_PROFILE_SCOPE("Asset decode");
+      u64 size{ 0 };
+      shared<void> asset;
+      try {
+        asset = loader->decode(bytes, size);
+      } catch (const std::exception& e) {
+        Log::error("Decoding {} threw: {}", slot.path, e.what());
+      }
+      if (!asset) {
+        fail(slot, "decode failed");
+        return;
+      }
+
+      slot.data = std::move(asset);
+      slot.size = size;
+      if (!loader->upload) {
+        finish(slot);
+        return;
+      }
+
+      std::scoped_lock lock{ mutex_ };
+      --loading_;
+      slot.state.store(AssetState::Uploading, std::memory_order_release);
+      upload_queue_.push_back(Upload{ .slot = &slot, .loader = loader });
+    }
+
+    void finish(AssetSlot& slot)
+    {
+      const millisecs latency{ std::chrono::steady_clock::now() - slot.requested };
+
+      std::scoped_lock lock{ mutex_ };
+      if (slot.state.load(std::memory_order_relaxed) == AssetState::Loading) {
+        --loading_;
+      }
+      slot.state.store(AssetState::Ready, std::memory_order_release);
+      ++resident_;
+      resident_bytes_ += slot.size;
+      ++loads_completed_;
+      total_latency_ms_ += latency.count();
+      max_latency_ms_ = std::max(max_latency_ms_, latency.count());
+      if (slot.references.load(std::memory_order_relaxed) == 0) {
+        slot.lru = lru_.insert(lru_.end(), slot.index);
+      }
+    }
+
+    void fail(AssetSlot& slot, const std::string_view reason)
+    {
+      Log::error("Failed to load asset {}: {}", slot.path, reason);
+
+      std::scoped_lock lock{ mutex_ };
+      if (slot.state.load(std::memory_order_relaxed) == AssetState::Loading) {
+        --loading_;
+      }
+      slot.data.reset();
+      slot.state.store(AssetState::Failed, std::memory_order_release);
+      ++loads_failed_;
+      if (slot.references.load(std::memory_order_relaxed) == 0) {
+        free_slot(slot);
+      }
+    }
+
+    void evict()
+    {
+      while (resident_bytes_ > create_info_.memory_budget && !lru_.empty()) {
+        const auto index{ lru_.front() };
+        lru_.pop_front();
+        auto& slot{ (*slots_)[index] };
+        slot.lru.reset();
+        --resident_;
+        resident_bytes_ -= slot.size;
+        ++evictions_;
+        Log::trace("Evicted asset {} ({} KiB)", slot.path, slot.size / 1024);
+        free_slot(slot);
+      }
+    }
+  };
+
+  //
+  //  AssetRef
+  //
+
+  AssetRef::AssetRef(AssetSlot* slot):
+    slot_{ slot } {}
+
+  AssetRef::AssetRef(const AssetRef& other):
+    slot_{ other.slot_ }
+  {
+    if (slot_) {
+      slot_->references.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  AssetRef::AssetRef(AssetRef&& other) noexcept:
+    slot_{ std::exchange(other.slot_, nullptr) } {}
+
+  AssetRef::~AssetRef()
+  {
+    if (slot_ && slot_->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      if (auto* owner{ slot_->owner.load(std::memory_order_acquire) }) {
+        owner->on_unreferenced(*slot_);
+      }
+    }
+  }
+
+  auto AssetRef::operator=(const AssetRef& other) -> AssetRef&
+  {
+    if (this != &other) {
+      AssetRef copy{ other };
+      std::swap(slot_, copy.slot_);
+    }
+    return *this;
+  }
+
+  auto AssetRef::operator=(AssetRef&& other) noexcept -> AssetRef&
+  {
+    if (this != &other) {
+      AssetRef moved{ std::move(other) };
+      std::swap(slot_, moved.slot_);
+    }
+    return *this;
+  }
+
+  auto AssetRef::valid() const -> bool
+  {
+    return slot_ != nullptr;
+  }
+
+  auto AssetRef::state() const -> AssetState
+  {
+    return slot_ ? slot_->state.load(std::memory_order_acquire) : AssetState::Failed;
+  }
+
+  auto AssetRef::data() const -> const void*
+  {
+    return state() == AssetState::Ready ? slot_->data.get() : nullptr;
+  }
+
+  //
+  //  AssetManager
+  //
+
+  AssetManager::AssetManager(JobSystem& jobs, AsyncIO& io, const Vfs& vfs):
+    AssetManager{ jobs, io, vfs, CreateInfo{} } {}
+
+  AssetManager::AssetManager(JobSystem& jobs, AsyncIO& io, const Vfs& vfs, const CreateInfo& create_info):
+    p_impl_{ std::make_unique<Impl>(jobs, io, vfs, create_info) } {}
+
+  AssetManager::~AssetManager() = default;
+
+  void AssetManager::update()
+  {
+    p_impl_->update();
+  }
+
+  auto AssetManager::stats() const -> Stats
+  {
+    return p_impl_->stats();
+  }
+
+  void AssetManager::register_loader(const std::type_index type, ErasedLoader&& loader)
+  {
+    p_impl_->register_loader(type, std::move(loader));
+  }
+
+  auto AssetManager::load(const std::filesystem::path& path, const std::type_index type) -> AssetRef
+  {
+    return p_impl_->load(path, type);
+  }
+}
@@ -0,0 +1,164 @@
+//
+// Streams assets in the background and hands out typed, reference counted handles right away. A load is read
+// (straight out of a mapped archive, or through AsyncIO for loose files) and decoded on a background job. If
+// its loader has an upload step (GPU uploads), that runs in update() on the game thread, a few per frame, so a
+// burst of loads can't blow a frame. Loading the same path twice gives back the same asset. Assets no handle
+// refers to anymore stay cached until the memory budget pushes them out, least recently released first.
+//
+//   assets.register_loader<Level>({ .decode = [](std::span<const std::byte> bytes) { return parse_level(bytes); } });
+//   auto level{ assets.load<Level>("res/game/levels/01.lvl") };
+//   ...
+//   if (const auto* data{ level.get() }) { ... } // null until it's ready
+//
+
+#pragma once
+
+namespace fx {
+  class JobSystem;
+  class AsyncIO;
+  class Vfs;
+  struct AssetSlot;
+
+  enum class AssetState: u32 {
+    Loading,
+    Uploading,
+    Ready,
+    Failed,
+  };
+
+  // The untyped half of AssetHandle, which does the reference counting
+  class AssetRef {
+  public:
+    AssetRef() = default;
+    AssetRef(const AssetRef& other);
+    AssetRef(AssetRef&& other) noexcept;
+    ~AssetRef();
+
+    auto operator=(const AssetRef& other) -> AssetRef&;
+    auto operator=(AssetRef&& other) noexcept -> AssetRef&;
+
+    [[nodiscard]] auto valid() const -> bool;
+    [[nodiscard]] auto state() const -> AssetState;
+    // Null until the asset is ready
+    [[nodiscard]] auto data() const -> const void*;
+
+  private:
+    friend class AssetManager;
+    // Adopts a reference the manager already took
+    explicit AssetRef(AssetSlot* slot);
+
+    AssetSlot* slot_{ nullptr };
+  };
+
+  template<class T>
+  class AssetHandle {
+  public:
+    AssetHandle() = default;
+
+    [[nodiscard]] auto get() const -> const T* { return static_cast<const T*>(ref_.data()); }
+    [[nodiscard]] auto operator->() const -> const T* { return get(); }
+    [[nodiscard]] auto state() const -> AssetState { return ref_.state(); }
+    [[nodiscard]] auto ready() const -> bool { return ref_.state() == AssetState::Ready; }
+    [[nodiscard]] auto valid() const -> bool { return ref_.valid(); }
+
+  private:
+    friend class AssetManager;
+    explicit AssetHandle(AssetRef&& ref): ref_{ std::move(ref) } {}
+
+    AssetRef ref_;
+  };
+
+  class AssetManager {
+  public:
+    struct CreateInfo {
+      // Unreferenced assets are evicted, least recently released first, while resident memory is over this
+      u64 memory_budget{ 256 * 1024 * 1024 };
+      // Upload steps per update(), and how many bytes of assets they may cover (the first one always runs)
+      u32 uploads_per_frame{ 4 };
+      u64 upload_bytes_per_frame{ 16 * 1024 * 1024 };
+    };
+
+    struct Stats {
+      // Being read or decoded
+      u32 loading{ 0 };
+      // Decoded, waiting for their upload step
+      u32 upload_queue{ 0 };
+      u32 resident{ 0 };
+      u64 resident_bytes{ 0 };
+      u64 loads_completed{ 0 };
+      u64 loads_failed{ 0 };
+      // Loads answered by an asset that was already loaded or loading
+      u64 cache_hits{ 0 };
+      u64 evictions{ 0 };
+      // From load() until the asset was ready
+      double mean_latency_ms{ 0. };
+      double max_latency_ms{ 0. };
+    };
+
+    template<class T>
+    struct Loader {
+      // Runs on a background job, the bytes are only valid during the call
+      std::function<std::optional<T>(std::span<const std::byte> bytes)> decode;
+      // Optional, runs in update() within the per frame budget. Returning false fails the asset.
+      std::function<bool(T& asset)> upload{};
+      // Bytes counted against the memory budget, the file size when empty
+      std::function<u64(const T& asset)> size{};
+    };
+
+    AssetManager(JobSystem& jobs, AsyncIO& io, const Vfs& vfs);
+    AssetManager(JobSystem& jobs, AsyncIO& io, const Vfs& vfs, const CreateInfo& create_info);
+    // Waits for the loads in flight. Handles should be gone by now, any left over keep their asset forever.
+    ~AssetManager();
+
+    AssetManager(const AssetManager& other) = delete;
+    auto operator=(const AssetManager& other) -> AssetManager& = delete;
+
+    template<class T>
+    void register_loader(Loader<T>&& loader)
+    {
+      register_loader(typeid(T), ErasedLoader{
+        .decode = [decode = std::move(loader.decode), size = std::move(loader.size)](
+          const std::span<const std::byte> bytes,
+          u64& asset_size
+        ) -> shared<void> {
+          auto asset{ decode(bytes) };
+          if (!asset) {
+            return nullptr;
+          }
+          asset_size = size ? size(*asset) : bytes.size();
+          return std::make_shared<T>(std::move(*asset));
+        },
+        .upload = loader.upload ? [upload = std::move(loader.upload)](void* asset) {
+          return upload(*static_cast<T*>(asset));
+        } : std::function<bool(void*)>{},
+      });
+    }
+
+    // Never blocks. The handle is invalid if no loader is registered for T, or the path is already loaded as
+    // something else.
+    template<class T>
+    [[nodiscard]] auto load(const std::filesystem::path& path) -> AssetHandle<T>
+    {
+      return AssetHandle<T>{ load(path, typeid(T)) };
+    }
+
+    // Once per frame on the game thread: runs upload steps within the budget, then evicts down to the memory budget
+    void update();
+    [[nodiscard]] auto stats() const -> Stats;
+
+  private:
+    friend class AssetRef;
+    friend struct AssetSlot;
+
+    struct ErasedLoader {
+      std::function<shared<void>(std::span<const std::byte>, u64&)> decode;
+      std::function<bool(void*)> upload;
+    };
+
+    class Impl;
+    unique<Impl> p_impl_;
+
+    void register_loader(std::type_index type, ErasedLoader&& loader);
+    [[nodiscard]] auto load(const std::filesystem::path& path, std::type_index type) -> AssetRef;
+  };
+}
@@ -0,0 +1,244 @@
+//
+// Non-allocating replacements for std::function and Event, used for stage callbacks. A Delegate keeps its
+// callable in a fixed inline buffer (oversized callables are a compile error, not a heap allocation), and a
+// StageEvent dispatches from one contiguous array. BakedEvent goes further and fixes the callbacks at compile
+// time, so dispatch is just a sequence of direct, inlinable calls.
+//
+// Sources:
+// https://www.codeproject.com/Articles/11015/The-Impossibly-Fast-C-Delegates
+// https://skypjack.github.io/2019-01-25-delegate-revised/
+//
+
+#pragma once
+
+namespace fx {
+  template<class Signature, std::size_t Capacity = 4 * sizeof(void*)>
+  class Delegate;
+
+  template<class... Args>
+  class StageEvent;
+
+  template<class R, class... Args, std::size_t Capacity>
+  class Delegate<R(Args...), Capacity> {
+    enum class Operation {
+      Copy,
+      Move,
+      Destroy,
+    };
+
+    using Invoke = R(*)(void*, Args...);
+    using Manage = void(*)(void* destination, void* source, Operation operation);
+
+    // Dispatches without the empty check, it never stores empty delegates
+    template<class...>
+    friend class StageEvent;
+
+  public:
+    Delegate() = default;
+
+    template<class F>
+      requires (!std::is_same_v<std::decay_t<F>, Delegate> && std::is_invocable_r_v<R, std::decay_t<F>&, Args...>)
+    Delegate(F&& function) // NOLINT(google-explicit-constructor)
+    {
+      using Function = std::decay_t<F>;
+      static_assert(sizeof(Function) <= Capacity, "Callable doesn't fit in the Delegate, capture by reference or pointer instead.");
+      static_assert(alignof(Function) <= alignof(std::max_align_t), "Callable is over-aligned for the Delegate.");
+
+      ::new (static_cast<void*>(storage_)) Function(std::forward<F>(function));
+      invoke_ = [](void* storage, Args... args) -> R {
+        return std::invoke(*static_cast<Function*>(storage), std::forward<Args>(args)...);
+      };
+      // Trivial callables (plain lambdas capturing this or references) are copied with memcpy and never destroyed
+      if constexpr (!std::is_trivially_copyable_v<Function> || !std::is_trivially_destructible_v<Function>) {
+        manage_ = [](void* destination, void* source, const Operation operation) {
+          auto* function{ static_cast<Function*>(source) };
+          switch (operation) {
+            case Operation::Copy:
+              ::new (destination) Function(*function);
+              break;
+            case Operation::Move:
+              ::new (destination) Function(std::move(*function));
+              break;
+            case Operation::Destroy:
+              function->~Function();
+              break;
+          }
+        };
+      }
+    }
+
+    Delegate(const Delegate& other)
+    {
+      copy_from(other);
+    }
+
+    Delegate(Delegate&& other) noexcept
+    {
+      move_from(other);
+    }
+
+    ~Delegate()
+    {
+      reset();
+    }
+
+    auto operator=(const Delegate& other) -> Delegate&
+    {
+      if (this != &other) {
+        reset();
+        copy_from(other);
+      }
+      return *this;
+    }
+
+    auto operator=(Delegate&& other) noexcept -> Delegate&
+    {
+      if (this != &other) {
+        reset();
+        move_from(other);
+      }
+      return *this;
+    }
+
+    // Bound at compile time: the call target is part of the type of the generated thunk
+    template<auto Function>
+    [[nodiscard]] static auto bind() -> Delegate
+    {
+      return Delegate{ [](Args... args) -> R {
+        return std::invoke(Function, std::forward<Args>(args)...);
+      }};
+    }
+
+    template<auto Method, class T>
+    [[nodiscard]] static auto bind(T& instance) -> Delegate
+    {
+      return Delegate{ [&instance](Args... args) -> R {
+        return std::invoke(Method, instance, std::forward<Args>(args)...);
+      }};
+    }
+
+    // Calling an empty delegate does nothing when there's nothing to return, and throws like std::function
+    // otherwise
+    auto operator()(Args... args) const -> R
+    {
+      if (!invoke_) [[unlikely]] {
+        if constexpr (std::is_void_v<R>) {
+          return;
+        } else {
+          throw std::bad_function_call{};
+        }
+      }
+      return invoke_unchecked(std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const
+    {
+      return invoke_ != nullptr;
+    }
+
+    void reset()
+    {
+      if (manage_) {
+        manage_(nullptr, storage_, Operation::Destroy);
+      }
+      invoke_ = nullptr;
+      manage_ = nullptr;
+    }
+
+  private:
+    alignas(std::max_align_t) mutable std::byte storage_[Capacity]{};
+    Invoke invoke_{ nullptr };
+    Manage manage_{ nullptr };
+
+    auto invoke_unchecked(Args... args) const -> R
+    {
+      return invoke_(static_cast<void*>(storage_), std::forward<Args>(args)...);
+    }
+
+    void copy_from(const Delegate& other)
+    {
+      if (other.manage_) {
+        other.manage_(storage_, other.storage_, Operation::Copy);
+      } else {
+        std::memcpy(storage_, other.storage_, Capacity);
+      }
+      invoke_ = other.invoke_;
+      manage_ = other.manage_;
+    }
+
+    void move_from(Delegate& other)
+    {
+      if (other.manage_) {
+        other.manage_(storage_, other.storage_, Operation::Move);
+      } else {
+        std::memcpy(storage_, other.storage_, Capacity);
+      }
+      invoke_ = other.invoke_;
+      manage_ = other.manage_;
+      other.reset();
+    }
+  };
+
+  // Registration may grow the array, dispatch never allocates
+  template<class... Args>
+  class StageEvent {
+  public:
+    using Callback = Delegate<void(Args...)>;
+
+    // Empty callbacks would do nothing, so they aren't stored and dispatch doesn't have to check for them
+    void add_callback(Callback&& callback)
+    {
+      if (callback) {
+        callbacks_.push_back(std::move(callback));
+      }
+    }
+
+    void reserve(const std::size_t count)
+    {
+      callbacks_.reserve(count);
+    }
+
+    void clear()
+    {
+      callbacks_.clear();
+    }
+
+    [[nodiscard]] auto size() const -> std::size_t
+    {
+      return callbacks_.size();
+    }
+
+    [[nodiscard]] auto empty() const -> bool
+    {
+      return callbacks_.empty();
+    }
+
+    void operator()(Args... args) const
+    {
+      for (const auto& callback: callbacks_) {
+        callback.invoke_unchecked(args...);
+      }
+    }
+
+  private:
+    std::vector<Callback> callbacks_;
+  };
+
+  // Callbacks fixed at compile time, e.g. BakedEvent<&physics_step, &animate>::dispatch(app, time)
+  template<auto... Callbacks>
+  struct BakedEvent {
+    template<class... Args>
+    static void dispatch(Args&&... args)
+    {
+      (std::invoke(Callbacks, args...), ...);
+    }
+
+    // The whole group as one Delegate, so it can go anywhere a single callback can (an App stage, a StageEvent).
+    // That costs one indirect call, the callbacks inside are still called directly.
+    template<class... Args>
+    [[nodiscard]] static auto delegate() -> Delegate<void(Args...)>
+    {
+      return Delegate<void(Args...)>::template bind<&BakedEvent::template dispatch<Args...>>();
+    }
+  };
+}
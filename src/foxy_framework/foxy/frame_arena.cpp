@@ -0,0 +1,213 @@
+#include "frame_arena.hpp"
+
+namespace fx {
+  namespace {
+    std::atomic<u64> frame_epoch{ 0 };
+
+    struct Registry {
+      std::mutex mutex;
+      std::vector<FrameArena*> arenas;
+    };
+
+    auto registry() -> Registry&
+    {
+      static Registry instance{};
+      return instance;
+    }
+  }
+
+  class FrameArena::Impl {
+  public:
+    explicit Impl(const std::size_t initial_size)
+    {
+      add_block(std::max(initial_size, std::size_t{ 64 }));
+    }
+
+    ~Impl() = default;
+
+    auto allocate(const std::size_t bytes, const std::size_t alignment) -> void*
+    {
+      auto* p{ bump(blocks_.back(), bytes, alignment) };
+      if (!p) {
+        // Out of room: chain a block big enough for this allocation, twice the size of the last one
+        add_block(std::max(blocks_.back().size * 2, bytes + alignment));
+        p = bump(blocks_.back(), bytes, alignment);
+      }
+      used_.store(used_bytes(), std::memory_order_relaxed);
+      return p;
+    }
+
+    void reset()
+    {
+      const auto used{ used_bytes() };
+      last_frame_bytes_.store(used, std::memory_order_relaxed);
+      last_frame_epoch_.store(epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+      if (used > peak_frame_bytes_.load(std::memory_order_relaxed)) {
+        peak_frame_bytes_.store(used, std::memory_order_relaxed);
+      }
+
+      if (blocks_.size() > 1) {
+        // The frame didn't fit, so next frame starts with room for all of it in one block
+        std::size_t total{ 0 };
+        for (const auto& block: blocks_) {
+          total += block.size;
+        }
+        blocks_.clear();
+        reserved_bytes_.store(0, std::memory_order_relaxed);
+        add_block(total);
+      }
+      blocks_.back().offset = 0;
+      used_before_back_ = 0;
+      used_.store(0, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] auto used_bytes() const -> u64
+    {
+      return used_before_back_ + blocks_.back().offset;
+    }
+
+    // Bytes used during the given frame, whether or not this arena has been rewound since. Zero if it wasn't
+    // used then, so a thread that stopped allocating doesn't keep reporting its old usage.
+    [[nodiscard]] auto frame_bytes(const u64 frame) const -> u64
+    {
+      if (epoch.load(std::memory_order_relaxed) == frame) {
+        return used_.load(std::memory_order_relaxed);
+      }
+      if (last_frame_epoch_.load(std::memory_order_relaxed) == frame) {
+        return last_frame_bytes_.load(std::memory_order_relaxed);
+      }
+      return 0;
+    }
+
+    [[nodiscard]] auto peak_frame_bytes() const -> u64
+    {
+      return peak_frame_bytes_.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] auto reserved_bytes() const -> u64
+    {
+      return reserved_bytes_.load(std::memory_order_relaxed);
+    }
+
+    // The frame this arena was last used in. Written by the owning thread, read by stats().
+    std::atomic<u64> epoch{ frame_epoch.load(std::memory_order_relaxed) };
+
+  private:
+    struct Block {
+      unique<std::byte[]> data;
+      std::size_t size;
+      std::size_t offset{ 0 };
+    };
+
+    std::vector<Block> blocks_;
+    // Bytes handed out from every block but the current one
+    u64 used_before_back_{ 0 };
+    // Read by stats() from other threads. last_frame_bytes_ is what the frame last_frame_epoch_ used, used_
+    // is the current frame so far.
+    std::atomic<u64> used_{ 0 };
+    std::atomic<u64> last_frame_bytes_{ 0 };
+    std::atomic<u64> last_frame_epoch_{ 0 };
+    std::atomic<u64> peak_frame_bytes_{ 0 };
+    std::atomic<u64> reserved_bytes_{ 0 };
+
+    void add_block(const std::size_t size)
+    {
+      if (!blocks_.empty()) {
+        used_before_back_ += blocks_.back().offset;
+      }
+      blocks_.push_back(Block{ .data = std::make_unique_for_overwrite<std::byte[]>(size), .size = size });
+      reserved_bytes_.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] static auto bump(Block& block, const std::size_t bytes, const std::size_t alignment) -> void*
+    {
+      void* p{ block.data.get() + block.offset };
+      auto space{ block.size - block.offset };
+      if (!std::align(alignment, bytes, p, space)) {
+        return nullptr;
+      }
+      block.offset = block.size - space + bytes;
+      return p;
+    }
+  };
+
+  //
+  //  FrameArena
+  //
+
+  FrameArena::FrameArena(const std::size_t initial_size):
+    p_impl_{ std::make_unique<Impl>(initial_size) }
+  {
+    auto& arenas{ registry() };
+    std::scoped_lock lock{ arenas.mutex };
+    arenas.arenas.push_back(this);
+  }
+
+  FrameArena::~FrameArena()
+  {
+    auto& arenas{ registry() };
+    std::scoped_lock lock{ arenas.mutex };
+    std::erase(arenas.arenas, this);
+  }
+
+  auto FrameArena::local() -> FrameArena&
+  {
+    thread_local FrameArena arena{};
+    if (const auto epoch{ frame_epoch.load(std::memory_order_acquire) };
+        arena.p_impl_->epoch.load(std::memory_order_relaxed) != epoch) {
+      // Rewound first, so what it used gets filed under the frame it was used in
+      arena.reset();
+      arena.p_impl_->epoch.store(epoch, std::memory_order_relaxed);
+    }
+    return arena;
+  }
+
+  void FrameArena::advance_frame()
+  {
+    frame_epoch.fetch_add(1, std::memory_order_release);
+  }
+
+  auto FrameArena::stats() -> Stats
+  {
+    auto& arenas{ registry() };
+    std::scoped_lock lock{ arenas.mutex };
+    Stats stats{ .threads = static_cast<u32>(arenas.arenas.size()) };
+    const auto last_frame{ frame_epoch.load(std::memory_order_acquire) - 1 };
+    for (const auto* arena: arenas.arenas) {
+      stats.last_frame_bytes += arena->p_impl_->frame_bytes(last_frame);
+      stats.peak_frame_bytes = std::max(stats.peak_frame_bytes, arena->p_impl_->peak_frame_bytes());
+      stats.reserved_bytes += arena->p_impl_->reserved_bytes();
+    }
+    return stats;
+  }
+
+  void FrameArena::reset()
+  {
+    p_impl_->reset();
+  }
+
+  auto FrameArena::used_bytes() const -> u64
+  {
+    return p_impl_->used_bytes();
+  }
+
+  auto FrameArena::peak_frame_bytes() const -> u64
+  {
+    return p_impl_->peak_frame_bytes();
+  }
+
+  auto FrameArena::do_allocate(const std::size_t bytes, const std::size_t alignment) -> void*
+  {
+    return p_impl_->allocate(bytes, alignment);
+  }
+
+  void FrameArena::do_deallocate(void* p, std::size_t bytes, std::size_t alignment)
+  {
+    // Everything goes at once in reset()
+  }
+
+  auto FrameArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept -> bool
+  {
+    return this == &other;
+  }
+}
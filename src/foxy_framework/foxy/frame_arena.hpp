@@ -0,0 +1,58 @@
+//
+// Per-thread bump allocator for memory that only needs to live until the end of the game frame. Allocating
+// is a pointer bump, freeing is a no-op, and the whole arena is rewound at the next frame boundary, so
+// scratch containers in stage callbacks never touch the global heap once the arena has grown to fit a frame.
+//
+// Each thread (game thread and job workers) gets its own arena, reset lazily the first time it's used in a
+// new frame. Memory from it must not be kept past the frame it was allocated in.
+//
+// Sources:
+// https://www.gingerbill.org/article/2019/02/08/memory-allocation-strategies-002/
+// https://en.cppreference.com/w/cpp/memory/monotonic_buffer_resource
+//
+
+#pragma once
+
+namespace fx {
+  class FrameArena: public std::pmr::memory_resource {
+  public:
+    struct Stats {
+      u32 threads{ 0 };
+      // Bytes used across every thread's arena during the last finished frame
+      u64 last_frame_bytes{ 0 };
+      // Most bytes any single arena has used in one frame
+      u64 peak_frame_bytes{ 0 };
+      // Bytes currently reserved by all arenas
+      u64 reserved_bytes{ 0 };
+    };
+
+    explicit FrameArena(std::size_t initial_size = default_block_size);
+    ~FrameArena() override;
+
+    FrameArena(const FrameArena& other) = delete;
+    auto operator=(const FrameArena& other) -> FrameArena& = delete;
+
+    // The calling thread's arena, rewound first if a new frame started since it was last used
+    [[nodiscard]] static auto local() -> FrameArena&;
+    // Starts a new frame for every thread. Only call once nothing from the previous frame is still running.
+    static void advance_frame();
+    [[nodiscard]] static auto stats() -> Stats;
+
+    // Rewinds the arena, folding any overflow blocks into one block big enough for the whole frame
+    void reset();
+
+    [[nodiscard]] auto used_bytes() const -> u64;
+    [[nodiscard]] auto peak_frame_bytes() const -> u64;
+
+    static constexpr inline std::size_t default_block_size{ 256 * 1024 };
+
+  protected:
+    auto do_allocate(std::size_t bytes, std::size_t alignment) -> void* override;
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override;
+    [[nodiscard]] auto do_is_equal(const std::pmr::memory_resource& other) const noexcept -> bool override;
+
+  private:
+    class Impl;
+    unique<Impl> p_impl_;
+  };
+}
@@ -0,0 +1,177 @@
+#include "frame_limiter.hpp"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FOXY_CPU_RELAX() _mm_pause()
+#else
+#define FOXY_CPU_RELAX() std::this_thread::yield()
+#endif
+
+namespace fx {
+  namespace {
+    // Running mean/variance (Welford), so the stats never have to keep a history around. With a window, the
+    // count stops growing there and m2 is scaled down to match, which turns both into exponential moving
+    // averages over roughly the last window samples.
+    struct RunningStats {
+      u64 window{ 0 };
+      u64 count{ 0 };
+      double mean{ 0. };
+      double m2{ 0. };
+      double min{ std::numeric_limits<double>::max() };
+      double max{ 0. };
+
+      void add(const double value)
+      {
+        ++count;
+        const double delta{ value - mean };
+        mean += delta / static_cast<double>(count);
+        m2 += delta * (value - mean);
+        min = std::min(min, value);
+        max = std::max(max, value);
+        if (window > 0 && count > window) {
+          m2 *= static_cast<double>(window) / static_cast<double>(count);
+          count = window;
+        }
+      }
+
+      [[nodiscard]] auto stddev() const -> double
+      {
+        return count > 1 ? std::sqrt(m2 / static_cast<double>(count - 1)) : 0.;
+      }
+    };
+  }
+
+  class FrameLimiter::Impl {
+    using Clock = std::chrono::steady_clock;
+    using Seconds = std::chrono::duration<double>;
+
+  public:
+    explicit Impl(const double target_frame_rate, const bool spin):
+      spin_{ spin }
+    {
+      set_target_frame_rate(target_frame_rate);
+    }
+
+    ~Impl() = default;
+
+    void wait()
+    {
+      if (const auto period{ period_.load(std::memory_order_relaxed) }; period > 0.) {
+        const auto now{ Clock::now() };
+        const auto frame{ std::chrono::duration_cast<Clock::duration>(Seconds{ period }) };
+        if (deadline_ == Clock::time_point{} || deadline_ + frame < now) {
+          // First frame, or more than a whole frame late: start pacing again from here
+          deadline_ = now + frame;
+        }
+        sleep_until(deadline_);
+        const auto error{ std::chrono::duration<double, std::micro>{ Clock::now() - deadline_ }.count() };
+        {
+          std::scoped_lock lock{ stats_mutex_ };
+          error_.add(error);
+        }
+        deadline_ += frame;
+      }
+
+      const auto now{ Clock::now() };
+      if (last_frame_ != Clock::time_point{}) {
+        std::scoped_lock lock{ stats_mutex_ };
+        frames_.add(std::chrono::duration<double, std::milli>{ now - last_frame_ }.count());
+      }
+      last_frame_ = now;
+    }
+
+    void set_target_frame_rate(const double target_frame_rate)
+    {
+      period_.store(target_frame_rate > 0. ? 1. / target_frame_rate : 0., std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] auto target_frame_time() const -> double
+    {
+      return period_.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] auto stats() const -> Stats
+    {
+      std::scoped_lock lock{ stats_mutex_ };
+      return Stats{
+        .frames = frames_.count,
+        .mean_ms = frames_.mean,
+        .stddev_ms = frames_.stddev(),
+        .min_ms = frames_.count ? frames_.min : 0.,
+        .max_ms = frames_.max,
+        .mean_error_us = error_.mean,
+        .spin_margin_us = spin_margin() * 1'000'000.,
+      };
+    }
+
+  private:
+    const bool spin_;
+    std::atomic<double> period_{ 0. };
+    Clock::time_point deadline_{};
+    Clock::time_point last_frame_{};
+
+    // Written by the waiting thread under stats_mutex_, so it can read them without the lock and stats() can
+    // read them from anywhere
+    mutable std::mutex stats_mutex_;
+    // How long a 1ms sleep actually takes, learned as the limiter goes. Windowed to keep adapting when the
+    // scheduler's behaviour changes (power states, timer resolution).
+    RunningStats sleep_{ .window = 1000 };
+    RunningStats error_;
+    RunningStats frames_;
+
+    // A pessimistic guess at how long the next 1ms sleep could take
+    [[nodiscard]] auto spin_margin() const -> double
+    {
+      return sleep_.count ? sleep_.mean + sleep_.stddev() : 0.002;
+    }
+
+    void sleep_until(const Clock::time_point deadline)
+    {
+      if (!spin_) {
+        std::this_thread::sleep_until(deadline);
+        return;
+      }
+      
+      while (Seconds{ deadline - Clock::now() }.count() > spin_margin()) {
+        const auto start{ Clock::now() };
+        std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+        const auto slept{ Seconds{ Clock::now() - start }.count() };
+        std::scoped_lock lock{ stats_mutex_ };
+        sleep_.add(slept);
+      }
+
+      while (Clock::now() < deadline) {
+        FOXY_CPU_RELAX();
+      }
+    }
+  };
+
+  //
+  //  FrameLimiter
+  //
+
+  FrameLimiter::FrameLimiter(const double target_frame_rate, const bool spin):
+    p_impl_{ std::make_unique<Impl>(target_frame_rate, spin) } {}
+
+  FrameLimiter::~FrameLimiter() = default;
+
+  void FrameLimiter::wait()
+  {
+    p_impl_->wait();
+  }
+
+  void FrameLimiter::set_target_frame_rate(const double target_frame_rate)
+  {
+    p_impl_->set_target_frame_rate(target_frame_rate);
+  }
+
+  auto FrameLimiter::target_frame_time() const -> double
+  {
+    return p_impl_->target_frame_time();
+  }
+
+  auto FrameLimiter::stats() const -> Stats
+  {
+    return p_impl_->stats();
+  }
+}
@@ -0,0 +1,45 @@
+//
+// Frame limiter that sleeps through most of the remaining frame time and spin-waits the rest. The OS sleep
+// is only trusted up to a margin learned from how much its sleeps have overshot so far, which is what lets
+// the limiter hit its deadlines to within a few microseconds instead of the scheduler's granularity.
+//
+// Sources:
+// https://blog.bearcats.nl/perfect-sleep-function/
+// https://blat-blatnik.github.io/computerBear/making-accurate-sleep-function/
+//
+
+#pragma once
+
+namespace fx {
+  class FrameLimiter {
+  public:
+    struct Stats {
+      u64 frames{ 0 };
+      // Time between consecutive wait() calls returning
+      double mean_ms{ 0. };
+      double stddev_ms{ 0. };
+      double min_ms{ 0. };
+      double max_ms{ 0. };
+      // How far from the deadline the limiter returned on average
+      double mean_error_us{ 0. };
+      // Remaining time below which the limiter stops trusting the OS sleep and spins
+      double spin_margin_us{ 0. };
+    };
+
+    // Zero means unlimited, wait() then only records frame times. Without spin the limiter only ever sleeps,
+    // trading precision for not burning a core (servers sharing a machine).
+    explicit FrameLimiter(double target_frame_rate = 0., bool spin = true);
+    ~FrameLimiter();
+
+    // Blocks until the next frame deadline. Missed deadlines are dropped rather than caught up on.
+    void wait();
+    void set_target_frame_rate(double target_frame_rate);
+
+    [[nodiscard]] auto target_frame_time() const -> double;
+    [[nodiscard]] auto stats() const -> Stats;
+
+  private:
+    class Impl;
+    unique<Impl> p_impl_;
+  };
+}
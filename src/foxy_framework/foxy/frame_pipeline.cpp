@@ -0,0 +1,163 @@
+#include "frame_pipeline.hpp"
+
+namespace fx {
+  class FramePipeline::Impl {
+    using Clock = std::chrono::steady_clock;
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+  public:
+    explicit Impl(const u32 max_frames_ahead):
+      max_frames_ahead_{ max_frames_ahead } {}
+
+    ~Impl() = default;
+
+    auto begin_simulation() -> bool
+    {
+      const auto wait_start{ Clock::now() };
+      std::unique_lock lock{ mutex_ };
+      // frames_simulated_ - frames_rendered_ counts frames handed off but not yet finished by the render thread
+      render_done_.wait(lock, [this] {
+        return stopped_ || frames_simulated_ - frames_rendered_ <= max_frames_ahead_;
+      });
+      simulate_start_ = Clock::now();
+      if (start_ == Clock::time_point{}) {
+        start_ = simulate_start_;
+      }
+      game_wait_ += simulate_start_ - wait_start;
+      return !stopped_;
+    }
+
+    void publish()
+    {
+      {
+        std::scoped_lock lock{ mutex_ };
+        simulate_ += Clock::now() - simulate_start_;
+        ++frames_simulated_;
+      }
+      frame_ready_.notify_one();
+    }
+
+    auto acquire_render() -> std::optional<u64>
+    {
+      const auto wait_start{ Clock::now() };
+      std::unique_lock lock{ mutex_ };
+      frame_ready_.wait(lock, [this] {
+        return stopped_ || frames_acquired_ < frames_simulated_;
+      });
+      if (frames_acquired_ == frames_simulated_) {
+        return std::nullopt;
+      }
+      render_start_ = Clock::now();
+      render_wait_ += render_start_ - wait_start;
+      return frames_acquired_++;
+    }
+
+    void release_render()
+    {
+      {
+        std::scoped_lock lock{ mutex_ };
+        render_ += Clock::now() - render_start_;
+        ++frames_rendered_;
+      }
+      render_done_.notify_one();
+    }
+
+    void stop()
+    {
+      {
+        std::scoped_lock lock{ mutex_ };
+        stopped_ = true;
+      }
+      frame_ready_.notify_all();
+      render_done_.notify_all();
+    }
+
+    [[nodiscard]] auto max_frames_ahead() const -> u32
+    {
+      return max_frames_ahead_;
+    }
+
+    [[nodiscard]] auto stats() const -> Stats
+    {
+      std::scoped_lock lock{ mutex_ };
+      const auto per_frame = [](const Clock::duration total, const u64 frames) {
+        return frames > 0 ? Milliseconds{ total }.count() / static_cast<double>(frames) : 0.;
+      };
+      const Milliseconds wall{ start_ == Clock::time_point{} ? Clock::duration{} : Clock::now() - start_ };
+
+      return Stats{
+        .frames_simulated = frames_simulated_,
+        .frames_rendered = frames_rendered_,
+        .simulate_ms = per_frame(simulate_, frames_simulated_),
+        .render_ms = per_frame(render_, frames_rendered_),
+        .game_wait_ms = per_frame(game_wait_, frames_simulated_),
+        .render_wait_ms = per_frame(render_wait_, frames_rendered_),
+        .concurrency = wall.count() > 0. ? (Milliseconds{ simulate_ }.count() + Milliseconds{ render_ }.count()) / wall.count() : 0.,
+      };
+    }
+
+  private:
+    const u32 max_frames_ahead_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable frame_ready_;
+    std::condition_variable render_done_;
+    bool stopped_{ false };
+
+    u64 frames_simulated_{ 0 };
+    u64 frames_acquired_{ 0 };
+    u64 frames_rendered_{ 0 };
+
+    Clock::time_point start_{};
+    Clock::time_point simulate_start_{};
+    Clock::time_point render_start_{};
+    Clock::duration simulate_{};
+    Clock::duration render_{};
+    Clock::duration game_wait_{};
+    Clock::duration render_wait_{};
+  };
+
+  //
+  //  FramePipeline
+  //
+
+  FramePipeline::FramePipeline(const u32 max_frames_ahead):
+    p_impl_{ std::make_unique<Impl>(max_frames_ahead) } {}
+
+  FramePipeline::~FramePipeline() = default;
+
+  auto FramePipeline::begin_simulation() -> bool
+  {
+    return p_impl_->begin_simulation();
+  }
+
+  void FramePipeline::publish()
+  {
+    p_impl_->publish();
+  }
+
+  auto FramePipeline::acquire_render() -> std::optional<u64>
+  {
+    return p_impl_->acquire_render();
+  }
+
+  void FramePipeline::release_render()
+  {
+    p_impl_->release_render();
+  }
+
+  void FramePipeline::stop()
+  {
+    p_impl_->stop();
+  }
+
+  auto FramePipeline::max_frames_ahead() const -> u32
+  {
+    return p_impl_->max_frames_ahead();
+  }
+
+  auto FramePipeline::stats() const -> Stats
+  {
+    return p_impl_->stats();
+  }
+}
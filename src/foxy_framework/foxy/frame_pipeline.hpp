@@ -0,0 +1,46 @@
+//
+// Bounded hand-off between the game thread (producer) and the render thread (consumer). The game thread
+// may simulate up to max_frames_ahead frames past the one currently being rendered; zero runs the two
+// stages back to back like a single threaded loop. Anything handed from one side to the other per frame
+// needs max_frames_ahead + 1 copies, indexed by frame number.
+//
+
+#pragma once
+
+namespace fx {
+  class FramePipeline {
+  public:
+    struct Stats {
+      u64 frames_simulated{ 0 };
+      u64 frames_rendered{ 0 };
+      // Averages per frame
+      double simulate_ms{ 0. };
+      double render_ms{ 0. };
+      double game_wait_ms{ 0. };
+      double render_wait_ms{ 0. };
+      // Busy time of both stages over wall time: 1 means they ran serially, 2 means they fully overlapped
+      double concurrency{ 0. };
+    };
+
+    explicit FramePipeline(u32 max_frames_ahead = 1);
+    ~FramePipeline();
+
+    // Game thread. Blocks while the game thread is too far ahead of the render thread.
+    // Returns false once the pipeline has been stopped.
+    auto begin_simulation() -> bool;
+    void publish();
+
+    // Render thread. Blocks until a frame has been published, empty once stopped and drained.
+    auto acquire_render() -> std::optional<u64>;
+    void release_render();
+
+    void stop();
+
+    [[nodiscard]] auto max_frames_ahead() const -> u32;
+    [[nodiscard]] auto stats() const -> Stats;
+
+  private:
+    class Impl;
+    unique<Impl> p_impl_;
+  };
+}
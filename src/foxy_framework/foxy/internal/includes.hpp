@@ -24,11 +24,14 @@
 // Utilities
 #include <compare>
 #include <cstdlib>
+#include <cstring>
+#include <cmath>
 #include <algorithm>
 #include <numeric>
 #include <utility>
 #include <functional>
 #include <memory>
+#include <memory_resource>
 #include <ranges>
 #include <future>
 #include <ctime>
@@ -37,11 +40,18 @@
 #include <stdexcept>
 #include <limits>
 #include <typeinfo>
+#include <typeindex>
 #include <format>
 #include <string_view>
+#include <span>
+#include <bit>
+#include <coroutine>
+#include <optional>
+#include <exception>
 // Threading
 #include <thread>
 #include <mutex>
+#include <shared_mutex>
 #include <atomic>
 #include <condition_variable>
 #include <stop_token>
@@ -0,0 +1,165 @@
+#include "lz4.hpp"
+
+namespace fx::lz4 {
+  namespace {
+    constexpr inline std::size_t min_match{ 4 };
+    // The last match has to start this far from the end, and the last few bytes are always literals
+    constexpr inline std::size_t match_find_limit{ 12 };
+    constexpr inline std::size_t last_literals{ 5 };
+    constexpr inline std::size_t max_offset{ 65535 };
+    constexpr inline u32 hash_log{ 12 };
+
+    [[nodiscard]] auto read_u32(const std::byte* data) -> u32
+    {
+      u32 value;
+      std::memcpy(&value, data, sizeof(value));
+      return value;
+    }
+
+    [[nodiscard]] auto hash(const u32 sequence) -> u32
+    {
+      return (sequence * 2654435761U) >> (32 - hash_log);
+    }
+
+    void write_length(std::vector<std::byte>& out, std::size_t length)
+    {
+      for (; length >= 255; length -= 255) {
+        out.push_back(std::byte{ 255 });
+      }
+      out.push_back(static_cast<std::byte>(length));
+    }
+
+    void write_sequence(
+      std::vector<std::byte>& out,
+      const std::span<const std::byte> literals,
+      const std::size_t offset,
+      const std::size_t match_length
+    )
+    {
+      const auto literal_code{ std::min<std::size_t>(literals.size(), 15) };
+      const auto match_code{ match_length == 0 ? 0 : std::min<std::size_t>(match_length - min_match, 15) };
+      out.push_back(static_cast<std::byte>(literal_code << 4 | match_code));
+      if (literal_code == 15) {
+        write_length(out, literals.size() - 15);
+      }
+      out.insert(out.end(), literals.begin(), literals.end());
+
+      if (match_length == 0) {
+        return; // Last sequence, literals only
+      }
+      out.push_back(static_cast<std::byte>(offset & 0xFF));
+      out.push_back(static_cast<std::byte>(offset >> 8));
+      if (match_code == 15) {
+        write_length(out, match_length - min_match - 15);
+      }
+    }
+  }
+
+  auto compress_bound(const std::size_t input_size) -> std::size_t
+  {
+    return input_size + input_size / 255 + 16;
+  }
+
+  auto compress(const std::span<const std::byte> input) -> std::vector<std::byte>
+  {
+    std::vector<std::byte> out;
+    out.reserve(compress_bound(input.size()));
+
+    const auto size{ input.size() };
+    std::size_t anchor{ 0 };
+    if (size > match_find_limit) {
+      std::vector<i64> table(std::size_t{ 1 } << hash_log, -1);
+      const auto match_limit{ size - match_find_limit };
+      const auto extend_limit{ size - last_literals };
+      const auto* data{ input.data() };
+
+      for (std::size_t i{ 0 }; i < match_limit;) {
+        const auto sequence{ read_u32(data + i) };
+        auto& slot{ table[hash(sequence)] };
+        const auto candidate{ slot };
+        slot = static_cast<i64>(i);
+
+        if (candidate < 0 || i - static_cast<std::size_t>(candidate) > max_offset ||
+            read_u32(data + candidate) != sequence) {
+          ++i;
+          continue;
+        }
+
+        auto match{ static_cast<std::size_t>(candidate) };
+        auto length{ min_match };
+        while (i + length < extend_limit && data[match + length] == data[i + length]) {
+          ++length;
+        }
+        while (i > anchor && match > 0 && data[i - 1] == data[match - 1]) {
+          --i;
+          --match;
+          ++length;
+        }
+
+        write_sequence(out, input.subspan(anchor, i - anchor), i - match, length);
+        i += length;
+        anchor = i;
+      }
+    }
+
+    write_sequence(out, input.subspan(anchor), 0, 0);
+    return out;
+  }
+
+  auto decompress(const std::span<const std::byte> input, const std::span<std::byte> output) -> bool
+  {
+    std::size_t in{ 0 };
+    std::size_t out{ 0 };
+
+    const auto read_length{ [&](std::size_t length) -> std::optional<std::size_t> {
+      for (u8 next{ 255 }; next == 255; length += next) {
+        if (in >= input.size()) {
+          return std::nullopt;
+        }
+        next = static_cast<u8>(input[in++]);
+      }
+      return length;
+    } };
+
+    while (in < input.size()) {
+      const auto token{ static_cast<u8>(input[in++]) };
+
+      auto literals{ std::optional<std::size_t>{ token >> 4 } };
+      if (*literals == 15) {
+        literals = read_length(*literals);
+      }
+      if (!literals || *literals > input.size() - in || *literals > output.size() - out) {
+        return false;
+      }
+      std::copy_n(input.begin() + static_cast<std::ptrdiff_t>(in), *literals, output.begin() + static_cast<std::ptrdiff_t>(out));
+      in += *literals;
+      out += *literals;
+
+      if (in == input.size()) {
+        break; // Last sequence, literals only
+      }
+      if (input.size() - in < 2) {
+        return false;
+      }
+      const auto offset{ static_cast<std::size_t>(input[in]) | static_cast<std::size_t>(input[in + 1]) << 8 };
+      in += 2;
+      if (offset == 0 || offset > out) {
+        return false;
+      }
+
+      auto length{ std::optional<std::size_t>{ token & 15 } };
+      if (*length == 15) {
+        length = read_length(*length);
+      }
+      if (!length || *length + min_match > output.size() - out) {
+        return false;
+      }
+      // Byte by byte on purpose, the match may overlap what it's writing (offset < length repeats a pattern)
+      for (std::size_t i{ 0 }; i < *length + min_match; ++i, ++out) {
+        output[out] = output[out - offset];
+      }
+    }
+
+    return out == output.size();
+  }
+}
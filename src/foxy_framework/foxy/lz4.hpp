@@ -0,0 +1,18 @@
+//
+// LZ4 block format, enough to pack archive entries and unpack them at load time without pulling in liblz4.
+// The compressor is the plain greedy single-probe kind: not the best ratio, but fast, and the output decodes
+// with any LZ4 block decoder.
+//
+// Sources:
+// https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+//
+
+#pragma once
+
+namespace fx::lz4 {
+  // Worst case size of compress(input), for incompressible data
+  [[nodiscard]] auto compress_bound(std::size_t input_size) -> std::size_t;
+  [[nodiscard]] auto compress(std::span<const std::byte> input) -> std::vector<std::byte>;
+  // Output must be exactly the decompressed size. False when the input is corrupt or doesn't fill it.
+  [[nodiscard]] auto decompress(std::span<const std::byte> input, std::span<std::byte> output) -> bool;
+}
@@ -0,0 +1,209 @@
+#include "parallel_stage.hpp"
+
+#include <inu/job_system.hpp>
+
+namespace fx {
+  class ParallelStage::Impl {
+  public:
+    explicit Impl(JobSystem& job_system):
+      job_system_{ job_system } {}
+
+    ~Impl() = default;
+
+    void add(std::string name, Callback&& callback, std::vector<std::string> after, std::vector<std::string> before)
+    {
+      nodes_.push_back(Node{
+        .name = std::move(name),
+        .callback = std::move(callback),
+        .after = std::move(after),
+        .before = std::move(before),
+      });
+      dirty_ = true;
+    }
+
+    void operator()(App& app, const Time& time)
+    {
+      if (nodes_.empty()) {
+        return;
+      }
+      if (dirty_) {
+        build();
+      }
+
+      if (serial_fallback_) {
+        for (const auto& node: nodes_) {
+          node.callback(app, time);
+        }
+        return;
+      }
+
+      for (u32 i{ 0 }; i < nodes_.size(); ++i) {
+        remaining_[i].store(nodes_[i].dependency_count, std::memory_order_relaxed);
+      }
+
+      JobSystem::Counter counter{};
+      run_ = Run{ .app = &app, .time = &time, .counter = &counter };
+      for (const auto root: roots_) {
+        schedule(root);
+      }
+      job_system_.wait(counter);
+      run_ = {};
+
+      // Thrown on the game thread after the barrier, the same as if the callback had been a serial one
+      if (auto failure{ std::exchange(failure_, nullptr) }) {
+        std::rethrow_exception(failure);
+      }
+    }
+
+    [[nodiscard]] auto empty() const -> bool
+    {
+      return nodes_.empty();
+    }
+
+  private:
+    struct Node {
+      std::string name;
+      Callback callback;
+      std::vector<std::string> after{};
+      std::vector<std::string> before{};
+
+      // Built
+      std::vector<u32> successors{};
+      u32 dependency_count{ 0 };
+    };
+
+    // Shared by every job of the current run, so each job only has to capture this and its node index and
+    // stays within std::function's small buffer instead of allocating
+    struct Run {
+      App* app{ nullptr };
+      const Time* time{ nullptr };
+      JobSystem::Counter* counter{ nullptr };
+    };
+
+    JobSystem& job_system_;
+    Run run_{};
+    // First callback exception of the current run
+    std::mutex failure_mutex_;
+    std::exception_ptr failure_{ nullptr };
+    std::vector<Node> nodes_;
+    std::vector<u32> roots_;
+    unique<std::atomic<u32>[]> remaining_;
+    bool dirty_{ true };
+    bool serial_fallback_{ false };
+
+    void schedule(const u32 index)
+    {
+      // Successors are submitted before this job retires, so the counter can't reach zero early.
+      // The game thread is blocked on the stage barrier, so these are as frame critical as it gets.
+      job_system_.submit([this, index] {
+        try {
+          nodes_[index].callback(*run_.app, *run_.time);
+        } catch (...) {
+          // Successors still run, or they'd be silently skipped while the stage looks complete
+          std::scoped_lock lock{ failure_mutex_ };
+          if (!failure_) {
+            failure_ = std::current_exception();
+          }
+        }
+        for (const auto successor: nodes_[index].successors) {
+          if (remaining_[successor].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            schedule(successor);
+          }
+        }
+      }, run_.counter, JobSystem::Priority::High);
+    }
+
+    void build()
+    {
+      std::unordered_map<std::string, u32> indices;
+      for (u32 i{ 0 }; i < nodes_.size(); ++i) {
+        if (!nodes_[i].name.empty() && !indices.emplace(nodes_[i].name, i).second) {
+          Log::error(R"(Parallel stage callback "{}" registered twice, ordering will only target the first.)", nodes_[i].name);
+        }
+        nodes_[i].successors.clear();
+        nodes_[i].dependency_count = 0;
+      }
+
+      const auto add_edge = [&](const u32 from, const u32 to) {
+        nodes_[from].successors.push_back(to);
+        ++nodes_[to].dependency_count;
+      };
+      const auto find = [&](const std::string& name, const std::string& referrer) -> std::optional<u32> {
+        if (const auto it{ indices.find(name) }; it != indices.end()) {
+          return it->second;
+        }
+        Log::error(R"(Parallel stage callback "{}" is ordered against unknown callback "{}".)", referrer, name);
+        return std::nullopt;
+      };
+
+      for (u32 i{ 0 }; i < nodes_.size(); ++i) {
+        for (const auto& name: nodes_[i].after) {
+          if (const auto other{ find(name, nodes_[i].name) }) {
+            add_edge(*other, i);
+          }
+        }
+        for (const auto& name: nodes_[i].before) {
+          if (const auto other{ find(name, nodes_[i].name) }) {
+            add_edge(i, *other);
+          }
+        }
+      }
+
+      roots_.clear();
+      for (u32 i{ 0 }; i < nodes_.size(); ++i) {
+        if (nodes_[i].dependency_count == 0) {
+          roots_.push_back(i);
+        }
+      }
+
+      // Kahn's algorithm, only to make sure every node is reachable (i.e. there is no cycle)
+      std::vector<u32> in_degree(nodes_.size());
+      for (u32 i{ 0 }; i < nodes_.size(); ++i) {
+        in_degree[i] = nodes_[i].dependency_count;
+      }
+      std::vector<u32> ready{ roots_ };
+      u32 visited{ 0 };
+      while (!ready.empty()) {
+        const auto node{ ready.back() };
+        ready.pop_back();
+        ++visited;
+        for (const auto successor: nodes_[node].successors) {
+          if (--in_degree[successor] == 0) {
+            ready.push_back(successor);
+          }
+        }
+      }
+      serial_fallback_ = visited != nodes_.size();
+      if (serial_fallback_) {
+        Log::error("Parallel stage callbacks have a dependency cycle, running them serially in registration order.");
+      }
+
+      remaining_ = std::make_unique<std::atomic<u32>[]>(nodes_.size());
+      dirty_ = false;
+    }
+  };
+
+  //
+  //  ParallelStage
+  //
+
+  ParallelStage::ParallelStage(JobSystem& job_system):
+    p_impl_{ std::make_unique<Impl>(job_system) } {}
+
+  ParallelStage::~ParallelStage() = default;
+
+  void ParallelStage::add(std::string name, Callback&& callback, std::vector<std::string> after, std::vector<std::string> before)
+  {
+    p_impl_->add(std::move(name), std::move(callback), std::move(after), std::move(before));
+  }
+
+  void ParallelStage::operator()(App& app, const Time& time)
+  {
+    (*p_impl_)(app, time);
+  }
+
+  auto ParallelStage::empty() const -> bool
+  {
+    return p_impl_->empty();
+  }
+}
@@ -0,0 +1,33 @@
+//
+// The callbacks of one stage that opted into running in parallel. Each runs as a job as soon as everything
+// it was declared to run after has finished, and the stage only ends once all of them are done.
+//
+
+#pragma once
+
+#include "foxy/delegate.hpp"
+
+namespace fx {
+  class App;
+  class JobSystem;
+
+  class ParallelStage {
+  public:
+    using Callback = Delegate<void(App&, const Time&)>;
+
+    explicit ParallelStage(JobSystem& job_system);
+    ~ParallelStage();
+
+    // after/before name other parallel callbacks of the same stage
+    void add(std::string name, Callback&& callback, std::vector<std::string> after, std::vector<std::string> before);
+    // Runs every callback and waits for all of them (the end of stage barrier). If any threw, the first exception is
+    // rethrown once the rest have run.
+    void operator()(App& app, const Time& time);
+
+    [[nodiscard]] auto empty() const -> bool;
+
+  private:
+    class Impl;
+    unique<Impl> p_impl_;
+  };
+}
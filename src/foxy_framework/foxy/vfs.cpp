@@ -0,0 +1,211 @@
+#include "vfs.hpp"
+
+#include "archive.hpp"
+#include <kitsune/profiler.hpp>
+
+namespace fx {
+  class Vfs::Impl {
+  public:
+    auto mount_archive(const std::filesystem::path& archive_path, const std::filesystem::path& mount_point) -> bool
+    {
+      auto archive{ Archive::open(archive_path) };
+      if (!archive) {
+        return false;
+      }
+      Log::trace("Mounted {} at \"{}\"", archive_path.string(), archive::normalize_path(mount_point));
+      add_mount(Mount{ .prefix = archive::normalize_path(mount_point), .archive = std::move(archive) });
+      return true;
+    }
+
+    auto mount_directory(const std::filesystem::path& directory, const std::filesystem::path& mount_point) -> bool
+    {
+      if (!is_directory(directory)) {
+        Log::error("Can't mount {}, not a directory", directory.string());
+        return false;
+      }
+      Log::trace("Mounted {} at \"{}\"", directory.string(), archive::normalize_path(mount_point));
+      add_mount(Mount{ .prefix = archive::normalize_path(mount_point), .directory = directory });
+      return true;
+    }
+
+    [[nodiscard]] auto open(const std::filesystem::path& path) const -> std::optional<File>
+    {
+      FOXY_PROFILE_FUNCTION();
+      const auto normalized{ archive::normalize_path(path) };
+      std::shared_lock lock{ mounts_mutex_ };
+      for (const auto& mount: mounts_ | std::views::reverse) {
+        const auto relative{ strip_prefix(normalized, mount.prefix) };
+        if (!relative) {
+          continue;
+        }
+
+        if (mount.archive) {
+          const auto* entry{ mount.archive->find(*relative) };
+          if (!entry) {
+            continue;
+          }
+          File file;
+          if (entry->compression == archive::Compression::None) {
+            file.mapped_ = mount.archive->stored(*entry);
+            file.is_mapped_ = true;
+          } else if (!mount.archive->extract(*entry, file.owned_)) {
+            return std::nullopt;
+          }
+          return file;
+        }
+
+        const auto file_path{ mount.directory / *relative };
+        std::ifstream stream{ file_path, std::ios::binary | std::ios::ate };
+        if (!stream) {
+          continue;
+        }
+        File file;
+        file.owned_.resize(static_cast<std::size_t>(stream.tellg()));
+        stream.seekg(0);
+        if (!stream.read(reinterpret_cast<char*>(file.owned_.data()), static_cast<std::streamsize>(file.owned_.size()))) {
+          Log::error("Failed to read {}", file_path.string());
+          return std::nullopt;
+        }
+        return file;
+      }
+      return std::nullopt;
+    }
+
+    [[nodiscard]] auto exists(const std::filesystem::path& path) const -> bool
+    {
+      const auto normalized{ archive::normalize_path(path) };
+      std::shared_lock lock{ mounts_mutex_ };
+      return std::ranges::any_of(mounts_, [&](const Mount& mount) {
+        const auto relative{ strip_prefix(normalized, mount.prefix) };
+        if (!relative) {
+          return false;
+        }
+        return mount.archive ? mount.archive->find(*relative) != nullptr : is_regular_file(mount.directory / *relative);
+      });
+    }
+
+    [[nodiscard]] auto disk_path(const std::filesystem::path& path) const -> std::optional<std::filesystem::path>
+    {
+      const auto normalized{ archive::normalize_path(path) };
+      std::shared_lock lock{ mounts_mutex_ };
+      for (const auto& mount: mounts_ | std::views::reverse) {
+        const auto relative{ strip_prefix(normalized, mount.prefix) };
+        if (!relative) {
+          continue;
+        }
+        if (mount.archive) {
+          if (mount.archive->find(*relative)) {
+            return std::nullopt;
+          }
+        } else if (auto file_path{ mount.directory / *relative }; is_regular_file(file_path)) {
+          return file_path;
+        }
+      }
+      return std::nullopt;
+    }
+
+    [[nodiscard]] auto mount_count() const -> u32
+    {
+      std::shared_lock lock{ mounts_mutex_ };
+      return static_cast<u32>(mounts_.size());
+    }
+
+  private:
+    struct Mount {
+      std::string prefix;
+      // One or the other
+      unique<Archive> archive{};
+      std::filesystem::path directory{};
+    };
+
+    // Mounts happen at startup and lookups come from anywhere (asset loads on workers), so lookups share the lock
+    mutable std::shared_mutex mounts_mutex_;
+    std::vector<Mount> mounts_;
+
+    void add_mount(Mount&& mount)
+    {
+      std::unique_lock lock{ mounts_mutex_ };
+      mounts_.push_back(std::move(mount));
+    }
+
+    // The path relative to the mount, or nothing if it isn't under it
+    [[nodiscard]] static auto strip_prefix(const std::string_view path, const std::string_view prefix)
+      -> std::optional<std::string_view>
+    {
+      if (prefix.empty()) {
+        return path;
+      }
+      if (!path.starts_with(prefix) || path.size() <= prefix.size() || path[prefix.size()] != '/') {
+        return std::nullopt;
+      }
+      return path.substr(prefix.size() + 1);
+    }
+  };
+
+  //
+  //  Vfs::File
+  //
+
+  auto Vfs::File::bytes() const -> std::span<const std::byte>
+  {
+    return is_mapped_ ? mapped_ : std::span<const std::byte>{ owned_ };
+  }
+
+  auto Vfs::File::text() const -> std::string_view
+  {
+    const auto data{ bytes() };
+    return { reinterpret_cast<const char*>(data.data()), data.size() };
+  }
+
+  auto Vfs::File::mapped() const -> bool
+  {
+    return is_mapped_;
+  }
+
+  //
+  //  Vfs
+  //
+
+  Vfs::Vfs():
+    p_impl_{ std::make_unique<Impl>() } {}
+
+  Vfs::~Vfs() = default;
+
+  auto Vfs::mount_archive(const std::filesystem::path& archive_path, const std::filesystem::path& mount_point) -> bool
+  {
+    return p_impl_->mount_archive(archive_path, mount_point);
+  }
+
+  auto Vfs::mount_directory(const std::filesystem::path& directory, const std::filesystem::path& mount_point) -> bool
+  {
+    return p_impl_->mount_directory(directory, mount_point);
+  }
+
+  auto Vfs::open(const std::filesystem::path& path) const -> std::optional<File>
+  {
+    return p_impl_->open(path);
+  }
+
+  auto Vfs::read_text(const std::filesystem::path& path) const -> std::optional<std::string>
+  {
+    if (const auto file{ p_impl_->open(path) }) {
+      return std::string{ file->text() };
+    }
+    return std::nullopt;
+  }
+
+  auto Vfs::exists(const std::filesystem::path& path) const -> bool
+  {
+    return p_impl_->exists(path);
+  }
+
+  auto Vfs::disk_path(const std::filesystem::path& path) const -> std::optional<std::filesystem::path>
+  {
+    return p_impl_->disk_path(path);
+  }
+
+  auto Vfs::mount_count() const -> u32
+  {
+    return p_impl_->mount_count();
+  }
+}
@@ -0,0 +1,49 @@
+//
+// One view over every place resources can come from. Packed archives and loose directories are mounted under
+// virtual paths, and lookups go through the mounts newest first. Reads from an uncompressed archive entry are
+// spans straight into the mapped archive: no open, no read, no copy.
+//
+
+#pragma once
+
+namespace fx {
+  class Vfs {
+  public:
+    class File {
+    public:
+      [[nodiscard]] auto bytes() const -> std::span<const std::byte>;
+      [[nodiscard]] auto text() const -> std::string_view;
+      // True when bytes() points straight into a mapped archive, otherwise the file owns a copy
+      [[nodiscard]] auto mapped() const -> bool;
+
+    private:
+      friend class Vfs;
+      std::span<const std::byte> mapped_{};
+      std::vector<std::byte> owned_{};
+      bool is_mapped_{ false };
+    };
+
+    Vfs();
+    ~Vfs();
+
+    Vfs(const Vfs& other) = delete;
+    auto operator=(const Vfs& other) -> Vfs& = delete;
+
+    // The archive's contents show up under mount_point, e.g. res/foxy.pak mounted at res/foxy
+    auto mount_archive(const std::filesystem::path& archive_path, const std::filesystem::path& mount_point = {}) -> bool;
+    auto mount_directory(const std::filesystem::path& directory, const std::filesystem::path& mount_point = {}) -> bool;
+
+    // Mapped archive data stays valid for as long as the Vfs does
+    [[nodiscard]] auto open(const std::filesystem::path& path) const -> std::optional<File>;
+    [[nodiscard]] auto read_text(const std::filesystem::path& path) const -> std::optional<std::string>;
+    [[nodiscard]] auto exists(const std::filesystem::path& path) const -> bool;
+    // Where the file really is when it resolves to a loose file, nothing when it's packed or missing. Lets
+    // callers hand loose files to AsyncIO instead of blocking on open().
+    [[nodiscard]] auto disk_path(const std::filesystem::path& path) const -> std::optional<std::filesystem::path>;
+    [[nodiscard]] auto mount_count() const -> u32;
+
+  private:
+    class Impl;
+    unique<Impl> p_impl_;
+  };
+}
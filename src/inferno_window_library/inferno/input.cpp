@@ -0,0 +1,125 @@
+#include "input.hpp"
+
+namespace fx {
+  namespace {
+    // GLFW_RELEASE / GLFW_PRESS, spelled out so this file doesn't need GLFW
+    constexpr u8 action_release{ 0 };
+    constexpr u8 action_press{ 1 };
+  }
+
+  void InputState::begin_frame()
+  {
+    keys_pressed_.reset();
+    keys_released_.reset();
+    buttons_pressed_.reset();
+    buttons_released_.reset();
+    cursor_dx_ = cursor_dy_ = 0.f;
+    scroll_dx_ = scroll_dy_ = 0.f;
+  }
+
+  void InputState::apply(const InputRecord& record)
+  {
+    last_event_time_ = record.timestamp;
+
+    switch (record.type) {
+      case InputRecord::Type::Key: {
+        if (record.code < 0 || record.code >= key_count) {
+          break;
+        }
+        mods_ = record.mods;
+        if (record.action == action_press) {
+          keys_down_.set(record.code);
+          keys_pressed_.set(record.code);
+        } else if (record.action == action_release) {
+          keys_down_.reset(record.code);
+          keys_released_.set(record.code);
+        }
+        break;
+      }
+      case InputRecord::Type::MouseButton: {
+        if (record.code < 0 || record.code >= mouse_button_count) {
+          break;
+        }
+        mods_ = record.mods;
+        if (record.action == action_press) {
+          buttons_down_.set(record.code);
+          buttons_pressed_.set(record.code);
+        } else if (record.action == action_release) {
+          buttons_down_.reset(record.code);
+          buttons_released_.set(record.code);
+        }
+        break;
+      }
+      case InputRecord::Type::Cursor: {
+        if (has_cursor_) {
+          cursor_dx_ += record.x - cursor_x_;
+          cursor_dy_ += record.y - cursor_y_;
+        }
+        cursor_x_ = record.x;
+        cursor_y_ = record.y;
+        has_cursor_ = true;
+        break;
+      }
+      case InputRecord::Type::Scroll: {
+        scroll_dx_ += record.x;
+        scroll_dy_ += record.y;
+        break;
+      }
+    }
+  }
+
+  auto InputState::key_down(const i32 key) const -> bool
+  {
+    return key >= 0 && key < key_count && keys_down_.test(key);
+  }
+
+  auto InputState::key_pressed(const i32 key) const -> bool
+  {
+    return key >= 0 && key < key_count && keys_pressed_.test(key);
+  }
+
+  auto InputState::key_released(const i32 key) const -> bool
+  {
+    return key >= 0 && key < key_count && keys_released_.test(key);
+  }
+
+  auto InputState::mouse_down(const i32 button) const -> bool
+  {
+    return button >= 0 && button < mouse_button_count && buttons_down_.test(button);
+  }
+
+  auto InputState::mouse_pressed(const i32 button) const -> bool
+  {
+    return button >= 0 && button < mouse_button_count && buttons_pressed_.test(button);
+  }
+
+  auto InputState::mouse_released(const i32 button) const -> bool
+  {
+    return button >= 0 && button < mouse_button_count && buttons_released_.test(button);
+  }
+
+  auto InputState::mods() const -> u16
+  {
+    return mods_;
+  }
+
+  auto InputState::cursor() const -> std::pair<float, float>
+  {
+    return { cursor_x_, cursor_y_ };
+  }
+
+  auto InputState::cursor_delta() const -> std::pair<float, float>
+  {
+    return { cursor_dx_, cursor_dy_ };
+  }
+
+  auto InputState::scroll_delta() const -> std::pair<float, float>
+  {
+    return { scroll_dx_, scroll_dy_ };
+  }
+
+  auto InputState::last_event_time() const -> i64
+  {
+    return last_event_time_;
+  }
+}
@@ -0,0 +1,68 @@
+//
+// Input crosses from the main thread (where GLFW callbacks fire) to the game thread as compact, timestamped
+// records, and the game thread folds them into an InputState snapshot. Key and button codes are GLFW's.
+//
+
+#pragma once
+
+namespace fx {
+  struct InputRecord {
+    enum class Type: u8 {
+      Key,
+      MouseButton,
+      Cursor,
+      Scroll,
+    };
+
+    Type type{ Type::Key };
+    // GLFW_RELEASE, GLFW_PRESS or GLFW_REPEAT
+    u8 action{ 0 };
+    u16 mods{ 0 };
+    i32 code{ 0 };
+    // Cursor position or scroll offset
+    float x{ 0.f };
+    float y{ 0.f };
+    // Steady clock time the callback fired, in nanoseconds
+    i64 timestamp{ 0 };
+  };
+
+  class InputState {
+  public:
+    static constexpr inline i32 key_count{ 512 };
+    static constexpr inline i32 mouse_button_count{ 8 };
+
+    // Clears the per-drain edges (pressed/released, deltas) before a new batch of records is applied
+    void begin_frame();
+    void apply(const InputRecord& record);
+
+    [[nodiscard]] auto key_down(i32 key) const -> bool;
+    [[nodiscard]] auto key_pressed(i32 key) const -> bool;
+    [[nodiscard]] auto key_released(i32 key) const -> bool;
+    [[nodiscard]] auto mouse_down(i32 button) const -> bool;
+    [[nodiscard]] auto mouse_pressed(i32 button) const -> bool;
+    [[nodiscard]] auto mouse_released(i32 button) const -> bool;
+    [[nodiscard]] auto mods() const -> u16;
+    [[nodiscard]] auto cursor() const -> std::pair<float, float>;
+    [[nodiscard]] auto cursor_delta() const -> std::pair<float, float>;
+    [[nodiscard]] auto scroll_delta() const -> std::pair<float, float>;
+    // Timestamp of the newest record applied so far
+    [[nodiscard]] auto last_event_time() const -> i64;
+
+  private:
+    std::bitset<key_count> keys_down_{};
+    std::bitset<key_count> keys_pressed_{};
+    std::bitset<key_count> keys_released_{};
+    std::bitset<mouse_button_count> buttons_down_{};
+    std::bitset<mouse_button_count> buttons_pressed_{};
+    std::bitset<mouse_button_count> buttons_released_{};
+    u16 mods_{ 0 };
+    float cursor_x_{ 0.f };
+    float cursor_y_{ 0.f };
+    float cursor_dx_{ 0.f };
+    float cursor_dy_{ 0.f };
+    float scroll_dx_{ 0.f };
+    float scroll_dy_{ 0.f };
+    bool has_cursor_{ false };
+    i64 last_event_time_{ 0 };
+  };
+}
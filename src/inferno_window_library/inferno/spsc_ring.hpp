@@ -0,0 +1,61 @@
+//
+// Fixed capacity, lock-free ring buffer for exactly one producer thread and one consumer thread.
+// Nothing is allocated after construction; pushing into a full ring fails instead of blocking.
+//
+// Sources:
+// https://rigtorp.se/ringbuffer/
+//
+
+#pragma once
+
+namespace fx {
+  template<class T, std::size_t Capacity>
+  class SpscRing {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "SpscRing capacity must be a power of two.");
+    static_assert(std::is_trivially_copyable_v<T>, "SpscRing only holds trivially copyable records.");
+
+  public:
+    // Producer only
+    auto try_push(const T& value) -> bool
+    {
+      const auto head{ head_.load(std::memory_order_relaxed) };
+      if (head - cached_tail_ == Capacity) {
+        cached_tail_ = tail_.load(std::memory_order_acquire);
+        if (head - cached_tail_ == Capacity) {
+          return false;
+        }
+      }
+      slots_[head & (Capacity - 1)] = value;
+      head_.store(head + 1, std::memory_order_release);
+      return true;
+    }
+
+    // Consumer only
+    auto try_pop(T& value) -> bool
+    {
+      const auto tail{ tail_.load(std::memory_order_relaxed) };
+      if (tail == cached_head_) {
+        cached_head_ = head_.load(std::memory_order_acquire);
+        if (tail == cached_head_) {
+          return false;
+        }
+      }
+      value = slots_[tail & (Capacity - 1)];
+      tail_.store(tail + 1, std::memory_order_release);
+      return true;
+    }
+
+    [[nodiscard]] static constexpr auto capacity() -> std::size_t
+    {
+      return Capacity;
+    }
+
+  private:
+    std::array<T, Capacity> slots_{};
+    // Producer and consumer indices live on separate cache lines, each next to its own cached copy of the other
+    alignas(64) std::atomic<std::size_t> head_{ 0 };
+    std::size_t cached_tail_{ 0 };
+    alignas(64) std::atomic<std::size_t> tail_{ 0 };
+    std::size_t cached_head_{ 0 };
+  };
+}
@@ -1,6 +1,8 @@
 #include "window.hpp"
 
 #include "glfw/context.hpp"
+#include "input.hpp"
+#include "spsc_ring.hpp"
 
 namespace fx {
   class Window::Impl: types::SingleInstance<Window> {
@@ -34,6 +36,10 @@ namespace fx {
       set_vsync(create_info.vsync);
       set_fullscreen(create_info.fullscreen);
       set_callbacks();
+      // The callback keeps it current from here on
+      ivec2 framebuffer_size{};
+      glfwGetFramebufferSize(glfw_window_.get(), &framebuffer_size.x, &framebuffer_size.y);
+      state_.set_framebuffer_size(framebuffer_size.x, framebuffer_size.y);
 
       Log::trace("Window ready.");
     }
@@ -47,16 +53,42 @@ namespace fx {
     {
       state_.framebuffer_resized_event.add_callback(callback);
     }
+    
+    void add_visibility_callback(const std::function<void()>& callback)
+    {
+      state_.visibility_event.add_callback(callback);
+    }
 
     void poll_events()
     {
       glfwPollEvents();
     }
+    
+    void wait_events(const double timeout_secs)
+    {
+      glfwWaitEventsTimeout(timeout_secs);
+    }
+    
+    void wake()
+    {
+      glfwPostEmptyEvent();
+    }
+    
+    void drain_input(InputState& state)
+    {
+      state.begin_frame();
+      InputRecord record{};
+      while (state_.input_queue.try_pop(record)) {
+        state.apply(record);
+      }
+    }
 
     void close()
     {
       Log::trace("Window close requested.");
       state_.should_continue = false;
+      // close() may come from another thread while the main thread is asleep in wait_events
+      glfwPostEmptyEvent();
     }
 
     void set_icon(i8* image, i32 width, i32 height)
@@ -104,6 +136,7 @@ namespace fx {
         glfwShowWindow(glfw_window_.get());
       }
       state_.hidden = hidden;
+      state_.visibility_event();
     }
 
     [[nodiscard]] auto title() const -> std::string { return state_.title; }
@@ -112,6 +145,13 @@ namespace fx {
     [[nodiscard]] auto vsync() const -> bool { return state_.vsync; }
     [[nodiscard]] auto fullscreen() const -> bool { return state_.vsync; }
     [[nodiscard]] auto hidden() const -> bool { return state_.hidden; }
+    [[nodiscard]] auto focused() const -> bool { return state_.focused; }
+    [[nodiscard]] auto minimized() const -> bool { return state_.minimized || state_.empty_framebuffer; }
+    [[nodiscard]] auto framebuffer_size() const -> ivec2
+    {
+      const auto packed{ state_.framebuffer_size.load(std::memory_order_relaxed) };
+      return { static_cast<i32>(packed >> 32), static_cast<i32>(packed & 0xFFFFFFFF) };
+    }
     [[nodiscard]] auto should_continue() const -> const bool& { return state_.should_continue; }
     
   private:
@@ -122,19 +162,41 @@ namespace fx {
       bool vsync;
       bool fullscreen;
       bool borderless;
-      bool hidden;
+      // Written by the main thread, read by the game and render threads
+      std::atomic<bool> hidden;
+      std::atomic<bool> focused{ true };
+      std::atomic<bool> minimized{ false };
+      std::atomic<bool> empty_framebuffer{ false };
+      // Width and height packed together so readers never see half of a resize
+      std::atomic<u64> framebuffer_size{ 0 };
       ivec2 cursor_pos{}, cursor_pos_prev{}, cursor_delta{};
       bool should_continue{ true };
 
       // Window events
       Event<> close_event;
       Event<i32, i32> framebuffer_resized_event;
-      // Input events
-      Event<> key_event;
-      Event<> modifier_event;
-      Event<> mouse_event;
-      Event<> cursor_event;
-      Event<> scroll_event;
+      Event<> visibility_event;
+      // Input, produced by GLFW callbacks on the main thread and drained by the game thread
+      SpscRing<InputRecord, 1024> input_queue;
+      u64 dropped_input{ 0 };
+      
+      void set_framebuffer_size(const i32 width, const i32 height)
+      {
+        framebuffer_size.store(
+          static_cast<u64>(static_cast<u32>(width)) << 32 | static_cast<u32>(height),
+          std::memory_order_relaxed
+        );
+      }
+      
+      void push_input(InputRecord record)
+      {
+        record.timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch()
+        ).count();
+        if (!input_queue.try_push(record) && dropped_input++ == 0) {
+          Log::warn("Input queue full, dropping input until the game thread catches up.");
+        }
+      }
 
 //      explicit State(const WindowCreateInfo& properties)
 //        : title{ properties.title },
@@ -166,7 +228,62 @@ namespace fx {
   
       glfwSetFramebufferSizeCallback(glfw_window_.get(), [](GLFWwindow* window, i32 width, i32 height) {
         auto ptr = reinterpret_cast<State*>(glfwGetWindowUserPointer(window));
+        ptr->set_framebuffer_size(width, height);
         ptr->framebuffer_resized_event(width, height);
+        if (const bool empty{ width == 0 || height == 0 }; empty != ptr->empty_framebuffer) {
+          ptr->empty_framebuffer = empty;
+          ptr->visibility_event();
+        }
+      });
+      
+      glfwSetWindowFocusCallback(glfw_window_.get(), [](GLFWwindow* window, i32 focused) {
+        auto ptr = reinterpret_cast<State*>(glfwGetWindowUserPointer(window));
+        ptr->focused = focused == GLFW_TRUE;
+        ptr->visibility_event();
+      });
+      
+      glfwSetWindowIconifyCallback(glfw_window_.get(), [](GLFWwindow* window, i32 iconified) {
+        auto ptr = reinterpret_cast<State*>(glfwGetWindowUserPointer(window));
+        ptr->minimized = iconified == GLFW_TRUE;
+        ptr->visibility_event();
+      });
+      
+      glfwSetKeyCallback(glfw_window_.get(), [](GLFWwindow* window, i32 key, i32 scancode, i32 action, i32 mods) {
+        auto ptr = reinterpret_cast<State*>(glfwGetWindowUserPointer(window));
+        ptr->push_input(InputRecord{
+          .type = InputRecord::Type::Key,
+          .action = static_cast<u8>(action),
+          .mods = static_cast<u16>(mods),
+          .code = key,
+        });
+      });
+      
+      glfwSetMouseButtonCallback(glfw_window_.get(), [](GLFWwindow* window, i32 button, i32 action, i32 mods) {
+        auto ptr = reinterpret_cast<State*>(glfwGetWindowUserPointer(window));
+        ptr->push_input(InputRecord{
+          .type = InputRecord::Type::MouseButton,
+          .action = static_cast<u8>(action),
+          .mods = static_cast<u16>(mods),
+          .code = button,
+        });
+      });
+      
+      glfwSetCursorPosCallback(glfw_window_.get(), [](GLFWwindow* window, double x, double y) {
+        auto ptr = reinterpret_cast<State*>(glfwGetWindowUserPointer(window));
+        ptr->push_input(InputRecord{
+          .type = InputRecord::Type::Cursor,
+          .x = static_cast<float>(x),
+          .y = static_cast<float>(y),
+        });
+      });
+      
+      glfwSetScrollCallback(glfw_window_.get(), [](GLFWwindow* window, double x, double y) {
+        auto ptr = reinterpret_cast<State*>(glfwGetWindowUserPointer(window));
+        ptr->push_input(InputRecord{
+          .type = InputRecord::Type::Scroll,
+          .x = static_cast<float>(x),
+          .y = static_cast<float>(y),
+        });
       });
     }
   };
@@ -185,11 +302,31 @@ namespace fx {
     p_impl_->add_framebuffer_resized_callback(callback);
   }
 
+  void Window::add_visibility_callback(const std::function<void()>& callback)
+  {
+    p_impl_->add_visibility_callback(callback);
+  }
+
   void Window::poll_events()
   {
     p_impl_->poll_events();
   }
 
+  void Window::wait_events(const double timeout_secs)
+  {
+    p_impl_->wait_events(timeout_secs);
+  }
+
+  void Window::wake()
+  {
+    p_impl_->wake();
+  }
+
+  void Window::drain_input(InputState& state)
+  {
+    p_impl_->drain_input(state);
+  }
+
   void Window::close()
   {
     p_impl_->close();
@@ -260,6 +397,21 @@ namespace fx {
     return p_impl_->hidden();
   }
 
+  auto Window::focused() const -> bool
+  {
+    return p_impl_->focused();
+  }
+
+  auto Window::minimized() const -> bool
+  {
+    return p_impl_->minimized();
+  }
+
+  auto Window::framebuffer_size() const -> ivec2
+  {
+    return p_impl_->framebuffer_size();
+  }
+
   auto Window::should_continue() const -> const bool&
   {
     return p_impl_->should_continue();
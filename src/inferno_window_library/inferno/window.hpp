@@ -9,6 +9,7 @@ class GLFWwindow;
 namespace fx {
   template<class... Args>
   class Event;
+  class InputState;
 
   class Window {
   public:
@@ -25,8 +26,16 @@ namespace fx {
     ~Window();
   
     void add_framebuffer_resized_callback(const std::function<void(i32, i32)>& callback);
+    // Called on the main thread whenever the window gains/loses focus, is minimized/restored, or is hidden/shown
+    void add_visibility_callback(const std::function<void()>& callback);
 
     void poll_events();
+    // Main thread: sleeps until an OS event arrives, wake() is called, or timeout_secs passes
+    void wait_events(double timeout_secs);
+    // Any thread: interrupts wait_events on the main thread
+    void wake();
+    // Game thread: applies every input record queued since the last drain. Lock-free and allocation free.
+    void drain_input(InputState& state);
     void close();
     
     void set_icon(i8* image, i32 width, i32 height);
@@ -43,6 +52,11 @@ namespace fx {
     [[nodiscard]] auto vsync() const -> bool;
     [[nodiscard]] auto fullscreen() const -> bool;
     [[nodiscard]] auto hidden() const -> bool;
+    // Focus and minimized state are safe to read from any thread. A zero sized framebuffer counts as minimized.
+    [[nodiscard]] auto focused() const -> bool;
+    [[nodiscard]] auto minimized() const -> bool;
+    // In pixels, as last reported to the main thread. Safe to read from any thread.
+    [[nodiscard]] auto framebuffer_size() const -> ivec2;
     [[nodiscard]] auto should_continue() const -> const bool&;
   
     auto operator*() -> shared<GLFWwindow>&;
@@ -0,0 +1,45 @@
+#include "cpu_time.hpp"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace fx::kitsune {
+  auto thread_cpu_time() -> std::chrono::nanoseconds
+  {
+    #ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user)) {
+      return std::chrono::nanoseconds{ 0 };
+    }
+    const auto to_u64{ [](const FILETIME& time) {
+      return (static_cast<u64>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+    } };
+    // FILETIME counts 100ns intervals
+    return std::chrono::nanoseconds{ (to_u64(kernel) + to_u64(user)) * 100 };
+    #else
+    timespec time{};
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0) {
+      return std::chrono::nanoseconds{ 0 };
+    }
+    return std::chrono::seconds{ time.tv_sec } + std::chrono::nanoseconds{ time.tv_nsec };
+    #endif
+  }
+
+  ThreadCpuMeter::ThreadCpuMeter():
+    wall_begin_{ std::chrono::steady_clock::now() },
+    cpu_begin_{ thread_cpu_time() } {}
+
+  auto ThreadCpuMeter::sample() const -> Sample
+  {
+    const std::chrono::duration<double, std::milli> wall{ std::chrono::steady_clock::now() - wall_begin_ };
+    const std::chrono::duration<double, std::milli> cpu{ thread_cpu_time() - cpu_begin_ };
+    return Sample{
+      .wall_ms = wall.count(),
+      .cpu_ms = cpu.count(),
+      .utilization = wall.count() > 0. ? cpu.count() / wall.count() : 0.,
+    };
+  }
+}
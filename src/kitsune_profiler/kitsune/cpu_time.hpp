@@ -0,0 +1,29 @@
+//
+// Per-thread CPU time, for telling apart threads that are busy from threads that are merely awake.
+//
+
+#pragma once
+
+namespace fx::kitsune {
+  // CPU time consumed by the calling thread so far (user + kernel)
+  [[nodiscard]] auto thread_cpu_time() -> std::chrono::nanoseconds;
+
+  // Measures how much of a core the calling thread used between construction and sample()
+  class ThreadCpuMeter {
+  public:
+    struct Sample {
+      double wall_ms;
+      double cpu_ms;
+      // cpu / wall, 1.0 means a whole core was kept busy
+      double utilization;
+    };
+
+    ThreadCpuMeter();
+
+    [[nodiscard]] auto sample() const -> Sample;
+
+  private:
+    std::chrono::steady_clock::time_point wall_begin_;
+    std::chrono::nanoseconds cpu_begin_;
+  };
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+/*----------------------
+  FOXY LIBRARIES
+----------------------*/
+#include "koyote/utilities.hpp"
+
+// /*----------------------
+//   VENDOR LIBRARIES
+// ----------------------*/
+// #ifdef _WIN32
+// #include <windows.h>
+// #endif // _WIN32
+
+/*----------------------
+  STD LIBRARY
+----------------------*/
+// IO
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <filesystem>
+// Utilities
+#include <compare>
+#include <cstdlib>
+#include <algorithm>
+#include <numeric>
+#include <utility>
+#include <functional>
+#include <memory>
+#include <ranges>
+#include <future>
+#include <ctime>
+#include <chrono>
+#include <random>
+#include <stdexcept>
+#include <limits>
+#include <typeinfo>
+#include <format>
+#include <string_view>
+// Threading
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <stop_token>
+// Data Structures
+#include <variant>
+#include <bitset>
+#include <string>
+#include <array>
+#include <vector>
+#include <list>
+#include <queue>
+#include <stack>
+#include <deque>
+#include <set>
+#include <unordered_set>
+#include <map>
+#include <unordered_map>
\ No newline at end of file
@@ -0,0 +1,3 @@
+#pragma once
+
+#include "includes.hpp"
\ No newline at end of file
@@ -0,0 +1,229 @@
+#include "profiler.hpp"
+
+namespace fx::kitsune {
+  namespace {
+    struct Zone {
+      const char* name;
+      Clock::time_point begin;
+      Clock::time_point end;
+    };
+
+    // Single producer (the owning thread), single consumer (whoever holds the registry lock while flushing)
+    class ThreadBuffer {
+    public:
+      static constexpr inline u64 capacity{ 1 << 16 };
+
+      explicit ThreadBuffer(const u32 id):
+        id_{ id } {}
+
+      void push(const Zone& zone)
+      {
+        const auto head{ head_.load(std::memory_order_relaxed) };
+        if (head - tail_.load(std::memory_order_acquire) >= capacity) {
+          dropped_.fetch_add(1, std::memory_order_relaxed);
+          return;
+        }
+        zones_[head & (capacity - 1)] = zone;
+        head_.store(head + 1, std::memory_order_release);
+      }
+
+      template<class F>
+      void drain(F&& consume)
+      {
+        const auto tail{ tail_.load(std::memory_order_relaxed) };
+        const auto head{ head_.load(std::memory_order_acquire) };
+        for (auto i{ tail }; i != head; ++i) {
+          consume(zones_[i & (capacity - 1)]);
+        }
+        tail_.store(head, std::memory_order_release);
+      }
+
+      [[nodiscard]] auto id() const -> u32
+      {
+        return id_;
+      }
+
+      [[nodiscard]] auto take_dropped() -> u64
+      {
+        return dropped_.exchange(0, std::memory_order_relaxed);
+      }
+
+      // Guarded by the registry lock
+      std::string name{};
+      bool named_in_session{ false };
+
+    private:
+      const u32 id_;
+      std::array<Zone, capacity> zones_{};
+      alignas(64) std::atomic<u64> head_{ 0 };
+      alignas(64) std::atomic<u64> tail_{ 0 };
+      std::atomic<u64> dropped_{ 0 };
+    };
+
+    struct Registry {
+      std::mutex mutex;
+      std::vector<shared<ThreadBuffer>> buffers;
+      std::unordered_set<std::string> interned;
+      std::ofstream file;
+      bool first_event{ true };
+      Clock::time_point epoch{ Clock::now() };
+      std::atomic<bool> active{ false };
+    };
+
+    auto registry() -> Registry&
+    {
+      static Registry registry{};
+      return registry;
+    }
+
+    // Buffers are co-owned by the registry so zones from threads that already exited can still be flushed
+    thread_local shared<ThreadBuffer> thread_buffer{ nullptr };
+
+    auto local_buffer() -> ThreadBuffer&
+    {
+      if (!thread_buffer) {
+        auto& reg{ registry() };
+        std::scoped_lock lock{ reg.mutex };
+        thread_buffer = std::make_shared<ThreadBuffer>(static_cast<u32>(reg.buffers.size()));
+        reg.buffers.push_back(thread_buffer);
+      }
+      return *thread_buffer;
+    }
+
+    void write_json_string(std::ostream& stream, const std::string_view string)
+    {
+      stream << '"';
+      for (const char c: string) {
+        if (c == '"' || c == '\\') {
+          stream << '\\';
+        }
+        stream << c;
+      }
+      stream << '"';
+    }
+
+    void write_separator(Registry& reg)
+    {
+      if (!reg.first_event) {
+        reg.file << ",\n";
+      }
+      reg.first_event = false;
+    }
+
+    void flush_locked(Registry& reg)
+    {
+      if (!reg.file.is_open()) {
+        return;
+      }
+
+      for (const auto& buffer: reg.buffers) {
+        if (!buffer->named_in_session && !buffer->name.empty()) {
+          write_separator(reg);
+          reg.file << R"({"name":"thread_name","ph":"M","pid":0,"tid":)" << buffer->id() << R"(,"args":{"name":)";
+          write_json_string(reg.file, buffer->name);
+          reg.file << "}}";
+          buffer->named_in_session = true;
+        }
+
+        buffer->drain([&](const Zone& zone) {
+          // Zones recorded before the session started (or across a restart) are stale
+          if (zone.begin < reg.epoch) {
+            return;
+          }
+          const std::chrono::duration<double, std::micro> begin{ zone.begin - reg.epoch };
+          const std::chrono::duration<double, std::micro> duration{ zone.end - zone.begin };
+          write_separator(reg);
+          reg.file << R"({"name":)";
+          write_json_string(reg.file, zone.name);
+          reg.file << R"(,"cat":"foxy","ph":"X","pid":0,"tid":)" << buffer->id()
+                   << R"(,"ts":)" << begin.count() << R"(,"dur":)" << duration.count() << '}';
+        });
+
+        if (const auto dropped{ buffer->take_dropped() }; dropped > 0) {
+          Log::warn("Profiler dropped {} zones on thread {}, flush more often.", dropped, buffer->id());
+        }
+      }
+    }
+  }
+
+  void Profiler::begin_session(const std::filesystem::path& path)
+  {
+    auto& reg{ registry() };
+    std::scoped_lock lock{ reg.mutex };
+    if (reg.file.is_open()) {
+      flush_locked(reg);
+      reg.file << "\n]}\n";
+      reg.file.close();
+    }
+
+    reg.file.open(path);
+    if (!reg.file) {
+      Log::error("Failed to open profiler trace {}", path.string());
+      reg.active.store(false, std::memory_order_relaxed);
+      return;
+    }
+
+    reg.file << std::fixed << std::setprecision(3);
+    reg.file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    reg.first_event = true;
+    reg.epoch = Clock::now();
+    for (const auto& buffer: reg.buffers) {
+      buffer->named_in_session = false;
+    }
+    reg.active.store(true, std::memory_order_relaxed);
+    Log::trace("Profiler session started: {}", path.string());
+  }
+
+  void Profiler::flush()
+  {
+    auto& reg{ registry() };
+    std::scoped_lock lock{ reg.mutex };
+    flush_locked(reg);
+    reg.file.flush();
+  }
+
+  void Profiler::end_session()
+  {
+    auto& reg{ registry() };
+    std::scoped_lock lock{ reg.mutex };
+    reg.active.store(false, std::memory_order_relaxed);
+    if (!reg.file.is_open()) {
+      return;
+    }
+
+    flush_locked(reg);
+    reg.file << "\n]}\n";
+    reg.file.close();
+    Log::trace("Profiler session ended.");
+  }
+
+  auto Profiler::active() -> bool
+  {
+    return registry().active.load(std::memory_order_relaxed);
+  }
+
+  void Profiler::set_thread_name(const std::string_view name)
+  {
+    auto& buffer{ local_buffer() };
+    auto& reg{ registry() };
+    std::scoped_lock lock{ reg.mutex };
+    buffer.name = name;
+    buffer.named_in_session = false;
+  }
+
+  auto Profiler::intern(const std::string_view name) -> const char*
+  {
+    auto& reg{ registry() };
+    std::scoped_lock lock{ reg.mutex };
+    // unordered_set nodes never move, so the pointer stays valid for the life of the program
+    return reg.interned.emplace(name).first->c_str();
+  }
+
+  void Profiler::record(const char* name, const Clock::time_point begin, const Clock::time_point end)
+  {
+    if (!active()) {
+      return;
+    }
+    local_buffer().push(Zone{ .name = name, .begin = begin, .end = end });
+  }
+}
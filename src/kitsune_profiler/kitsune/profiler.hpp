@@ -0,0 +1,68 @@
+//
+// Kitsune, Foxy's scoped zone profiler. Each thread records zones into its own lock-free ring buffer,
+// and a flush drains every ring into a Chrome trace (open it in chrome://tracing or ui.perfetto.dev).
+// All of it compiles away unless FOXY_PROFILING is defined.
+//
+// Sources:
+// https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU
+// https://www.youtube.com/watch?v=xlAH4dbMVnU
+//
+
+#pragma once
+
+namespace fx::kitsune {
+  using Clock = std::chrono::steady_clock;
+
+  class Profiler {
+  public:
+    // Starts writing a trace to path, replacing any session that is already running
+    static void begin_session(const std::filesystem::path& path);
+    // Drains every thread's ring into the session file. Rings that fill up between flushes drop zones.
+    static void flush();
+    static void end_session();
+    [[nodiscard]] static auto active() -> bool;
+
+    static void set_thread_name(std::string_view name);
+    // Zones only store the name pointer, so dynamic names need to be interned once up front
+    [[nodiscard]] static auto intern(std::string_view name) -> const char*;
+    static void record(const char* name, Clock::time_point begin, Clock::time_point end);
+  };
+
+  class ScopedZone {
+  public:
+    explicit ScopedZone(const char* name):
+      name_{ name },
+      begin_{ Clock::now() } {}
+
+    ~ScopedZone()
+    {
+      Profiler::record(name_, begin_, Clock::now());
+    }
+
+    ScopedZone(const ScopedZone&) = delete;
+    auto operator=(const ScopedZone&) -> ScopedZone& = delete;
+
+  private:
+    const char* name_;
+    Clock::time_point begin_;
+  };
+}
+
+#define FOXY_PROFILE_CONCAT_IMPL(a, b) a##b
+#define FOXY_PROFILE_CONCAT(a, b) FOXY_PROFILE_CONCAT_IMPL(a, b)
+
+#if defined(FOXY_PROFILING)
+  #define FOXY_PROFILE_SCOPE(name) const ::fx::kitsune::ScopedZone FOXY_PROFILE_CONCAT(foxy_profile_zone_, __LINE__){ name }
+  #define FOXY_PROFILE_FUNCTION() FOXY_PROFILE_SCOPE(__func__)
+  #define FOXY_PROFILE_THREAD(name) ::fx::kitsune::Profiler::set_thread_name(name)
+  #define FOXY_PROFILE_BEGIN_SESSION(path) ::fx::kitsune::Profiler::begin_session(path)
+  #define FOXY_PROFILE_FLUSH() ::fx::kitsune::Profiler::flush()
+  #define FOXY_PROFILE_END_SESSION() ::fx::kitsune::Profiler::end_session()
+#else
+  #define FOXY_PROFILE_SCOPE(name) ((void)0)
+  #define FOXY_PROFILE_FUNCTION() ((void)0)
+  #define FOXY_PROFILE_THREAD(name) ((void)0)
+  #define FOXY_PROFILE_BEGIN_SESSION(path) ((void)0)
+  #define FOXY_PROFILE_FLUSH() ((void)0)
+  #define FOXY_PROFILE_END_SESSION() ((void)0)
+#endif
@@ -0,0 +1,663 @@
+#include "async_io.hpp"
+
+#include <kitsune/profiler.hpp>
+
+#if defined(__linux__)
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace fx {
+  namespace {
+    struct ReadOp {
+      std::filesystem::path path;
+      AsyncIO::Completion completion;
+      JobSystem::Priority priority;
+
+      std::error_code error{};
+      // Either a registered buffer (fixed_index >= 0) or heap memory owned here
+      unique<std::byte[]> heap{};
+      i32 fixed_index{ -1 };
+      std::byte* data{ nullptr };
+      u64 size{ 0 };
+      u64 offset{ 0 };
+      i32 fd{ -1 };
+    };
+
+    #if defined(__linux__)
+    // Just enough of liburing to drive a ring through the raw syscalls, so there's nothing extra to link
+    class Ring {
+    public:
+      Ring() = default;
+
+      ~Ring()
+      {
+        if (sqes_) {
+          munmap(sqes_, sqes_size_);
+        }
+        if (cq_ptr_ && cq_ptr_ != sq_ptr_) {
+          munmap(cq_ptr_, cq_size_);
+        }
+        if (sq_ptr_) {
+          munmap(sq_ptr_, sq_size_);
+        }
+        if (fd_ >= 0) {
+          close(fd_);
+        }
+      }
+
+      Ring(const Ring& other) = delete;
+      auto operator=(const Ring& other) -> Ring& = delete;
+
+      [[nodiscard]] auto init(const u32 entries) -> bool
+      {
+        io_uring_params params{};
+        fd_ = static_cast<i32>(syscall(__NR_io_uring_setup, entries, &params));
+        if (fd_ < 0) {
+          Log::debug("io_uring_setup failed: {}", std::strerror(errno));
+          return false;
+        }
+        // IORING_OP_READ landed in 5.6, fast poll in 5.7: close enough to a feature probe
+        if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_FAST_POLL)) {
+          Log::debug("io_uring too old for async reads");
+          return false;
+        }
+
+        sq_size_ = params.sq_off.array + params.sq_entries * sizeof(u32);
+        cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+        sq_ptr_ = mmap(nullptr, sq_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+        if (sq_ptr_ == MAP_FAILED) {
+          sq_ptr_ = nullptr;
+          return false;
+        }
+        cq_ptr_ = sq_ptr_;
+        sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(
+          mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES)
+        );
+        if (sqes_ == MAP_FAILED) {
+          sqes_ = nullptr;
+          return false;
+        }
+
+        auto* sq{ static_cast<std::byte*>(sq_ptr_) };
+        sq_head_ = reinterpret_cast<u32*>(sq + params.sq_off.head);
+        sq_tail_ = reinterpret_cast<u32*>(sq + params.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<u32*>(sq + params.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<u32*>(sq + params.sq_off.array);
+        sq_entries_ = params.sq_entries;
+        auto* cq{ static_cast<std::byte*>(cq_ptr_) };
+        cq_head_ = reinterpret_cast<u32*>(cq + params.cq_off.head);
+        cq_tail_ = reinterpret_cast<u32*>(cq + params.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<u32*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+      }
+
+      [[nodiscard]] auto fd() const -> i32
+      {
+        return fd_;
+      }
+
+      [[nodiscard]] auto space() const -> u32
+      {
+        return sq_entries_ - (*sq_tail_ - std::atomic_ref{ *sq_head_ }.load(std::memory_order_acquire));
+      }
+
+      // Check space() first. The entry is handed to the kernel on the next submit_and_wait().
+      [[nodiscard]] auto next_sqe() -> io_uring_sqe&
+      {
+        const auto tail{ *sq_tail_ };
+        const auto index{ tail & sq_mask_ };
+        auto& sqe{ sqes_[index] };
+        std::memset(&sqe, 0, sizeof(sqe));
+        sq_array_[index] = index;
+        std::atomic_ref{ *sq_tail_ }.store(tail + 1, std::memory_order_release);
+        ++to_submit_;
+        return sqe;
+      }
+
+      // Submits everything queued in one syscall and sleeps until at least wait_count completions are in
+      [[nodiscard]] auto submit_and_wait(const u32 wait_count) -> bool
+      {
+        while (true) {
+          const auto consumed{ syscall(__NR_io_uring_enter, fd_, to_submit_, wait_count, IORING_ENTER_GETEVENTS, nullptr, 0) };
+          if (consumed >= 0) {
+            to_submit_ -= static_cast<u32>(consumed);
+            return true;
+          }
+          if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            Log::error("io_uring_enter failed: {}", std::strerror(errno));
+            return false;
+          }
+        }
+      }
+
+      template<class Fn>
+      void for_each_completion(Fn&& fn)
+      {
+        auto head{ *cq_head_ };
+        for (const auto tail{ std::atomic_ref{ *cq_tail_ }.load(std::memory_order_acquire) }; head != tail; ++head) {
+          const auto& cqe{ cqes_[head & cq_mask_] };
+          fn(cqe.user_data, cqe.res);
+        }
+        std::atomic_ref{ *cq_head_ }.store(head, std::memory_order_release);
+      }
+
+    private:
+      i32 fd_{ -1 };
+      void* sq_ptr_{ nullptr };
+      void* cq_ptr_{ nullptr };
+      std::size_t sq_size_{ 0 };
+      std::size_t cq_size_{ 0 };
+      io_uring_sqe* sqes_{ nullptr };
+      std::size_t sqes_size_{ 0 };
+      u32* sq_head_{ nullptr };
+      u32* sq_tail_{ nullptr };
+      u32* sq_array_{ nullptr };
+      u32 sq_mask_{ 0 };
+      u32 sq_entries_{ 0 };
+      u32* cq_head_{ nullptr };
+      u32* cq_tail_{ nullptr };
+      u32 cq_mask_{ 0 };
+      io_uring_cqe* cqes_{ nullptr };
+      u32 to_submit_{ 0 };
+    };
+    #endif
+  }
+
+  class AsyncIO::Impl {
+  public:
+    Impl(JobSystem& jobs, const CreateInfo& create_info):
+      jobs_{ jobs },
+      create_info_{ create_info }
+    {
+      #if defined(__linux__)
+      if (!create_info.force_fallback && start_uring()) {
+        backend_ = Backend::IoUring;
+      }
+      #endif
+      if (backend_ == Backend::ThreadPool) {
+        for (u32 i{ 0 }; i < std::max(create_info.fallback_threads, 1U); ++i) {
+          threads_.emplace_back([this, i](const std::stop_token& stop_token) {
+            fallback_loop(stop_token, i);
+          });
+        }
+      }
+      Log::trace(
+        "Async I/O ready: {} ({} registered buffers)",
+        backend_ == Backend::IoUring ? "io_uring" : "thread pool", free_fixed_.size()
+      );
+    }
+
+    ~Impl()
+    {
+      wait_idle();
+      for (auto& thread: threads_) {
+        thread.request_stop();
+      }
+      wake();
+      threads_.clear();
+      #if defined(__linux__)
+      if (wake_fd_ >= 0) {
+        close(wake_fd_);
+      }
+      #endif
+      if (fixed_memory_) {
+        ::operator delete(fixed_memory_, std::align_val_t{ fixed_alignment });
+      }
+    }
+
+    void read(const std::filesystem::path& path, Completion&& completion, const JobSystem::Priority priority)
+    {
+      pending_.fetch_add(1, std::memory_order_relaxed);
+      {
+        std::scoped_lock lock{ requests_mutex_ };
+        requests_.push_back(std::make_shared<ReadOp>(ReadOp{
+          .path = path,
+          .completion = std::move(completion),
+          .priority = priority,
+        }));
+      }
+      wake();
+    }
+
+    void wait_idle()
+    {
+      std::unique_lock lock{ idle_mutex_ };
+      idle_.wait(lock, [this] { return pending_.load(std::memory_order_acquire) == 0; });
+    }
+
+    [[nodiscard]] auto jobs() -> JobSystem&
+    {
+      return jobs_;
+    }
+
+    [[nodiscard]] auto backend() const -> Backend
+    {
+      return backend_;
+    }
+
+    [[nodiscard]] auto pending() const -> u32
+    {
+      return pending_.load(std::memory_order_relaxed);
+    }
+
+  private:
+    static constexpr inline std::size_t fixed_alignment{ 4096 };
+
+    JobSystem& jobs_;
+    const CreateInfo create_info_;
+    Backend backend_{ Backend::ThreadPool };
+    // Reads queued, in flight, or whose completion hasn't finished yet. The last one out decrements and
+    // notifies under idle_mutex_, which wait_idle (and so the destructor) takes too: notifying after letting go
+    // of it could touch a destroyed Impl.
+    std::atomic<u32> pending_{ 0 };
+    std::mutex idle_mutex_;
+    std::condition_variable idle_;
+
+    std::mutex requests_mutex_;
+    std::condition_variable_any requests_ready_;
+    std::vector<shared<ReadOp>> requests_;
+
+    std::byte* fixed_memory_{ nullptr };
+    std::mutex fixed_mutex_;
+    std::vector<i32> free_fixed_;
+
+    #if defined(__linux__)
+    Ring ring_;
+    i32 wake_fd_{ -1 };
+    #endif
+
+    // Declared last so the threads are joined before anything they touch goes away
+    std::vector<std::jthread> threads_;
+
+    void wake()
+    {
+      #if defined(__linux__)
+      if (backend_ == Backend::IoUring) {
+        const u64 one{ 1 };
+        [[maybe_unused]] const auto written{ write(wake_fd_, &one, sizeof(one)) };
+        return;
+      }
+      #endif
+      {
+        std::scoped_lock lock{ requests_mutex_ };
+      }
+      requests_ready_.notify_all();
+    }
+
+    [[nodiscard]] auto take_requests() -> std::vector<shared<ReadOp>>
+    {
+      std::scoped_lock lock{ requests_mutex_ };
+      return std::exchange(requests_, {});
+    }
+
+    // Hands the data to a job at the request's priority, then recycles the buffer once the completion is done
+    void complete(shared<ReadOp>&& op)
+    {
+      #if defined(__linux__)
+      if (op->fd >= 0) {
+        close(std::exchange(op->fd, -1));
+      }
+      #endif
+      const auto priority{ op->priority };
+      jobs_.submit([this, op = std::move(op)] {
+        try {
+          op->completion(Result{ .error = op->error, .data = { op->data, static_cast<std::size_t>(op->size) } });
+        } catch (const std::exception& e) {
+          Log::error("Read completion for {} failed: {}", op->path.string(), e.what());
+        }
+        release_fixed(op->fixed_index);
+        std::scoped_lock lock{ idle_mutex_ };
+        if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+          idle_.notify_all();
+        }
+      }, nullptr, priority);
+    }
+
+    [[nodiscard]] auto acquire_fixed(const u64 size) -> i32
+    {
+      if (size > create_info_.registered_buffer_size) {
+        return -1;
+      }
+      std::scoped_lock lock{ fixed_mutex_ };
+      if (free_fixed_.empty()) {
+        return -1;
+      }
+      const auto index{ free_fixed_.back() };
+      free_fixed_.pop_back();
+      return index;
+    }
+
+    void release_fixed(const i32 index)
+    {
+      if (index >= 0) {
+        std::scoped_lock lock{ fixed_mutex_ };
+        free_fixed_.push_back(index);
+      }
+    }
+
+    void allocate_buffer(ReadOp& op)
+    {
+      op.fixed_index = acquire_fixed(op.size);
+      if (op.fixed_index >= 0) {
+        op.data = fixed_memory_ + static_cast<std::size_t>(op.fixed_index) * create_info_.registered_buffer_size;
+      } else {
+        op.heap = std::make_unique_for_overwrite<std::byte[]>(op.size);
+        op.data = op.heap.get();
+      }
+    }
+
+    void fallback_loop(const std::stop_token& stop_token, const u32 index)
+    {
+      const auto thread_name{ "io " + std::to_string(index) };
+      Log::set_thread_name(thread_name);
+      FOXY_PROFILE_THREAD(thread_name);
+
+      while (true) {
+        shared<ReadOp> op;
+        {
+          std::unique_lock lock{ requests_mutex_ };
+          if (!requests_ready_.wait(lock, stop_token, [this] { return !requests_.empty(); })) {
+            return;
+          }
+          op = std::move(requests_.front());
+          requests_.erase(requests_.begin());
+        }
+
+        FOXY_PROFILE_SCOPE("Blocking read");
+        std::ifstream file{ op->path, std::ios::binary | std::ios::ate };
+        if (!file) {
+          op->error = std::make_error_code(std::errc::no_such_file_or_directory);
+        } else {
+          op->size = static_cast<u64>(file.tellg());
+          allocate_buffer(*op);
+          file.seekg(0);
+          if (!file.read(reinterpret_cast<char*>(op->data), static_cast<std::streamsize>(op->size))) {
+            op->error = std::make_error_code(std::errc::io_error);
+          }
+        }
+        complete(std::move(op));
+      }
+    }
+
+    #if defined(__linux__)
+    static constexpr inline u64 wake_tag{ 0 };
+
+    [[nodiscard]] auto start_uring() -> bool
+    {
+      if (!ring_.init(std::max(create_info_.queue_depth, 2U))) {
+        return false;
+      }
+      wake_fd_ = eventfd(0, EFD_CLOEXEC);
+      if (wake_fd_ < 0) {
+        return false;
+      }
+      register_buffers();
+      threads_.emplace_back([this](const std::stop_token& stop_token) {
+        uring_loop(stop_token);
+      });
+      return true;
+    }
+
+    void register_buffers()
+    {
+      const auto count{ create_info_.registered_buffers };
+      const auto size{ static_cast<std::size_t>(create_info_.registered_buffer_size) };
+      if (count == 0 || size == 0) {
+        return;
+      }
+
+      fixed_memory_ = static_cast<std::byte*>(::operator new(count * size, std::align_val_t{ fixed_alignment }));
+      std::vector<iovec> iovecs(count);
+      for (u32 i{ 0 }; i < count; ++i) {
+        iovecs[i] = iovec{ .iov_base = fixed_memory_ + i * size, .iov_len = size };
+      }
+      // Usually fails on a tight RLIMIT_MEMLOCK, in which case every read just goes to the heap
+      if (syscall(__NR_io_uring_register, ring_.fd(), IORING_REGISTER_BUFFERS, iovecs.data(), count) < 0) {
+        Log::debug("Couldn't register io_uring buffers: {}", std::strerror(errno));
+        ::operator delete(fixed_memory_, std::align_val_t{ fixed_alignment });
+        fixed_memory_ = nullptr;
+        return;
+      }
+      for (i32 i{ static_cast<i32>(count) - 1 }; i >= 0; --i) {
+        free_fixed_.push_back(i);
+      }
+    }
+
+    void arm_wake()
+    {
+      auto& sqe{ ring_.next_sqe() };
+      sqe.opcode = IORING_OP_POLL_ADD;
+      sqe.fd = wake_fd_;
+      sqe.poll32_events = POLLIN;
+      sqe.user_data = wake_tag;
+    }
+
+    // Opens the file and sizes its buffer. Returns false when the op is already finished (failed or empty).
+    [[nodiscard]] auto prepare(ReadOp& op) -> bool
+    {
+      op.fd = open(op.path.c_str(), O_RDONLY | O_CLOEXEC);
+      if (op.fd < 0) {
+        op.error = std::error_code{ errno, std::system_category() };
+        return false;
+      }
+      struct stat info{};
+      if (fstat(op.fd, &info) != 0) {
+        op.error = std::error_code{ errno, std::system_category() };
+        return false;
+      }
+      op.size = static_cast<u64>(info.st_size);
+      if (op.size == 0) {
+        return false;
+      }
+      allocate_buffer(op);
+      return true;
+    }
+
+    void push_read(const u64 id, const ReadOp& op)
+    {
+      auto& sqe{ ring_.next_sqe() };
+      sqe.opcode = op.fixed_index >= 0 ? IORING_OP_READ_FIXED : IORING_OP_READ;
+      sqe.fd = op.fd;
+      sqe.addr = reinterpret_cast<u64>(op.data + op.offset);
+      sqe.len = static_cast<u32>(std::min<u64>(op.size - op.offset, 1 << 30));
+      sqe.off = op.offset;
+      sqe.buf_index = static_cast<u16>(std::max(op.fixed_index, 0));
+      sqe.user_data = id;
+    }
+
+    void uring_loop(const std::stop_token& stop_token)
+    {
+      Log::set_thread_name("io");
+      FOXY_PROFILE_THREAD("io");
+
+      std::deque<shared<ReadOp>> backlog;
+      std::unordered_map<u64, shared<ReadOp>> in_flight;
+      u64 next_id{ wake_tag + 1 };
+      arm_wake();
+
+      while (true) {
+        // Whatever came in since the last pass goes into the same submission
+        for (auto& op: take_requests()) {
+          if (prepare(*op)) {
+            backlog.push_back(std::move(op));
+          } else {
+            complete(std::move(op));
+          }
+        }
+        // One entry stays free for re-arming the wake poll
+        while (!backlog.empty() && in_flight.size() < create_info_.queue_depth && ring_.space() > 1) {
+          push_read(next_id, *backlog.front());
+          in_flight.emplace(next_id++, std::move(backlog.front()));
+          backlog.pop_front();
+        }
+
+        if (stop_token.stop_requested() && in_flight.empty() && backlog.empty()) {
+          return;
+        }
+
+        {
+          FOXY_PROFILE_SCOPE("io_uring wait");
+          if (!ring_.submit_and_wait(1)) {
+            blocking_loop(stop_token, std::move(backlog), std::move(in_flight));
+            return;
+          }
+        }
+
+        ring_.for_each_completion([&](const u64 id, const i32 result) {
+          if (id == wake_tag) {
+            u64 count{};
+            [[maybe_unused]] const auto bytes{ ::read(wake_fd_, &count, sizeof(count)) };
+            arm_wake();
+            return;
+          }
+
+          auto node{ in_flight.extract(id) };
+          auto& op{ node.mapped() };
+          if (result == -EINTR || result == -EAGAIN) {
+            backlog.push_front(std::move(op));
+          } else if (result < 0) {
+            op->error = std::error_code{ -result, std::system_category() };
+            complete(std::move(op));
+          } else if (result == 0 || (op->offset += static_cast<u64>(result)) >= op->size) {
+            // A zero length read means the file shrank under us, hand over what's there
+            op->size = std::min(op->size, op->offset);
+            complete(std::move(op));
+          } else {
+            // Short read, go again for the rest
+            backlog.push_front(std::move(op));
+          }
+        });
+      }
+    }
+
+    // The ring is unusable, so every read left (and every one still to come) is finished here with plain
+    // blocking reads rather than leaving its caller, and wait_idle(), waiting on a completion that never comes
+    void blocking_loop(
+      const std::stop_token& stop_token,
+      std::deque<shared<ReadOp>>&& backlog,
+      std::unordered_map<u64, shared<ReadOp>>&& in_flight
+    )
+    {
+      Log::warn("io_uring stopped working, falling back to blocking reads on the I/O thread");
+      // Reads the kernel may or may not have done are redone from the last offset we know of, into the same buffer
+      for (auto& [id, op]: in_flight) {
+        backlog.push_back(std::move(op));
+      }
+      in_flight.clear();
+
+      while (true) {
+        for (auto& op: take_requests()) {
+          if (prepare(*op)) {
+            backlog.push_back(std::move(op));
+          } else {
+            complete(std::move(op));
+          }
+        }
+        for (; !backlog.empty(); backlog.pop_front()) {
+          FOXY_PROFILE_SCOPE("Blocking read");
+          auto& op{ *backlog.front() };
+          while (op.offset < op.size) {
+            const auto result{ pread(op.fd, op.data + op.offset, op.size - op.offset, static_cast<off_t>(op.offset)) };
+            if (result < 0 && errno == EINTR) {
+              continue;
+            }
+            if (result < 0) {
+              op.error = std::error_code{ errno, std::system_category() };
+              break;
+            }
+            if (result == 0) {
+              op.size = op.offset;
+              break;
+            }
+            op.offset += static_cast<u64>(result);
+          }
+          complete(std::move(backlog.front()));
+        }
+
+        if (stop_token.stop_requested()) {
+          return;
+        }
+        // wake() still signals the eventfd, so this blocks until there's something new (or stop)
+        u64 count{};
+        [[maybe_unused]] const auto bytes{ ::read(wake_fd_, &count, sizeof(count)) };
+      }
+    }
+    #endif
+  };
+
+  //
+  //  AsyncIO
+  //
+
+  AsyncIO::AsyncIO(JobSystem& jobs):
+    AsyncIO{ jobs, CreateInfo{} } {}
+
+  AsyncIO::AsyncIO(JobSystem& jobs, const CreateInfo& create_info):
+    p_impl_{ std::make_unique<Impl>(jobs, create_info) } {}
+
+  AsyncIO::~AsyncIO() = default;
+
+  void AsyncIO::read(const std::filesystem::path& path, Completion&& completion, const JobSystem::Priority priority)
+  {
+    p_impl_->read(path, std::move(completion), priority);
+  }
+
+  auto AsyncIO::read(std::filesystem::path path) -> Task<std::vector<std::byte>>
+  {
+    struct Awaiter {
+      AsyncIO& io;
+      JobSystem& jobs;
+      const std::filesystem::path& path;
+      std::vector<std::byte> bytes{};
+      std::error_code error{};
+
+      [[nodiscard]] auto await_ready() const noexcept -> bool { return false; }
+
+      void await_suspend(const std::coroutine_handle<> handle)
+      {
+        io.read(path, [this, handle](const Result& result) {
+          error = result.error;
+          bytes.assign(result.data.begin(), result.data.end());
+          // Resumed as its own job so the buffer is recycled without waiting on the rest of the coroutine
+          jobs.submit([handle] { handle.resume(); });
+        });
+      }
+
+      auto await_resume() -> std::vector<std::byte>
+      {
+        if (error) {
+          throw std::system_error{ error, path.string() };
+        }
+        return std::move(bytes);
+      }
+    };
+
+    co_return co_await Awaiter{ .io = *this, .jobs = p_impl_->jobs(), .path = path };
+  }
+
+  void AsyncIO::wait_idle()
+  {
+    p_impl_->wait_idle();
+  }
+
+  auto AsyncIO::backend() const -> Backend
+  {
+    return p_impl_->backend();
+  }
+
+  auto AsyncIO::pending() const -> u32
+  {
+    return p_impl_->pending();
+  }
+}
@@ -0,0 +1,71 @@
+//
+// Asynchronous file reads that hand their results to the job system. On Linux the reads go through io_uring:
+// one I/O thread batches every queued read into a single submission and reaps completions as they land, and
+// files that fit are read straight into buffers registered with the kernel up front. Everywhere else (or when
+// io_uring is unavailable) a few threads do plain blocking reads instead.
+//
+// Sources:
+// https://kernel.dk/io_uring.pdf
+// https://unixism.net/loti/
+//
+
+#pragma once
+
+#include "job_system.hpp"
+#include "task.hpp"
+
+namespace fx {
+  class AsyncIO {
+  public:
+    enum class Backend {
+      IoUring,
+      ThreadPool,
+    };
+
+    struct CreateInfo {
+      // Reads in flight at once
+      u32 queue_depth{ 64 };
+      // Buffers pinned and registered with io_uring once, files that fit skip a kernel copy
+      u32 registered_buffers{ 8 };
+      u32 registered_buffer_size{ 1024 * 1024 };
+      // Threads doing blocking reads when io_uring isn't there
+      u32 fallback_threads{ 2 };
+      bool force_fallback{ false };
+    };
+
+    struct Result {
+      std::error_code error{};
+      // Only valid until the completion returns, registered buffers get recycled right after
+      std::span<const std::byte> data{};
+    };
+
+    using Completion = std::function<void(const Result&)>;
+
+    explicit AsyncIO(JobSystem& jobs);
+    AsyncIO(JobSystem& jobs, const CreateInfo& create_info);
+    // Finishes every queued read and runs its completion first
+    ~AsyncIO();
+
+    AsyncIO(const AsyncIO& other) = delete;
+    auto operator=(const AsyncIO& other) -> AsyncIO& = delete;
+
+    // Reads the whole file, then runs the completion as a job at the given priority
+    void read(
+      const std::filesystem::path& path,
+      Completion&& completion,
+      JobSystem::Priority priority = JobSystem::Priority::Background
+    );
+    // For coroutines: auto bytes{ co_await io.read(path) }. Throws std::system_error when the read fails. Tasks
+    // start lazily, so the path is taken by value and lives in the coroutine frame.
+    [[nodiscard]] auto read(std::filesystem::path path) -> Task<std::vector<std::byte>>;
+    // Blocks until every read queued so far has completed and its completion has run
+    void wait_idle();
+
+    [[nodiscard]] auto backend() const -> Backend;
+    [[nodiscard]] auto pending() const -> u32;
+
+  private:
+    class Impl;
+    unique<Impl> p_impl_;
+  };
+}
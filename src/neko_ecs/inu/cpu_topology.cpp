@@ -0,0 +1,215 @@
+#include "cpu_topology.hpp"
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace fx {
+  namespace {
+    // "0-3,8,10-11" style lists used all over sysfs
+    [[nodiscard]] auto parse_cpu_list(const std::string& list) -> std::vector<u32>
+    {
+      std::vector<u32> cpus;
+      std::stringstream stream{ list };
+      std::string range;
+      while (std::getline(stream, range, ',')) {
+        if (range.empty() || !std::isdigit(static_cast<unsigned char>(range.front()))) {
+          continue;
+        }
+        const auto dash{ range.find('-') };
+        const auto first{ static_cast<u32>(std::stoul(range.substr(0, dash))) };
+        const auto last{ dash == std::string::npos ? first : static_cast<u32>(std::stoul(range.substr(dash + 1))) };
+        for (auto cpu{ first }; cpu <= last; ++cpu) {
+          cpus.push_back(cpu);
+        }
+      }
+      return cpus;
+    }
+
+    [[nodiscard]] auto read_line(const std::filesystem::path& path) -> std::optional<std::string>
+    {
+      std::ifstream file{ path };
+      std::string line;
+      if (!file || !std::getline(file, line)) {
+        return std::nullopt;
+      }
+      return line;
+    }
+
+    [[nodiscard]] auto read_u32(const std::filesystem::path& path) -> std::optional<u32>
+    {
+      const auto line{ read_line(path) };
+      if (!line || line->empty()) {
+        return std::nullopt;
+      }
+      return static_cast<u32>(std::stoul(*line));
+    }
+
+    [[nodiscard]] auto flat_topology() -> CpuTopology
+    {
+      CpuTopology topology{};
+      const auto count{ std::max(std::thread::hardware_concurrency(), 1U) };
+      for (u32 i{ 0 }; i < count; ++i) {
+        topology.cpus.push_back(CpuTopology::Cpu{ .id = i, .core = i });
+      }
+      return topology;
+    }
+
+    #if defined(__linux__)
+    [[nodiscard]] auto sysfs_topology() -> std::optional<CpuTopology>
+    {
+      const std::filesystem::path root{ "/sys/devices/system/cpu" };
+      const auto online{ read_line(root / "online") };
+      if (!online) {
+        return std::nullopt;
+      }
+
+      // Ids sysfs hands out are only unique per package (core) or are cpu lists (caches), so map them down
+      std::map<std::pair<u32, u32>, u32> core_ids;
+      std::map<std::string, u32> l3_ids;
+      std::map<u32, u32> numa_of_cpu;
+      // Kernels built without NUMA support have no node directory at all, which just means a single node. The
+      // error_code overload leaves the iterator at the end instead of throwing.
+      std::error_code error;
+      const std::filesystem::directory_iterator nodes{
+        "/sys/devices/system/node", std::filesystem::directory_options::skip_permission_denied, error
+      };
+      for (const auto& entry: nodes) {
+        const auto name{ entry.path().filename().string() };
+        if (!name.starts_with("node") || name.size() == 4 || !std::isdigit(static_cast<unsigned char>(name[4]))) {
+          continue;
+        }
+        const auto node{ static_cast<u32>(std::stoul(name.substr(4))) };
+        if (const auto list{ read_line(entry.path() / "cpulist") }) {
+          for (const auto cpu: parse_cpu_list(*list)) {
+            numa_of_cpu[cpu] = node;
+          }
+        }
+      }
+
+      CpuTopology topology{};
+      for (const auto id: parse_cpu_list(*online)) {
+        const auto cpu_dir{ root / ("cpu" + std::to_string(id)) };
+        const auto package{ read_u32(cpu_dir / "topology/physical_package_id").value_or(0) };
+        const auto core{ read_u32(cpu_dir / "topology/core_id").value_or(id) };
+
+        // index3 is the L3 on x86; fall back to the package when the cache isn't described
+        auto l3_key{ "package " + std::to_string(package) };
+        for (u32 index{ 0 }; index < 8; ++index) {
+          const auto cache_dir{ cpu_dir / ("cache/index" + std::to_string(index)) };
+          const auto level{ read_u32(cache_dir / "level") };
+          if (!level) {
+            break;
+          }
+          if (*level == 3) {
+            l3_key = read_line(cache_dir / "shared_cpu_list").value_or(l3_key);
+            break;
+          }
+        }
+
+        topology.cpus.push_back(CpuTopology::Cpu{
+          .id = id,
+          .core = core_ids.try_emplace({ package, core }, static_cast<u32>(core_ids.size())).first->second,
+          .l3 = l3_ids.try_emplace(l3_key, static_cast<u32>(l3_ids.size())).first->second,
+          .numa_node = numa_of_cpu.contains(id) ? numa_of_cpu[id] : 0,
+          .package = package,
+        });
+      }
+
+      if (topology.cpus.empty()) {
+        return std::nullopt;
+      }
+      return topology;
+    }
+    #endif
+  }
+
+  auto CpuTopology::detect() -> CpuTopology
+  {
+    #if defined(__linux__)
+    try {
+      if (auto topology{ sysfs_topology() }) {
+        return std::move(*topology);
+      }
+    } catch (const std::exception& e) {
+      Log::warn("Couldn't read CPU topology from sysfs: {}", e.what());
+    }
+    #endif
+    return flat_topology();
+  }
+
+  auto CpuTopology::physical_core_count() const -> u32
+  {
+    std::set<u32> cores;
+    for (const auto& cpu: cpus) {
+      cores.insert(cpu.core);
+    }
+    return static_cast<u32>(cores.size());
+  }
+
+  auto CpuTopology::placement_order() const -> std::vector<u32>
+  {
+    // SMT rank: 0 for the first logical cpu seen on a core, 1 for its sibling, ...
+    std::map<u32, u32> seen_per_core;
+    std::vector<std::pair<u32, const Cpu*>> ranked;
+    for (const auto& cpu: cpus) {
+      ranked.emplace_back(seen_per_core[cpu.core]++, &cpu);
+    }
+    std::ranges::stable_sort(ranked, [](const auto& a, const auto& b) {
+      return std::tie(a.first, a.second->numa_node, a.second->l3, a.second->core)
+           < std::tie(b.first, b.second->numa_node, b.second->l3, b.second->core);
+    });
+
+    std::vector<u32> order;
+    order.reserve(ranked.size());
+    for (const auto& [rank, cpu]: ranked) {
+      order.push_back(cpu->id);
+    }
+    return order;
+  }
+
+  auto CpuTopology::distance(const u32 cpu_a, const u32 cpu_b) const -> u32
+  {
+    const auto* a{ find(cpu_a) };
+    const auto* b{ find(cpu_b) };
+    if (!a || !b) {
+      return 4;
+    }
+    if (a->core == b->core) {
+      return 0;
+    }
+    if (a->l3 == b->l3) {
+      return 1;
+    }
+    if (a->numa_node == b->numa_node) {
+      return 2;
+    }
+    return a->package == b->package ? 3 : 4;
+  }
+
+  auto CpuTopology::find(const u32 cpu_id) const -> const Cpu*
+  {
+    const auto it{ std::ranges::lower_bound(cpus, cpu_id, {}, &Cpu::id) };
+    return it != cpus.end() && it->id == cpu_id ? &*it : nullptr;
+  }
+
+  auto pin_current_thread(const u32 cpu_id) -> bool
+  {
+    #if defined(_WIN32)
+    if (cpu_id >= 64) {
+      return false; // Processor groups beyond the first aren't handled
+    }
+    return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR{ 1 } << cpu_id) != 0;
+    #elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu_id, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+    #else
+    return false;
+    #endif
+  }
+}
@@ -0,0 +1,40 @@
+//
+// Which logical CPUs share a core, an L3 (a CCX on Zen), and a NUMA node, so the job system can place workers
+// one per physical core and keep stealing close to home. Read from sysfs on Linux; elsewhere every logical CPU
+// is treated as its own core on a single shared cache.
+//
+// Sources:
+// https://www.kernel.org/doc/html/latest/admin-guide/cputopology.html
+// https://www.kernel.org/doc/Documentation/ABI/testing/sysfs-devices-system-cpu
+//
+
+#pragma once
+
+namespace fx {
+  struct CpuTopology {
+    struct Cpu {
+      u32 id{ 0 };
+      // Globally unique ids (not the per-package ids sysfs reports), so cpus can be compared directly
+      u32 core{ 0 };
+      u32 l3{ 0 };
+      u32 numa_node{ 0 };
+      u32 package{ 0 };
+    };
+
+    // Sorted by id, online cpus only
+    std::vector<Cpu> cpus{};
+
+    [[nodiscard]] static auto detect() -> CpuTopology;
+
+    [[nodiscard]] auto physical_core_count() const -> u32;
+    // One logical cpu per physical core, grouped by L3 then NUMA node, followed by the SMT siblings in the same
+    // order. Taking a prefix of this spreads threads over real cores before doubling up on hyperthreads.
+    [[nodiscard]] auto placement_order() const -> std::vector<u32>;
+    // 0 same core, 1 same L3, 2 same NUMA node, 3 same package, 4 anything else
+    [[nodiscard]] auto distance(u32 cpu_a, u32 cpu_b) const -> u32;
+    [[nodiscard]] auto find(u32 cpu_id) const -> const Cpu*;
+  };
+
+  // Restricts the calling thread to one logical cpu. Returns false where unsupported or when the OS refuses.
+  auto pin_current_thread(u32 cpu_id) -> bool;
+}
@@ -3,25 +3,487 @@
 //
 
 #include "job_system.hpp"
+#include "cpu_topology.hpp"
+
+#include <kitsune/profiler.hpp>
 
 namespace fx {
-  // class JobSystem::Impl {
-  // public:
-  //   Impl() {
+  namespace {
+    // Index of the worker running on this thread, so jobs spawned from jobs stay on the local queue
+    thread_local i32 worker_index{ -1 };
+    // Set while this thread runs a background job, which then gives up its background slot whenever it waits
+    thread_local bool in_background_job{ false };
+  }
+
+  class JobSystem::Impl {
+  public:
+    explicit Impl(const CreateInfo& create_info):
+      main_thread_{ std::this_thread::get_id() }
+    {
+      const auto worker_count{ std::max(create_info.worker_count, 1U) };
+      Log::trace("Starting job system with {} workers...", worker_count);
+      active_workers_ = worker_count;
+      background_limit_ = create_info.background_workers != 0
+        ? std::min(create_info.background_workers, worker_count)
+        : std::max(worker_count, 2U) - 1;
+
+      place_workers(worker_count, create_info);
+      for (u32 i{ 0 }; i < worker_count; ++i) {
+        queues_.push_back(std::make_unique<WorkerQueue>());
+      }
+      for (u32 i{ 0 }; i < worker_count; ++i) {
+        workers_.emplace_back([this, i](const std::stop_token& stop_token) {
+          worker_loop(stop_token, i);
+        });
+      }
+    }
+
+    ~Impl()
+    {
+      Log::trace("Stopping job system...");
+      for (auto& worker: workers_) {
+        worker.request_stop();
+      }
+      {
+        std::scoped_lock lock{ sleep_mutex_ };
+      }
+      wake_.notify_all();
+      workers_.clear();
+    }
+
+    Impl(const Impl& other) = delete;
+    auto operator=(const Impl& other) -> Impl& = delete;
+
+    void submit(Job&& job, Counter* counter, const Priority priority)
+    {
+      if (counter) {
+        counter->pending_.fetch_add(1, std::memory_order_relaxed);
+      }
+      const auto level{ static_cast<std::size_t>(priority) };
+
+      const auto queue_index{
+        worker_index >= 0
+          ? static_cast<u32>(worker_index)
+          : next_queue_.fetch_add(1, std::memory_order_relaxed) % static_cast<u32>(queues_.size())
+      };
+      {
+        auto& queue{ *queues_[queue_index] };
+        std::scoped_lock lock{ queue.mutex };
+        queue.tasks[level].push_back(Task{ .job = std::move(job), .counter = counter });
+      }
+
+      {
+        std::scoped_lock lock{ sleep_mutex_ };
+        ++queued_[level];
+      }
+      // A parked worker (or one at the background cap) would swallow a lone notification without taking the job
+      if (active_workers() < worker_count() || priority == Priority::Background) {
+        wake_.notify_all();
+      } else {
+        wake_.notify_one();
+      }
+    }
+    
+    void submit_to_main_thread(Job&& job, Counter* counter)
+    {
+      if (counter) {
+        counter->pending_.fetch_add(1, std::memory_order_relaxed);
+      }
+      {
+        std::scoped_lock lock{ main_mutex_ };
+        main_queue_.push_back(Task{ .job = std::move(job), .counter = counter });
+      }
+      if (main_notifier_) {
+        main_notifier_();
+      }
+    }
+    
+    void run_main_thread_jobs()
+    {
+      // A main thread job that waits on a counter comes back in here while main_running_ is still being walked
+      // further up the stack, so nested calls drain into a list of their own
+      std::vector<Task> nested;
+      auto& running{ main_draining_ ? nested : main_running_ };
+      {
+        std::scoped_lock lock{ main_mutex_ };
+        if (main_queue_.empty()) {
+          return;
+        }
+        std::swap(running, main_queue_);
+      }
+      const bool outermost{ !std::exchange(main_draining_, true) };
+      for (auto& task: running) {
+        run(task);
+      }
+      running.clear();
+      if (outermost) {
+        main_draining_ = false;
+      }
+    }
+    
+    void set_main_thread_notifier(std::function<void()>&& notifier)
+    {
+      main_notifier_ = std::move(notifier);
+    }
+    
+    void set_active_workers(const u32 count)
+    {
+      const auto clamped{ std::clamp(count, 1U, worker_count()) };
+      if (clamped == active_workers()) {
+        return;
+      }
       
-  //   }
+      Log::trace("Job system: {} of {} workers active", clamped, worker_count());
+      {
+        std::scoped_lock lock{ sleep_mutex_ };
+        active_workers_.store(clamped, std::memory_order_relaxed);
+      }
+      wake_.notify_all();
+    }
+
+    void wait(const Counter& counter)
+    {
+      FOXY_PROFILE_SCOPE("Job wait");
+      const bool main_thread{ on_main_thread() };
+      // A background job waiting on background children would otherwise hold the slot they need, and once every
+      // slot is held that way nobody could ever claim them
+      const bool background_job{ in_background_job };
+      if (background_job) {
+        {
+          std::scoped_lock lock{ sleep_mutex_ };
+          --running_background_;
+        }
+        wake_.notify_all();
+      }
+      for (auto pending{ counter.pending_.load(std::memory_order_acquire) }; pending != 0;
+           pending = counter.pending_.load(std::memory_order_acquire)) {
+        // Help instead of blocking. Whatever gets picked up may well be one of the jobs being waited on.
+        if (auto claimed{ try_take(background_job) }) {
+          run_claimed(claimed->first, claimed->second);
+          continue;
+        }
+        if (main_thread) {
+          // Main thread jobs can arrive at any point, so keep checking rather than sleeping on the counter
+          run_main_thread_jobs();
+          std::this_thread::yield();
+          continue;
+        }
+        // Everything left is already running elsewhere, and anything those jobs spawn idle workers will take
+        counter.pending_.wait(pending, std::memory_order_acquire);
+      }
+      if (background_job) {
+        // Taken back even if that briefly puts one over the limit, the job is running either way
+        std::scoped_lock lock{ sleep_mutex_ };
+        ++running_background_;
+      }
+    }
+
+    [[nodiscard]] auto worker_count() const -> u32
+    {
+      return static_cast<u32>(queues_.size());
+    }
+    
+    [[nodiscard]] auto active_workers() const -> u32
+    {
+      return active_workers_.load(std::memory_order_relaxed);
+    }
+    
+    [[nodiscard]] auto on_main_thread() const -> bool
+    {
+      return std::this_thread::get_id() == main_thread_;
+    }
+
+  private:
+    struct Task {
+      Job job;
+      Counter* counter{ nullptr };
+    };
+
+    static constexpr inline std::size_t priority_count{ static_cast<std::size_t>(Priority::Background) + 1 };
+    static constexpr inline auto background{ static_cast<std::size_t>(Priority::Background) };
+
+    struct WorkerQueue {
+      std::mutex mutex;
+      std::array<std::deque<Task>, priority_count> tasks;
+    };
+
+    std::vector<unique<WorkerQueue>> queues_;
+    std::atomic<u32> next_queue_{ 0 };
+    // Per worker: the cpu it's pinned to (if any) and the other workers in the order it steals from them
+    std::vector<std::optional<u32>> worker_cpus_;
+    std::vector<std::vector<u32>> steal_order_;
+
+    const std::thread::id main_thread_;
+    std::mutex main_mutex_;
+    std::vector<Task> main_queue_;
+    // Main thread only, swapped with main_queue_ so draining never allocates (outside of nested drains)
+    std::vector<Task> main_running_;
+    bool main_draining_{ false };
+    std::function<void()> main_notifier_;
+
+    std::mutex sleep_mutex_;
+    std::condition_variable_any wake_;
+    // Tasks queued per priority, and how many background ones are running. Guarded by sleep_mutex_.
+    std::array<u64, priority_count> queued_{};
+    u32 running_background_{ 0 };
+    u32 background_limit_{ 1 };
+    // Only changed under sleep_mutex_, atomic so submit can peek at it without the lock
+    std::atomic<u32> active_workers_{ 0 };
+
+    // Declared last so the threads are joined before the queues they use are destroyed
+    std::vector<std::jthread> workers_;
+
+    void worker_loop(const std::stop_token& stop_token, const u32 index)
+    {
+      worker_index = static_cast<i32>(index);
+      const auto thread_name{ "worker " + std::to_string(index) };
+      Log::set_thread_name(thread_name);
+      FOXY_PROFILE_THREAD(thread_name);
+      if (const auto cpu{ worker_cpus_[index] }; cpu && !pin_current_thread(*cpu)) {
+        Log::warn("Couldn't pin {} to cpu {}", thread_name, *cpu);
+      }
+
+      while (true) {
+        std::size_t level{ 0 };
+        {
+          std::unique_lock lock{ sleep_mutex_ };
+          // Returns false only once stop is requested and nothing is left to run (parked workers leave the
+          // rest to the active ones)
+          const auto runnable{ [this, index] {
+            return index < active_workers_.load(std::memory_order_relaxed) && claimable_level(true).has_value();
+          } };
+          if (!wake_.wait(lock, stop_token, runnable)) {
+            return;
+          }
+          level = *claimable_level(true);
+          claim(level);
+        }
+
+        // queued_ counts tasks, so a task of the claimed priority is guaranteed to be sitting in some queue, even
+        // if another worker stole the one this wake-up was for
+        auto task{ pop_claimed(index, level) };
+        run_claimed(task, level);
+      }
+    }
+
+    // Runs a task claimed at the given level, handing its background slot back afterwards
+    void run_claimed(Task& task, const std::size_t level)
+    {
+      // A waiting background job may pick up anything, what it runs only counts as background by its own level
+      const bool outer{ std::exchange(in_background_job, level == background) };
+      run(task);
+      in_background_job = outer;
+      if (level != background) {
+        return;
+      }
+
+      {
+        std::scoped_lock lock{ sleep_mutex_ };
+        --running_background_;
+      }
+      // Frees up a background slot for whichever idle worker gets there first
+      wake_.notify_all();
+    }
+
+    void place_workers(const u32 worker_count, const CreateInfo& create_info)
+    {
+      worker_cpus_.assign(worker_count, std::nullopt);
+      steal_order_.assign(worker_count, {});
+
+      const auto topology{ CpuTopology::detect() };
+      if (create_info.pin_workers) {
+        const auto order{ topology.placement_order() };
+        // Wraps around when asked for more workers than there are cpus left over
+        const auto reserved{ order.size() > create_info.reserved_cpus ? create_info.reserved_cpus : 0 };
+        for (u32 i{ 0 }; i < worker_count; ++i) {
+          worker_cpus_[i] = order[reserved + i % (order.size() - reserved)];
+          Log::trace("Worker {} -> cpu {}", i, *worker_cpus_[i]);
+        }
+      }
+
+      for (u32 i{ 0 }; i < worker_count; ++i) {
+        auto& victims{ steal_order_[i] };
+        for (u32 offset{ 1 }; offset < worker_count; ++offset) {
+          victims.push_back((i + offset) % worker_count);
+        }
+        // Unpinned workers migrate freely, so only pinned ones gain anything from being picky
+        if (worker_cpus_[i]) {
+          std::ranges::stable_sort(victims, {}, [&](const u32 victim) {
+            return topology.distance(*worker_cpus_[i], *worker_cpus_[victim]);
+          });
+        }
+      }
+    }
+
+    // Highest priority with a task that may be claimed right now. sleep_mutex_ must be held.
+    [[nodiscard]] auto claimable_level(const bool allow_background) const -> std::optional<std::size_t>
+    {
+      for (std::size_t level{ 0 }; level < background; ++level) {
+        if (queued_[level] > 0) {
+          return level;
+        }
+      }
+      if (allow_background && queued_[background] > 0 && running_background_ < background_limit_) {
+        return background;
+      }
+      return std::nullopt;
+    }
+
+    // sleep_mutex_ must be held
+    void claim(const std::size_t level)
+    {
+      --queued_[level];
+      if (level == background) {
+        ++running_background_;
+      }
+    }
+
+    // Claims a queued task for a waiting thread, keeping queued_ in step so workers never wake up to nothing.
+    // Only background jobs pick up background work while they wait, for anything else a long decode would keep
+    // it from noticing its counter is done.
+    [[nodiscard]] auto try_take(const bool allow_background) -> std::optional<std::pair<Task, std::size_t>>
+    {
+      std::size_t level{ 0 };
+      {
+        std::scoped_lock lock{ sleep_mutex_ };
+        const auto claimable{ claimable_level(allow_background) };
+        if (!claimable) {
+          return std::nullopt;
+        }
+        level = *claimable;
+        claim(level);
+      }
+
+      const auto index{
+        worker_index >= 0
+          ? static_cast<u32>(worker_index)
+          : next_queue_.load(std::memory_order_relaxed) % static_cast<u32>(queues_.size())
+      };
+      return std::pair{ pop_claimed(index, level), level };
+    }
+
+    // Spins until the claimed task turns up. It's already queued, just maybe not where we looked first.
+    [[nodiscard]] auto pop_claimed(const u32 index, const std::size_t level) -> Task
+    {
+      while (true) {
+        if (auto task{ pop(index, level) }) {
+          return std::move(*task);
+        }
+      }
+    }
+
+    [[nodiscard]] auto pop(const u32 index, const std::size_t level) -> std::optional<Task>
+    {
+      {
+        auto& own{ queues_[index]->tasks[level] };
+        std::scoped_lock lock{ queues_[index]->mutex };
+        if (!own.empty()) {
+          auto task{ std::move(own.back()) };
+          own.pop_back();
+          return task;
+        }
+      }
+
+      for (const auto victim_index: steal_order_[index]) {
+        auto& victim{ *queues_[victim_index] };
+        std::scoped_lock lock{ victim.mutex };
+        if (auto& tasks{ victim.tasks[level] }; !tasks.empty()) {
+          auto task{ std::move(tasks.front()) };
+          tasks.pop_front();
+          return task;
+        }
+      }
+
+      return std::nullopt;
+    }
+
+    static void run(Task& task)
+    {
+      {
+        FOXY_PROFILE_SCOPE("Job");
+        try {
+          task.job();
+        } catch (const std::exception& e) {
+          Log::error("Job failed: {}", e.what());
+        }
+      }
+
+      if (task.counter && task.counter->pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        task.counter->pending_.notify_all();
+      }
+    }
+  };
+
+  //
+  //  JobSystem
+  //
+
+  auto JobSystem::Counter::done() const -> bool
+  {
+    return pending_.load(std::memory_order_acquire) == 0;
+  }
+
+  JobSystem::JobSystem(const u32 worker_count):
+    JobSystem{ CreateInfo{ .worker_count = worker_count } } {}
+
+  JobSystem::JobSystem(const CreateInfo& create_info):
+    p_impl_{ std::make_unique<Impl>(CreateInfo{
+      .worker_count = create_info.worker_count != 0 ? create_info.worker_count : default_worker_count(),
+      .background_workers = create_info.background_workers,
+      .pin_workers = create_info.pin_workers,
+      .reserved_cpus = create_info.reserved_cpus,
+    }) } {}
+
+  JobSystem::~JobSystem() = default;
+
+  void JobSystem::submit(Job&& job, Counter* counter, const Priority priority)
+  {
+    p_impl_->submit(std::move(job), counter, priority);
+  }
+
+  void JobSystem::submit_to_main_thread(Job&& job, Counter* counter)
+  {
+    p_impl_->submit_to_main_thread(std::move(job), counter);
+  }
+
+  void JobSystem::run_main_thread_jobs()
+  {
+    p_impl_->run_main_thread_jobs();
+  }
+
+  void JobSystem::set_main_thread_notifier(std::function<void()>&& notifier)
+  {
+    p_impl_->set_main_thread_notifier(std::move(notifier));
+  }
+
+  void JobSystem::wait(const Counter& counter)
+  {
+    p_impl_->wait(counter);
+  }
+
+  void JobSystem::set_active_workers(const u32 count)
+  {
+    p_impl_->set_active_workers(count);
+  }
 
-  //   ~Impl() = default;
+  auto JobSystem::worker_count() const -> u32
+  {
+    return p_impl_->worker_count();
+  }
 
-  //   Impl(const Impl& other) = delete;
-  //   Impl& operator=(const Impl& other) = delete;
-  // private:
-  
-  // };
+  auto JobSystem::active_workers() const -> u32
+  {
+    return p_impl_->active_workers();
+  }
 
-  
-  // JobSystem::JobSystem()
-  //   : pImpl_{std::make_unique<Impl>()} {}
+  auto JobSystem::on_main_thread() const -> bool
+  {
+    return p_impl_->on_main_thread();
+  }
 
-  // JobSystem::~JobSystem() = default;
-}
\ No newline at end of file
+  auto JobSystem::default_worker_count() -> u32
+  {
+    const auto hardware_threads{ std::thread::hardware_concurrency() };
+    return hardware_threads > 3 ? hardware_threads - 3 : 1;
+  }
+}
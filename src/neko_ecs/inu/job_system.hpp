@@ -1,7 +1,13 @@
 //
 // Created by galex on 3/24/2022.
 //
+// Waiting never parks a thread while there's work to do: wait() runs queued jobs until its counter drops to
+// zero, so nested fork/join can't starve the workers. That gets most of what fibers buy (Naughty Dog's job
+// system) without per-platform context switching, at the cost of a waiting job's stack staying put until
+// the jobs it picked up finish.
+//
 // Sources:
+// https://www.gdcvault.com/play/1022186/Parallelizing-the-Naughty-Dog-Engine
 // https://blog.molecular-matters.com/2015/08/24/job-system-2-0-lock-free-work-stealing-part-1-basics/
 // https://wickedengine.net/2018/11/24/simple-job-system-using-standard-c/
 // https://benhoffman.tech/cpp/general/2018/11/13/cpp-job-system.html
@@ -9,18 +15,74 @@
 
 #pragma once
 
-#include <BS_thread_pool.hpp>
-
 namespace fx {
-  // class JobSystem {
-  // public:
-  //   JobSystem();
-  //   ~JobSystem();
-
-  //   JobSystem(const JobSystem& other) = delete;
-  //   JobSystem& operator=(const JobSystem& other) = delete;
-  // private:
-  //   class Impl;
-  //   Unique<Impl> pImpl_;
-  // };
+  // Fixed set of worker threads, each with its own queue. Workers pop their own queue newest first and steal
+  // from the others oldest first when they run dry, trying workers that share a core or L3 before the rest.
+  class JobSystem {
+  public:
+    using Job = std::function<void()>;
+
+    // Higher priorities always go first, from any queue. Background jobs (shader compiles, asset decoding) are
+    // also capped to all but one worker (when there's more than one) so they can never hold up frame critical work.
+    enum class Priority: u32 {
+      High,
+      Normal,
+      Background,
+    };
+
+    // Tracks a batch of jobs. Jobs submitted from inside a job against the same counter extend the batch.
+    class Counter {
+    public:
+      [[nodiscard]] auto done() const -> bool;
+
+    private:
+      friend class JobSystem;
+      std::atomic<u32> pending_{ 0 };
+    };
+
+    struct CreateInfo {
+      // 0 picks default_worker_count()
+      u32 worker_count{ 0 };
+      // Workers allowed to run background jobs at once, 0 for all but one
+      u32 background_workers{ 0 };
+      // Pin each worker to a logical cpu, one per physical core (grouped by L3) before any SMT siblings
+      bool pin_workers{ false };
+      // Logical cpus at the front of the placement order left alone for the main, game, and render threads
+      u32 reserved_cpus{ 3 };
+    };
+
+    explicit JobSystem(u32 worker_count = default_worker_count());
+    explicit JobSystem(const CreateInfo& create_info);
+    ~JobSystem();
+
+    JobSystem(const JobSystem& other) = delete;
+    auto operator=(const JobSystem& other) -> JobSystem& = delete;
+
+    void submit(Job&& job, Counter* counter = nullptr, Priority priority = Priority::Normal);
+    // Queues a job for the main thread (the one that created the job system), which runs it the next time it
+    // calls run_main_thread_jobs() or waits on a counter. For APIs like GLFW that only work there.
+    void submit_to_main_thread(Job&& job, Counter* counter = nullptr);
+    // Main thread only. Runs everything queued for it so far.
+    void run_main_thread_jobs();
+    // Called after every submit_to_main_thread, e.g. to wake a main thread blocked waiting for window events
+    void set_main_thread_notifier(std::function<void()>&& notifier);
+    // Runs other queued jobs until every job submitted against the counter has finished. Safe to call from
+    // inside a job, background ones included: those give up their background slot while they wait. Only sleeps
+    // once nothing is left to pick up.
+    void wait(const Counter& counter);
+
+    // Parks every worker past the first count (at least one stays awake so submitted jobs still finish).
+    // Parked workers sleep until the count is raised again; their queued jobs get stolen by the others.
+    void set_active_workers(u32 count);
+
+    [[nodiscard]] auto worker_count() const -> u32;
+    [[nodiscard]] auto active_workers() const -> u32;
+    [[nodiscard]] auto on_main_thread() const -> bool;
+    // Leaves room for the main, game and render threads
+    [[nodiscard]] static auto default_worker_count() -> u32;
+
+  private:
+    class Impl;
+    unique<Impl> p_impl_;
+  };
 }
@@ -0,0 +1,273 @@
+#include "task.hpp"
+
+namespace fx {
+  namespace {
+    constexpr std::size_t smallest_class{ 64 };
+    constexpr std::size_t class_count{ 7 }; // 64 B .. 4 KiB
+    constexpr std::size_t largest_class{ smallest_class << (class_count - 1) };
+    // Frames a thread keeps for itself before handing a batch back to the shared pool
+    constexpr u32 local_limit{ 64 };
+    constexpr u32 batch_size{ local_limit / 2 };
+
+    // Intrusive free list node, stored in the free frame itself
+    struct FreeFrame {
+      FreeFrame* next;
+    };
+
+    [[nodiscard]] auto size_class(const std::size_t size) -> std::size_t
+    {
+      std::size_t index{ 0 };
+      for (auto class_size{ smallest_class }; class_size < size; class_size <<= 1) {
+        ++index;
+      }
+      return index;
+    }
+
+    class SharedPool {
+    public:
+      ~SharedPool()
+      {
+        for (auto* head: free_) {
+          while (head) {
+            ::operator delete(std::exchange(head, head->next));
+          }
+        }
+      }
+
+      void give(const std::size_t index, FreeFrame* head, FreeFrame* tail)
+      {
+        std::scoped_lock lock{ mutex_ };
+        tail->next = free_[index];
+        free_[index] = head;
+      }
+
+      // Hands back up to batch_size frames, null when there are none
+      [[nodiscard]] auto take(const std::size_t index) -> FreeFrame*
+      {
+        std::scoped_lock lock{ mutex_ };
+        auto* head{ free_[index] };
+        auto* tail{ head };
+        for (u32 i{ 1 }; tail && i < batch_size; ++i) {
+          tail = tail->next;
+        }
+        free_[index] = tail ? std::exchange(tail->next, nullptr) : nullptr;
+        return head;
+      }
+
+    private:
+      std::mutex mutex_;
+      std::array<FreeFrame*, class_count> free_{};
+    };
+
+    auto shared_pool() -> SharedPool&
+    {
+      static SharedPool pool{};
+      return pool;
+    }
+
+    class LocalCache {
+    public:
+      LocalCache():
+        shared_{ shared_pool() } {}
+
+      // Nothing is lost when a worker exits, its frames go back to the shared pool
+      ~LocalCache()
+      {
+        for (std::size_t index{ 0 }; index < class_count; ++index) {
+          if (auto* head{ free_[index] }) {
+            auto* tail{ head };
+            while (tail->next) {
+              tail = tail->next;
+            }
+            shared_.give(index, head, tail);
+          }
+        }
+      }
+
+      [[nodiscard]] auto allocate(const std::size_t index) -> void*
+      {
+        if (!free_[index]) {
+          free_[index] = shared_.take(index);
+          for (auto* frame{ free_[index] }; frame; frame = frame->next) {
+            ++count_[index];
+          }
+        }
+        if (auto* frame{ free_[index] }) {
+          free_[index] = frame->next;
+          --count_[index];
+          return frame;
+        }
+        return ::operator new(smallest_class << index);
+      }
+
+      void deallocate(void* memory, const std::size_t index)
+      {
+        auto* frame{ static_cast<FreeFrame*>(memory) };
+        frame->next = free_[index];
+        free_[index] = frame;
+        if (++count_[index] <= local_limit) {
+          return;
+        }
+
+        // Frames tend to be freed wherever the task finished, so spill half back for the other threads
+        auto* tail{ free_[index] };
+        for (u32 i{ 1 }; i < batch_size; ++i) {
+          tail = tail->next;
+        }
+        shared_.give(index, std::exchange(free_[index], std::exchange(tail->next, nullptr)), tail);
+        count_[index] -= batch_size;
+      }
+
+    private:
+      SharedPool& shared_;
+      std::array<FreeFrame*, class_count> free_{};
+      std::array<u32, class_count> count_{};
+    };
+
+    auto local_cache() -> LocalCache&
+    {
+      thread_local LocalCache cache{};
+      return cache;
+    }
+  }
+
+  auto CoroutineFramePool::allocate(const std::size_t size) -> void*
+  {
+    if (size > largest_class) {
+      return ::operator new(size);
+    }
+    return local_cache().allocate(size_class(size));
+  }
+
+  void CoroutineFramePool::deallocate(void* frame, const std::size_t size) noexcept
+  {
+    if (size > largest_class) {
+      ::operator delete(frame);
+      return;
+    }
+    local_cache().deallocate(frame, size_class(size));
+  }
+
+  class TaskScope::Impl {
+  public:
+    Impl() = default;
+
+    ~Impl()
+    {
+      std::scoped_lock lock{ mutex_ };
+      if (!live_.empty()) {
+        Log::warn("Destroying {} unfinished task(s)", live_.size());
+      }
+      // Destroying a root destroys the task it's awaiting, which destroys whatever that one is awaiting, etc.
+      for (const auto handle: live_) {
+        handle.destroy();
+      }
+    }
+
+    void spawn(Task<>&& task)
+    {
+      const auto root{ run_root(*this, std::move(task)) };
+      {
+        std::scoped_lock lock{ mutex_ };
+        live_.push_back(root.handle);
+      }
+      // Registered first, it may well finish before resume() returns
+      root.handle.resume();
+    }
+
+    [[nodiscard]] auto pending() const -> u32
+    {
+      std::scoped_lock lock{ mutex_ };
+      return static_cast<u32>(live_.size());
+    }
+
+  private:
+    mutable std::mutex mutex_;
+    std::vector<std::coroutine_handle<>> live_;
+
+    struct RootTask {
+      struct promise_type {
+        Impl& scope;
+
+        promise_type(Impl& scope, Task<>&):
+          scope{ scope } {}
+
+        [[nodiscard]] static auto operator new(const std::size_t size) -> void*
+        {
+          return CoroutineFramePool::allocate(size);
+        }
+
+        static void operator delete(void* frame, const std::size_t size) noexcept
+        {
+          CoroutineFramePool::deallocate(frame, size);
+        }
+
+        auto get_return_object() noexcept -> RootTask
+        {
+          return RootTask{ std::coroutine_handle<promise_type>::from_promise(*this) };
+        }
+
+        auto initial_suspend() noexcept -> std::suspend_always { return {}; }
+
+        // Unregisters and frees itself on whichever thread the task finished on
+        auto final_suspend() noexcept
+        {
+          struct Awaiter {
+            [[nodiscard]] auto await_ready() const noexcept -> bool { return false; }
+
+            void await_suspend(const std::coroutine_handle<promise_type> handle) noexcept
+            {
+              handle.promise().scope.finish(handle);
+            }
+
+            void await_resume() const noexcept {}
+          };
+          return Awaiter{};
+        }
+
+        void return_void() noexcept {}
+
+        void unhandled_exception() noexcept {}
+      };
+
+      std::coroutine_handle<promise_type> handle;
+    };
+
+    static auto run_root(Impl& scope, Task<> task) -> RootTask
+    {
+      try {
+        co_await std::move(task);
+      } catch (const std::exception& e) {
+        Log::error("Task failed: {}", e.what());
+      }
+    }
+
+    void finish(const std::coroutine_handle<> handle)
+    {
+      {
+        std::scoped_lock lock{ mutex_ };
+        std::erase(live_, handle);
+      }
+      handle.destroy();
+    }
+  };
+
+  //
+  //  TaskScope
+  //
+
+  TaskScope::TaskScope():
+    p_impl_{ std::make_unique<Impl>() } {}
+
+  TaskScope::~TaskScope() = default;
+
+  void TaskScope::spawn(Task<>&& task)
+  {
+    p_impl_->spawn(std::move(task));
+  }
+
+  auto TaskScope::pending() const -> u32
+  {
+    return p_impl_->pending();
+  }
+}
@@ -0,0 +1,248 @@
+//
+// Coroutine tasks on top of the job system. A Task<T> is lazy: it starts when it's co_awaited (or handed to a
+// TaskScope) and resumes whoever awaited it once it finishes, on whichever thread it finished on. Frames come
+// from a pool of size classes, so after warm-up starting, suspending, and resuming tasks never hits the heap.
+//
+//   auto load_level(JobSystem& jobs) -> Task<Level> {
+//     auto bytes{ co_await run_async(jobs, [] { return read_file("level.bin"); }) };
+//     co_return parse(bytes);
+//   }
+//
+// Sources:
+// https://lewissbaker.github.io/2017/11/17/understanding-operator-co-await
+// https://lewissbaker.github.io/2018/09/05/understanding-the-promise-type
+// https://github.com/lewissbaker/cppcoro
+//
+
+#pragma once
+
+#include "job_system.hpp"
+
+namespace fx {
+  // Thread-local free lists per size class, spilling to and refilling from a shared pool, so a frame freed on
+  // a worker can be reused by the game thread. Frames bigger than the largest class go straight to the heap.
+  class CoroutineFramePool {
+  public:
+    [[nodiscard]] static auto allocate(std::size_t size) -> void*;
+    static void deallocate(void* frame, std::size_t size) noexcept;
+  };
+
+  template<class T = void>
+  class Task;
+
+  namespace detail {
+    class TaskPromiseBase {
+    public:
+      [[nodiscard]] static auto operator new(const std::size_t size) -> void*
+      {
+        return CoroutineFramePool::allocate(size);
+      }
+
+      static void operator delete(void* frame, const std::size_t size) noexcept
+      {
+        CoroutineFramePool::deallocate(frame, size);
+      }
+
+      auto initial_suspend() noexcept -> std::suspend_always { return {}; }
+
+      // Symmetric transfer back to the awaiter, so long chains of tasks finishing don't grow the stack
+      struct FinalAwaiter {
+        [[nodiscard]] auto await_ready() const noexcept -> bool { return false; }
+
+        template<class Promise>
+        auto await_suspend(std::coroutine_handle<Promise> handle) noexcept -> std::coroutine_handle<>
+        {
+          return handle.promise().continuation_;
+        }
+
+        void await_resume() const noexcept {}
+      };
+
+      auto final_suspend() noexcept -> FinalAwaiter { return {}; }
+
+      void unhandled_exception() noexcept
+      {
+        exception_ = std::current_exception();
+      }
+
+      void set_continuation(const std::coroutine_handle<> continuation) noexcept
+      {
+        continuation_ = continuation;
+      }
+
+    protected:
+      void rethrow_if_failed() const
+      {
+        if (exception_) {
+          std::rethrow_exception(exception_);
+        }
+      }
+
+    private:
+      std::coroutine_handle<> continuation_{ std::noop_coroutine() };
+      std::exception_ptr exception_;
+    };
+
+    template<class T>
+    class TaskPromise: public TaskPromiseBase {
+    public:
+      auto get_return_object() noexcept -> Task<T>;
+
+      template<class U>
+      void return_value(U&& value)
+      {
+        value_.emplace(std::forward<U>(value));
+      }
+
+      auto result() -> T
+      {
+        rethrow_if_failed();
+        return std::move(*value_);
+      }
+
+    private:
+      std::optional<T> value_;
+    };
+
+    template<>
+    class TaskPromise<void>: public TaskPromiseBase {
+    public:
+      auto get_return_object() noexcept -> Task<>;
+
+      void return_void() noexcept {}
+
+      void result()
+      {
+        rethrow_if_failed();
+      }
+    };
+  }
+
+  template<class T>
+  class [[nodiscard]] Task {
+  public:
+    using promise_type = detail::TaskPromise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    Task() = default;
+
+    explicit Task(const Handle handle):
+      handle_{ handle } {}
+
+    Task(Task&& other) noexcept:
+      handle_{ std::exchange(other.handle_, nullptr) } {}
+
+    auto operator=(Task&& other) noexcept -> Task&
+    {
+      if (this != &other) {
+        if (handle_) {
+          handle_.destroy();
+        }
+        handle_ = std::exchange(other.handle_, nullptr);
+      }
+      return *this;
+    }
+
+    Task(const Task& other) = delete;
+    auto operator=(const Task& other) -> Task& = delete;
+
+    ~Task()
+    {
+      if (handle_) {
+        handle_.destroy();
+      }
+    }
+
+    [[nodiscard]] auto valid() const -> bool
+    {
+      return static_cast<bool>(handle_);
+    }
+
+    auto operator co_await() && noexcept
+    {
+      struct Awaiter {
+        Handle handle;
+
+        [[nodiscard]] auto await_ready() const noexcept -> bool
+        {
+          return !handle || handle.done();
+        }
+
+        // Starts the task right away on this thread, it resumes us when it's done
+        auto await_suspend(const std::coroutine_handle<> awaiter) noexcept -> std::coroutine_handle<>
+        {
+          handle.promise().set_continuation(awaiter);
+          return handle;
+        }
+
+        auto await_resume() -> T
+        {
+          return handle.promise().result();
+        }
+      };
+      return Awaiter{ handle_ };
+    }
+
+  private:
+    Handle handle_{ nullptr };
+  };
+
+  namespace detail {
+    template<class T>
+    auto TaskPromise<T>::get_return_object() noexcept -> Task<T>
+    {
+      return Task<T>{ std::coroutine_handle<TaskPromise>::from_promise(*this) };
+    }
+
+    inline auto TaskPromise<void>::get_return_object() noexcept -> Task<>
+    {
+      return Task<>{ std::coroutine_handle<TaskPromise>::from_promise(*this) };
+    }
+  }
+
+  // Moves the awaiting coroutine onto one of the job system's workers
+  [[nodiscard]] inline auto schedule_on(JobSystem& jobs)
+  {
+    struct Awaiter {
+      JobSystem& jobs;
+
+      [[nodiscard]] auto await_ready() const noexcept -> bool { return false; }
+
+      void await_suspend(const std::coroutine_handle<> handle)
+      {
+        jobs.submit([handle] { handle.resume(); });
+      }
+
+      void await_resume() const noexcept {}
+    };
+    return Awaiter{ jobs };
+  }
+
+  // Runs fn as a job and resumes with its result, still on that worker
+  template<class Fn>
+  auto run_async(JobSystem& jobs, Fn fn) -> Task<std::invoke_result_t<Fn&>>
+  {
+    co_await schedule_on(jobs);
+    co_return fn();
+  }
+
+  // Owns fire-and-forget tasks until they finish. Exceptions that escape a spawned task are logged.
+  class TaskScope {
+  public:
+    TaskScope();
+    // Destroys whatever never finished, so it must only go away once nothing can resume those tasks anymore
+    ~TaskScope();
+
+    TaskScope(const TaskScope& other) = delete;
+    auto operator=(const TaskScope& other) -> TaskScope& = delete;
+
+    // Starts the task immediately on the calling thread
+    void spawn(Task<>&& task);
+
+    [[nodiscard]] auto pending() const -> u32;
+
+  private:
+    class Impl;
+    unique<Impl> p_impl_;
+  };
+}
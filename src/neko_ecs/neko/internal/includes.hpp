@@ -24,6 +24,7 @@
 // Utilities
 #include <compare>
 #include <cstdlib>
+#include <cstring>
 #include <algorithm>
 #include <numeric>
 #include <utility>
@@ -39,6 +40,11 @@
 #include <typeinfo>
 #include <format>
 #include <string_view>
+#include <span>
+#include <coroutine>
+#include <optional>
+#include <exception>
+#include <system_error>
 // Threading
 #include <thread>
 #include <mutex>
@@ -54,9 +54,9 @@ namespace fx::ookami {
       window_{ window },
       context_{ vk::raii::Context{} },
       extension_data_{ ExtensionData{
-        .device_extensions = std::vector{
-          VK_KHR_SWAPCHAIN_EXTENSION_NAME
-        }
+        .device_extensions = window
+          ? std::vector<const char*>{ VK_KHR_SWAPCHAIN_EXTENSION_NAME }
+          : std::vector<const char*>{}
       }},
       instance_{ create_instance() },
       debug_messenger_{ try_create_debug_messenger() },
@@ -86,11 +86,27 @@ namespace fx::ookami {
     {
       logical_device_.resetFences(*fence);
     }
+    
+    [[nodiscard]] auto find_memory_type(const u32 type_filter, const u32 property_flags) const -> std::optional<u32>
+    {
+      const vk::MemoryPropertyFlags flags{ property_flags };
+      const auto memory_properties{ physical_device_.getMemoryProperties() };
+      for (u32 i{ 0 }; i < memory_properties.memoryTypeCount; ++i) {
+        if ((type_filter & (1U << i)) && (memory_properties.memoryTypes[i].propertyFlags & flags) == flags) {
+          return i;
+        }
+      }
+      return std::nullopt;
+    }
 
     [[nodiscard]] auto window() -> fx::shared<GLFWwindow> {
       return window_;
     }
 
+    [[nodiscard]] auto headless() const -> bool {
+      return !window_;
+    }
+
     [[nodiscard]] auto native() -> vk::raii::Context& {
       return context_;
     }
@@ -203,8 +219,10 @@ namespace fx::ookami {
 
     [[nodiscard]] auto get_enabled_extensions() -> std::vector<const char*> {
       std::set<const char*> required_extensions{};
-      // GLFW
-      extension_data_.window_extensions = required_instance_extensions();
+      // GLFW (a headless context never creates a surface, so it doesn't need the window system extensions)
+      if (window_) {
+        extension_data_.window_extensions = required_instance_extensions();
+      }
       for (const auto& extension: extension_data_.window_extensions) {
         if (!required_extensions.contains(extension)) {
           required_extensions.insert(extension);
@@ -287,7 +305,10 @@ namespace fx::ookami {
           queue_family_indices.graphics = i;
         }
 
-        if (physical_device.getSurfaceSupportKHR(i, *surface_)) {
+        if (!window_) {
+          // Nothing is ever presented, so let the graphics queue stand in for the present queue
+          queue_family_indices.present = queue_family_indices.graphics;
+        } else if (physical_device.getSurfaceSupportKHR(i, *surface_)) {
           queue_family_indices.present = i;
         }
 
@@ -336,7 +357,9 @@ namespace fx::ookami {
       const auto queue_family_indices{ find_queue_families(physical_device) };
 
       bool valid_swapchain{ false };
-      if (check_device_extension_support(physical_device)) {
+      if (!window_) {
+        valid_swapchain = check_device_extension_support(physical_device);
+      } else if (check_device_extension_support(physical_device)) {
         const auto [capabilities, formats, present_modes]{ query_swapchain_support(physical_device) };
         valid_swapchain = !formats.empty() && !present_modes.empty();
       }
@@ -387,17 +410,35 @@ namespace fx::ookami {
         });
       }
 
+      // Render graph barriers are recorded with synchronization2, and passes use dynamic rendering
+      // instead of render pass/framebuffer objects
+      vk::PhysicalDeviceVulkan13Features vulkan_13_features{
+        .synchronization2 = true,
+        .dynamicRendering = true,
+      };
+
+      // Pipeline statistics are only used by the GPU profiler, so they are optional
+      const vk::PhysicalDeviceFeatures enabled_features{
+        .pipelineStatisticsQuery = physical_device_.getFeatures().pipelineStatisticsQuery,
+      };
+
       const vk::DeviceCreateInfo device_create_info{
+        .pNext = &vulkan_13_features,
         .queueCreateInfoCount = static_cast<fx::u32>(queue_create_infos.size()),
         .pQueueCreateInfos = queue_create_infos.data(),
         .enabledExtensionCount = static_cast<fx::u32>(extension_data_.device_extensions.size()),
         .ppEnabledExtensionNames = extension_data_.device_extensions.data(),
+        .pEnabledFeatures = &enabled_features,
       };
 
       return { physical_device_.createDevice(device_create_info, nullptr) };
     }
 
     [[nodiscard]] auto create_surface(const fx::shared<GLFWwindow>& window) const -> Surface {
+      if (!window) {
+        return nullptr;
+      }
+
       VkSurfaceKHR raw_surface;
 
       const auto result = static_cast<vk::Result>(
@@ -427,11 +468,21 @@ namespace fx::ookami {
     p_impl_->reset_fence(fence);
   }
   
+  auto Context::find_memory_type(const u32 type_filter, const u32 property_flags) const -> std::optional<u32>
+  {
+    return p_impl_->find_memory_type(type_filter, property_flags);
+  }
+  
   auto Context::window() -> shared<GLFWwindow>
   {
     return p_impl_->window();
   }
 
+  auto Context::headless() const -> bool
+  {
+    return p_impl_->headless();
+  }
+
   auto Context::native() -> vk::raii::Context& {
     return p_impl_->native();
   }
@@ -31,6 +31,8 @@ namespace fx {
       using Surface = vk::raii::SurfaceKHR;
 
     public:
+      // A null window creates a headless context: no surface, no swapchain extension, and the
+      // graphics queue doubles as the present queue
       explicit Context(
         const shared<GLFWwindow>& window,
       #ifdef FOXY_DEBUG_MODE
@@ -43,8 +45,10 @@ namespace fx {
   
       void wait_for_fence(const vk::raii::Fence& fence);
       void reset_fence(const vk::raii::Fence& fence);
+      [[nodiscard]] auto find_memory_type(u32 type_filter, u32 property_flags) const -> std::optional<u32>;
       
       [[nodiscard]] auto window() -> shared<GLFWwindow>;
+      [[nodiscard]] auto headless() const -> bool;
       [[nodiscard]] auto native() -> VulkanContext&;
       [[nodiscard]] auto instance() -> Instance&;
       [[nodiscard]] auto surface() -> Surface&;
@@ -0,0 +1,35 @@
+#pragma once
+
+namespace fx {
+  struct PassStats {
+    std::string name;
+    double cpu_time_ms{ 0. };
+    // Resolved a couple of frames late, see GpuProfiler
+    double gpu_time_ms{ 0. };
+  };
+
+  // One node of the GPU timing tree. Pipeline statistics are zero when the device doesn't support them.
+  struct GpuScopeStats {
+    std::string name;
+    u32 depth{ 0 };
+    i32 parent{ -1 };
+    double gpu_time_ms{ 0. };
+    u64 input_assembly_vertices{ 0 };
+    u64 input_assembly_primitives{ 0 };
+    u64 vertex_shader_invocations{ 0 };
+    u64 clipping_primitives{ 0 };
+    u64 fragment_shader_invocations{ 0 };
+    u64 compute_shader_invocations{ 0 };
+  };
+
+  struct FrameStats {
+    u64 frame_count{ 0 };
+    double frame_time_ms{ 0. };
+    // Instances in the render world the frame was drawn from
+    u32 instance_count{ 0 };
+    std::vector<PassStats> passes{};
+    // Frame the GPU scopes below were recorded in (lags frame_count by the number of frames in flight)
+    u64 gpu_frame{ 0 };
+    std::vector<GpuScopeStats> gpu_scopes{};
+  };
+}
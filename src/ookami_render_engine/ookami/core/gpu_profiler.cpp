@@ -0,0 +1,384 @@
+#include "gpu_profiler.hpp"
+
+#include "context.hpp"
+#include "frame_stats.hpp"
+
+#include "vulkan/static.hpp"
+
+namespace fx {
+  namespace {
+    // Results come back in bit order, which matches the GpuScopeStats fields
+    constexpr vk::QueryPipelineStatisticFlags statistic_flags{
+      vk::QueryPipelineStatisticFlagBits::eInputAssemblyVertices |
+      vk::QueryPipelineStatisticFlagBits::eInputAssemblyPrimitives |
+      vk::QueryPipelineStatisticFlagBits::eVertexShaderInvocations |
+      vk::QueryPipelineStatisticFlagBits::eClippingPrimitives |
+      vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations |
+      vk::QueryPipelineStatisticFlagBits::eComputeShaderInvocations
+    };
+    constexpr u32 statistic_count{ 6 };
+
+    void write_json_string(std::ostream& stream, const std::string_view string)
+    {
+      stream << '"';
+      for (const char c: string) {
+        if (c == '"' || c == '\\') {
+          stream << '\\';
+        }
+        stream << c;
+      }
+      stream << '"';
+    }
+  }
+
+  class GpuProfiler::Impl {
+  public:
+    explicit Impl(const shared<ookami::Context>& context, const u32 frames_in_flight, const u32 max_scopes):
+      context_{ context },
+      max_scopes_{ max_scopes }
+    {
+      Log::trace("Creating GPU profiler...");
+
+      auto& physical_device{ context_->physical_device() };
+      const auto limits{ physical_device.getProperties().limits };
+      const auto queue_family{ physical_device.getQueueFamilyProperties().at(*context_->queue_families().graphics) };
+
+      timestamp_period_ns_ = limits.timestampPeriod;
+      timestamp_mask_ = queue_family.timestampValidBits >= 64 ? ~0ULL : (1ULL << queue_family.timestampValidBits) - 1;
+      enabled_ = queue_family.timestampValidBits > 0 && timestamp_period_ns_ > 0.f;
+      statistics_supported_ = enabled_ && physical_device.getFeatures().pipelineStatisticsQuery;
+
+      if (!enabled_) {
+        Log::warn("Graphics queue doesn't support timestamps, GPU profiling disabled.");
+        return;
+      }
+
+      for (u32 i{ 0 }; i < frames_in_flight; ++i) {
+        try {
+          auto& frame{ frames_.emplace_back() };
+          frame.timestamps = vk::raii::QueryPool{ context_->logical_device(), vk::QueryPoolCreateInfo{
+            .queryType = vk::QueryType::eTimestamp,
+            .queryCount = max_scopes_ * 2,
+          }};
+          if (statistics_supported_) {
+            frame.statistics = vk::raii::QueryPool{ context_->logical_device(), vk::QueryPoolCreateInfo{
+              .queryType = vk::QueryType::ePipelineStatistics,
+              .queryCount = max_scopes_,
+              .pipelineStatistics = statistic_flags,
+            }};
+          }
+        } catch (const std::exception& e) {
+          Log::error("Failed to create GPU profiler query pools: {}", e.what());
+          enabled_ = false;
+          return;
+        }
+      }
+
+      Log::trace("Created GPU profiler ({} scopes per frame, pipeline statistics {}).",
+        max_scopes_, statistics_supported_ ? "on" : "off");
+    }
+
+    ~Impl() = default;
+
+    void begin_frame(vk::raii::CommandBuffer& command_buffer, const u32 frame_index)
+    {
+      if (!enabled_) {
+        return;
+      }
+
+      current_ = &frames_.at(frame_index);
+      resolve(*current_);
+
+      command_buffer.resetQueryPool(*current_->timestamps, 0, max_scopes_ * 2);
+      if (statistics_supported_) {
+        command_buffer.resetQueryPool(*current_->statistics, 0, max_scopes_);
+      }
+
+      current_->scopes.clear();
+      current_->statistics_count = 0;
+      current_->frame = frame_counter_++;
+      current_->pending = true;
+      open_scopes_.clear();
+      statistics_open_ = false;
+    }
+
+    void begin_scope(vk::raii::CommandBuffer& command_buffer, const std::string& name, const bool statistics)
+    {
+      if (!enabled_ || !current_) {
+        return;
+      }
+
+      if (current_->scopes.size() >= max_scopes_) {
+        // Keep begin/end balanced even though this scope won't be recorded
+        open_scopes_.push_back(-1);
+        return;
+      }
+
+      const auto index{ static_cast<i32>(current_->scopes.size()) };
+      Scope scope{
+        .name = name,
+        .depth = static_cast<u32>(open_scopes_.size()),
+        .parent = open_scopes_.empty() ? -1 : open_scopes_.back(),
+      };
+
+      command_buffer.writeTimestamp2(vk::PipelineStageFlagBits2::eTopOfPipe, *current_->timestamps, index * 2);
+      if (statistics && statistics_supported_ && !statistics_open_) {
+        scope.statistics_query = static_cast<i32>(current_->statistics_count++);
+        command_buffer.beginQuery(*current_->statistics, scope.statistics_query, {});
+        statistics_open_ = true;
+      }
+
+      current_->scopes.push_back(std::move(scope));
+      open_scopes_.push_back(index);
+    }
+
+    void end_scope(vk::raii::CommandBuffer& command_buffer)
+    {
+      if (!enabled_ || !current_ || open_scopes_.empty()) {
+        return;
+      }
+
+      const auto index{ open_scopes_.back() };
+      open_scopes_.pop_back();
+      if (index < 0) {
+        return;
+      }
+
+      if (const auto& scope{ current_->scopes[index] }; scope.statistics_query >= 0) {
+        command_buffer.endQuery(*current_->statistics, scope.statistics_query);
+        statistics_open_ = false;
+      }
+      command_buffer.writeTimestamp2(vk::PipelineStageFlagBits2::eBottomOfPipe, *current_->timestamps, index * 2 + 1);
+    }
+
+    [[nodiscard]] auto enabled() const -> bool
+    {
+      return enabled_;
+    }
+
+    [[nodiscard]] auto statistics_supported() const -> bool
+    {
+      return statistics_supported_;
+    }
+
+    [[nodiscard]] auto results() const -> std::vector<GpuScopeStats>
+    {
+      std::scoped_lock lock{ results_mutex_ };
+      return results_;
+    }
+
+    [[nodiscard]] auto results_frame() const -> u64
+    {
+      std::scoped_lock lock{ results_mutex_ };
+      return results_frame_;
+    }
+
+    void write_csv(std::ostream& stream) const
+    {
+      const auto [results, results_frame]{ snapshot() };
+      stream << "frame,name,depth,parent,gpu_time_ms,input_assembly_vertices,input_assembly_primitives,"
+                "vertex_shader_invocations,clipping_primitives,fragment_shader_invocations,compute_shader_invocations\n";
+      for (const auto& scope: results) {
+        stream << results_frame << ",\"" << scope.name << "\"," << scope.depth << ',' << scope.parent << ','
+               << scope.gpu_time_ms << ',' << scope.input_assembly_vertices << ',' << scope.input_assembly_primitives << ','
+               << scope.vertex_shader_invocations << ',' << scope.clipping_primitives << ','
+               << scope.fragment_shader_invocations << ',' << scope.compute_shader_invocations << '\n';
+      }
+    }
+
+    void write_json(std::ostream& stream) const
+    {
+      const auto [results, results_frame]{ snapshot() };
+      stream << "{\"frame\":" << results_frame << ",\"scopes\":[";
+      bool first{ true };
+      for (i32 i{ 0 }; i < static_cast<i32>(results.size()); ++i) {
+        if (results[i].parent < 0) {
+          if (!first) {
+            stream << ',';
+          }
+          write_json_scope(stream, results, i);
+          first = false;
+        }
+      }
+      stream << "]}\n";
+    }
+
+  private:
+    struct Scope {
+      std::string name;
+      u32 depth{ 0 };
+      i32 parent{ -1 };
+      i32 statistics_query{ -1 };
+    };
+
+    struct Frame {
+      vk::raii::QueryPool timestamps{ nullptr };
+      vk::raii::QueryPool statistics{ nullptr };
+      std::vector<Scope> scopes{};
+      u32 statistics_count{ 0 };
+      u64 frame{ 0 };
+      bool pending{ false };
+    };
+
+    shared<ookami::Context> context_;
+    const u32 max_scopes_;
+
+    bool enabled_{ false };
+    bool statistics_supported_{ false };
+    float timestamp_period_ns_{ 0.f };
+    u64 timestamp_mask_{ 0 };
+
+    std::vector<Frame> frames_;
+    Frame* current_{ nullptr };
+    u64 frame_counter_{ 0 };
+    std::vector<i32> open_scopes_;
+    bool statistics_open_{ false };
+
+    // Resolved on the render thread, read from anywhere
+    mutable std::mutex results_mutex_;
+    std::vector<GpuScopeStats> results_;
+    u64 results_frame_{ 0 };
+
+    [[nodiscard]] auto snapshot() const -> std::pair<std::vector<GpuScopeStats>, u64>
+    {
+      std::scoped_lock lock{ results_mutex_ };
+      return { results_, results_frame_ };
+    }
+
+    void resolve(Frame& frame)
+    {
+      if (!frame.pending || frame.scopes.empty()) {
+        return;
+      }
+      frame.pending = false;
+
+      // No wait flag: the slot's fence has already signaled, and if the results somehow aren't available yet
+      // the previous ones are kept rather than stalling
+      const auto timestamp_count{ static_cast<u32>(frame.scopes.size() * 2) };
+      const auto [timestamp_result, timestamps]{ frame.timestamps.getResults<u64>(
+        0, timestamp_count, timestamp_count * sizeof(u64), sizeof(u64), vk::QueryResultFlagBits::e64
+      )};
+      if (timestamp_result != vk::Result::eSuccess) {
+        return;
+      }
+
+      std::vector<u64> statistics;
+      if (frame.statistics_count > 0) {
+        auto [statistics_result, values]{ frame.statistics.getResults<u64>(
+          0, frame.statistics_count, frame.statistics_count * statistic_count * sizeof(u64),
+          statistic_count * sizeof(u64), vk::QueryResultFlagBits::e64
+        )};
+        if (statistics_result == vk::Result::eSuccess) {
+          statistics = std::move(values);
+        }
+      }
+
+      std::vector<GpuScopeStats> results;
+      results.reserve(frame.scopes.size());
+      for (u32 i{ 0 }; i < frame.scopes.size(); ++i) {
+        const auto& scope{ frame.scopes[i] };
+        const u64 ticks{ (timestamps[i * 2 + 1] - timestamps[i * 2]) & timestamp_mask_ };
+        auto& stats{ results.emplace_back(GpuScopeStats{
+          .name = scope.name,
+          .depth = scope.depth,
+          .parent = scope.parent,
+          .gpu_time_ms = static_cast<double>(ticks) * timestamp_period_ns_ / 1'000'000.,
+        }) };
+
+        if (scope.statistics_query >= 0 && !statistics.empty()) {
+          const auto* values{ &statistics[scope.statistics_query * statistic_count] };
+          stats.input_assembly_vertices = values[0];
+          stats.input_assembly_primitives = values[1];
+          stats.vertex_shader_invocations = values[2];
+          stats.clipping_primitives = values[3];
+          stats.fragment_shader_invocations = values[4];
+          stats.compute_shader_invocations = values[5];
+        }
+      }
+
+      std::scoped_lock lock{ results_mutex_ };
+      results_ = std::move(results);
+      results_frame_ = frame.frame;
+    }
+
+    static void write_json_scope(std::ostream& stream, const std::vector<GpuScopeStats>& results, const i32 index)
+    {
+      const auto& scope{ results[index] };
+      stream << "{\"name\":";
+      write_json_string(stream, scope.name);
+      stream << ",\"gpu_time_ms\":" << scope.gpu_time_ms
+             << ",\"input_assembly_vertices\":" << scope.input_assembly_vertices
+             << ",\"input_assembly_primitives\":" << scope.input_assembly_primitives
+             << ",\"vertex_shader_invocations\":" << scope.vertex_shader_invocations
+             << ",\"clipping_primitives\":" << scope.clipping_primitives
+             << ",\"fragment_shader_invocations\":" << scope.fragment_shader_invocations
+             << ",\"compute_shader_invocations\":" << scope.compute_shader_invocations
+             << ",\"children\":[";
+      bool first{ true };
+      for (i32 i{ index + 1 }; i < static_cast<i32>(results.size()); ++i) {
+        if (results[i].parent == index) {
+          if (!first) {
+            stream << ',';
+          }
+          write_json_scope(stream, results, i);
+          first = false;
+        }
+      }
+      stream << "]}";
+    }
+  };
+
+  //
+  //  GpuProfiler
+  //
+
+  GpuProfiler::GpuProfiler(const shared<ookami::Context>& context, const u32 frames_in_flight, const u32 max_scopes):
+    p_impl_{ std::make_unique<Impl>(context, frames_in_flight, max_scopes) } {}
+
+  GpuProfiler::~GpuProfiler() = default;
+
+  void GpuProfiler::begin_frame(vk::raii::CommandBuffer& command_buffer, const u32 frame_index)
+  {
+    p_impl_->begin_frame(command_buffer, frame_index);
+  }
+
+  void GpuProfiler::begin_scope(vk::raii::CommandBuffer& command_buffer, const std::string& name, const bool statistics)
+  {
+    p_impl_->begin_scope(command_buffer, name, statistics);
+  }
+
+  void GpuProfiler::end_scope(vk::raii::CommandBuffer& command_buffer)
+  {
+    p_impl_->end_scope(command_buffer);
+  }
+
+  auto GpuProfiler::enabled() const -> bool
+  {
+    return p_impl_->enabled();
+  }
+
+  auto GpuProfiler::statistics_supported() const -> bool
+  {
+    return p_impl_->statistics_supported();
+  }
+
+  auto GpuProfiler::results() const -> std::vector<GpuScopeStats>
+  {
+    return p_impl_->results();
+  }
+
+  auto GpuProfiler::results_frame() const -> u64
+  {
+    return p_impl_->results_frame();
+  }
+
+  void GpuProfiler::write_csv(std::ostream& stream) const
+  {
+    p_impl_->write_csv(stream);
+  }
+
+  void GpuProfiler::write_json(std::ostream& stream) const
+  {
+    p_impl_->write_json(stream);
+  }
+}
@@ -0,0 +1,46 @@
+//
+// GPU timestamp and pipeline statistics scopes. Every frame in flight owns its own query pools, and a
+// pool is only read back once the fence guarding its frame slot has been waited on, so resolving never
+// stalls the CPU. With N frames in flight the results describe the frame recorded N frames ago.
+//
+
+#pragma once
+
+namespace vk::raii {
+  class CommandBuffer;
+}
+
+namespace fx {
+  struct GpuScopeStats;
+
+  namespace ookami {
+    class Context;
+  }
+
+  class GpuProfiler {
+  public:
+    explicit GpuProfiler(const shared<ookami::Context>& context, u32 frames_in_flight, u32 max_scopes = 64);
+    ~GpuProfiler();
+
+    // Resolves whatever the slot recorded last time around, then resets its pools. Call once the slot's fence
+    // has been waited on, before any scopes are recorded into the command buffer.
+    void begin_frame(vk::raii::CommandBuffer& command_buffer, u32 frame_index);
+    // Pipeline statistics can't nest, so only the outermost scope asking for them gets a statistics query
+    void begin_scope(vk::raii::CommandBuffer& command_buffer, const std::string& name, bool statistics = true);
+    void end_scope(vk::raii::CommandBuffer& command_buffer);
+
+    [[nodiscard]] auto enabled() const -> bool;
+    [[nodiscard]] auto statistics_supported() const -> bool;
+    // Most recently resolved timing tree, in recording order (parents before children). Results are swapped in
+    // under a lock, so these and the writers below are safe to call from any thread.
+    [[nodiscard]] auto results() const -> std::vector<GpuScopeStats>;
+    [[nodiscard]] auto results_frame() const -> u64;
+
+    void write_csv(std::ostream& stream) const;
+    void write_json(std::ostream& stream) const;
+
+  private:
+    class Impl;
+    unique<Impl> p_impl_;
+  };
+}
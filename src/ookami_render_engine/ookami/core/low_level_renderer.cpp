@@ -8,9 +8,16 @@
 #include "swapchain.hpp"
 #include "pipeline.hpp"
 #include "shader.hpp"
+#include "render_graph.hpp"
+#include "offscreen_target.hpp"
+#include "frame_stats.hpp"
+#include "gpu_profiler.hpp"
+#include "ookami/render_engine.hpp"
+#include "ookami/render_world.hpp"
 
 #include "vulkan/static.hpp"
 #include <inferno/window.hpp>
+#include <kitsune/profiler.hpp>
 
 namespace fx {
   class LowLevelRenderer::Impl: types::SingleInstance<LowLevelRenderer> {
@@ -19,12 +26,21 @@ namespace fx {
       const shared<Window>& window,
       const shared<ookami::Context>& context,
       const shared<Shader>& shader,
-      const u32 max_frames_in_flight
+      const u32 max_frames_in_flight,
+      const std::optional<HeadlessCreateInfo>& headless_info = std::nullopt
     ):
       max_frames_in_flight_{ max_frames_in_flight },
+      readback_{ headless_info && headless_info->readback },
       window_{ window },
       context_{ context },
-      swapchain_{ std::make_shared<Swapchain>(context_) },
+      swapchain_{
+        headless_info ? nullptr : std::make_shared<Swapchain>(context_, [window] { return window->framebuffer_size(); })
+      },
+      offscreen_{
+        headless_info
+          ? std::make_unique<OffscreenTarget>(context_, headless_info->width, headless_info->height, max_frames_in_flight)
+          : nullptr
+      },
       command_pool_{
         context_->logical_device().createCommandPool(vk::CommandPoolCreateInfo{
         .flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
@@ -39,10 +55,15 @@ namespace fx {
           .commandBufferCount = max_frames_in_flight,
         }
       },
-      pipeline_{ std::make_shared<Pipeline>(context_, swapchain_, shader) }
+      pipeline_{ std::make_shared<Pipeline>(context_, shader, color_format()) },
+      render_graph_{ std::make_unique<RenderGraph>(context_) },
+      gpu_profiler_{ std::make_shared<GpuProfiler>(context_, max_frames_in_flight) }
     {
       Log::trace("Preparing Low Level Renderer...");
       
+      render_graph_->set_profiler(gpu_profiler_);
+      build_render_graph();
+      
       for (u32 i: std::views::iota(0U, max_frames_in_flight_)) {
         try {
           image_available_semaphores_.emplace_back(context_->logical_device(), vk::SemaphoreCreateInfo{});
@@ -57,69 +78,111 @@ namespace fx {
         }
       }
       
-      window_->add_framebuffer_resized_callback([this](i32 width, i32 height) {
-        framebuffer_resized_ = true;
-      });
+      if (window_) {
+        window_->add_framebuffer_resized_callback([this](i32 width, i32 height) {
+          framebuffer_resized_.store(true, std::memory_order_relaxed);
+        });
+      }
       
-      Log::trace("Low Level Renderer ready.");
+      Log::trace("Low Level Renderer ready{}.", headless() ? " (headless)" : "");
     }
     
     ~Impl() = default;
     
-    void draw()
+    void draw(const RenderWorld& world)
     {
-      context_->wait_for_fence(image_in_flight_fences_[current_frame_index_]);
-      if (auto image_index{ swapchain_->acquire_next_image(image_available_semaphores_[current_frame_index_]) }) {
+      const auto frame_start{ std::chrono::steady_clock::now() };
+      
+      {
+        FOXY_PROFILE_SCOPE("Wait for frame fence");
+        context_->wait_for_fence(image_in_flight_fences_[current_frame_index_]);
+      }
+      if (headless()) {
+        // Offscreen images are indexed by frame, there is nothing to acquire or present
+        context_->reset_fence(image_in_flight_fences_[current_frame_index_]);
+        submit(current_frame_index_);
+        last_submitted_frame_index_ = current_frame_index_;
+        current_frame_index_ = (current_frame_index_ + 1) % max_frames_in_flight_;
+      } else if (auto image_index{ swapchain_->acquire_next_image(image_available_semaphores_[current_frame_index_]) }) {
         context_->reset_fence(image_in_flight_fences_[current_frame_index_]);
         submit(*image_index);
         present(*image_index);
+        last_submitted_frame_index_ = current_frame_index_;
         current_frame_index_ = (current_frame_index_ + 1) % max_frames_in_flight_;
+      } else {
+        return;
       }
+      
+      ++frame_stats_.frame_count;
+      frame_stats_.instance_count = world.instance_count();
+      frame_stats_.frame_time_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frame_start).count();
+      render_graph_->collect_stats(frame_stats_.passes);
+      collect_gpu_stats();
     }
   
     void record_command_buffer(vk::raii::CommandBuffer& command_buffer, u32 image_index)
     {
+      FOXY_PROFILE_SCOPE("Record command buffer");
       command_buffer.begin(vk::CommandBufferBeginInfo{});
+      // The fence for this frame slot has been waited on, so its queries can be resolved without stalling
+      gpu_profiler_->begin_frame(command_buffer, current_frame_index_);
+      gpu_profiler_->begin_scope(command_buffer, "frame", false);
+      
+      if (headless()) {
+        render_graph_->bind_image(backbuffer_, offscreen_->image(image_index), offscreen_->image_view(image_index));
+      } else {
+        render_graph_->bind_image(backbuffer_, swapchain_->image(image_index), *swapchain_->image_views()[image_index]);
+      }
+      bound_image_index_ = image_index;
+      render_graph_->execute(command_buffer, extent());
+      
+      gpu_profiler_->end_scope(command_buffer);
+      command_buffer.end();
+    }
     
-      vk::ClearValue clear_value{
-        .color = {{{ 0.f, 0.f, 0.f, 1.f }}}
-      };
-    
-      vk::RenderPassBeginInfo render_pass_begin_info{
-        .renderPass = **swapchain_->render_pass(),
-        .framebuffer = *swapchain_->framebuffers()[image_index],
-        .renderArea = {
-          .offset = { 0, 0 },
-          .extent = swapchain_->extent()
-        },
-        .clearValueCount = 1,
-        .pClearValues = &clear_value,
-      };
-    
-      command_buffer.beginRenderPass2(render_pass_begin_info, vk::SubpassBeginInfo{
-        .contents = vk::SubpassContents::eInline
-      });
-    
-      command_buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, ****pipeline_);
+    [[nodiscard]] auto read_frame() -> std::vector<u8>
+    {
+      if (!readback_ || frame_stats_.frame_count == 0) {
+        Log::error("No frame available for readback.");
+        return {};
+      }
+      
+      // Only blocks if the GPU is still working on the last submitted frame
+      context_->wait_for_fence(image_in_flight_fences_[last_submitted_frame_index_]);
+      const auto data{ offscreen_->readback_data(last_submitted_frame_index_) };
+      return { data.begin(), data.end() };
+    }
     
-      command_buffer.setViewport(0, pipeline_->viewport());
-      command_buffer.setScissor(0, pipeline_->scissor());
+    [[nodiscard]] auto frame_stats() const -> const FrameStats&
+    {
+      return frame_stats_;
+    }
     
-      command_buffer.draw(3, 1, 0, 0);
+    [[nodiscard]] auto gpu_profiler() const -> const GpuProfiler&
+    {
+      return *gpu_profiler_;
+    }
     
-      command_buffer.endRenderPass();
-      command_buffer.end();
+    [[nodiscard]] auto headless() const -> bool
+    {
+      return offscreen_ != nullptr;
     }
   
   private:
     const u32 max_frames_in_flight_;
     u32 current_frame_index_{ 0 };
-    bool framebuffer_resized_{ false };
+    u32 last_submitted_frame_index_{ 0 };
+    u32 bound_image_index_{ 0 };
+    // Set by the main thread (GLFW callback), consumed by the render thread
+    std::atomic<bool> framebuffer_resized_{ false };
+    const bool readback_;
   
     shared<Window> window_;
     shared<ookami::Context> context_;
     
+    // Exactly one of these exists: the swapchain when windowed, the offscreen target when headless
     shared<Swapchain> swapchain_;
+    unique<OffscreenTarget> offscreen_;
     shared<Pipeline> pipeline_;
     
     vk::raii::CommandPool command_pool_;
@@ -129,6 +192,151 @@ namespace fx {
     std::vector<vk::raii::Semaphore> render_complete_semaphores_;
     std::vector<vk::raii::Fence> image_in_flight_fences_;
     
+    unique<RenderGraph> render_graph_;
+    RenderGraph::ResourceID backbuffer_{ 0 };
+    
+    shared<GpuProfiler> gpu_profiler_;
+    FrameStats frame_stats_{};
+    
+    void collect_gpu_stats()
+    {
+      frame_stats_.gpu_frame = gpu_profiler_->results_frame();
+      frame_stats_.gpu_scopes = gpu_profiler_->results();
+      for (auto& pass: frame_stats_.passes) {
+        // Pass scopes sit directly under the "frame" scope
+        const auto scope{ std::ranges::find_if(frame_stats_.gpu_scopes, [&](const GpuScopeStats& scope) {
+          return scope.depth == 1 && scope.name == pass.name;
+        }) };
+        pass.gpu_time_ms = scope != frame_stats_.gpu_scopes.end() ? scope->gpu_time_ms : 0.;
+      }
+    }
+    
+    [[nodiscard]] auto color_format() const -> vk::Format
+    {
+      return headless() ? offscreen_->format() : swapchain_->format();
+    }
+    
+    [[nodiscard]] auto extent() const -> vk::Extent2D
+    {
+      return headless() ? offscreen_->extent() : swapchain_->extent();
+    }
+    
+    void build_render_graph()
+    {
+      if (headless()) {
+        // Cleared every frame, so the previous contents never need to be preserved
+        backbuffer_ = render_graph_->import_image("backbuffer", RenderGraph::ImageInfo{ .format = color_format() });
+      } else {
+        backbuffer_ = render_graph_->import_image(
+          "backbuffer",
+          RenderGraph::ImageInfo{ .format = color_format() },
+          RenderGraph::Access::SwapchainAcquire,
+          RenderGraph::Access::Present
+        );
+      }
+      
+      render_graph_->add_pass(
+        "forward",
+        [this](RenderGraph::PassBuilder& builder) {
+          builder.write(backbuffer_, RenderGraph::Access::ColorAttachmentWrite);
+        },
+        [this](RenderGraph::PassContext& pass) {
+          auto& command_buffer{ pass.command_buffer() };
+          const auto extent{ pass.extent() };
+          
+          const vk::RenderingAttachmentInfo color_attachment{
+            .imageView = pass.image_view(backbuffer_),
+            .imageLayout = vk::ImageLayout::eColorAttachmentOptimal,
+            .loadOp = vk::AttachmentLoadOp::eClear,
+            .storeOp = vk::AttachmentStoreOp::eStore,
+            .clearValue = {
+              .color = {{{ 0.f, 0.f, 0.f, 1.f }}}
+            },
+          };
+          
+          command_buffer.beginRendering(vk::RenderingInfo{
+            .renderArea = {
+              .offset = { 0, 0 },
+              .extent = extent
+            },
+            .layerCount = 1,
+            .colorAttachmentCount = 1,
+            .pColorAttachments = &color_attachment,
+          });
+          
+          command_buffer.bindPipeline(vk::PipelineBindPoint::eGraphics, ****pipeline_);
+          
+          command_buffer.setViewport(0, vk::Viewport{
+            .x = 0.f,
+            .y = 0.f,
+            .width = static_cast<float>(extent.width),
+            .height = static_cast<float>(extent.height),
+            .minDepth = 0.f,
+            .maxDepth = 1.f,
+          });
+          command_buffer.setScissor(0, vk::Rect2D{
+            .offset = { 0, 0 },
+            .extent = extent
+          });
+          
+          command_buffer.draw(3, 1, 0, 0);
+          
+          command_buffer.endRendering();
+        }
+      );
+      
+      if (!headless()) {
+        return;
+      }
+      
+      if (!readback_) {
+        render_graph_->mark_output(backbuffer_);
+        return;
+      }
+      
+      render_graph_->add_pass(
+        "readback",
+        [this](RenderGraph::PassBuilder& builder) {
+          builder.read(backbuffer_, RenderGraph::Access::TransferRead).set_side_effects();
+        },
+        [this](RenderGraph::PassContext& pass) {
+          auto& command_buffer{ pass.command_buffer() };
+          const auto extent{ pass.extent() };
+          
+          command_buffer.copyImageToBuffer(
+            pass.image(backbuffer_),
+            vk::ImageLayout::eTransferSrcOptimal,
+            offscreen_->readback_buffer(bound_image_index_),
+            vk::BufferImageCopy{
+              .bufferOffset = 0,
+              .bufferRowLength = 0,
+              .bufferImageHeight = 0,
+              .imageSubresource = {
+                .aspectMask = vk::ImageAspectFlagBits::eColor,
+                .mipLevel = 0,
+                .baseArrayLayer = 0,
+                .layerCount = 1,
+              },
+              .imageOffset = { 0, 0, 0 },
+              .imageExtent = { extent.width, extent.height, 1 },
+            }
+          );
+          
+          // Make the copy visible to the host once the frame fence signals
+          const vk::MemoryBarrier2 host_barrier{
+            .srcStageMask = vk::PipelineStageFlagBits2::eTransfer,
+            .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+            .dstStageMask = vk::PipelineStageFlagBits2::eHost,
+            .dstAccessMask = vk::AccessFlagBits2::eHostRead,
+          };
+          command_buffer.pipelineBarrier2(vk::DependencyInfo{
+            .memoryBarrierCount = 1,
+            .pMemoryBarriers = &host_barrier,
+          });
+        }
+      );
+    }
+    
     void submit(u32 image_index)
     {
       auto& command_buffer{ command_buffers_[current_frame_index_] };
@@ -146,12 +354,19 @@ namespace fx {
         .signalSemaphoreCount = 1,
         .pSignalSemaphores = &*render_complete_semaphores_[current_frame_index_],
       };
+      if (headless()) {
+        // Nothing to acquire from or present to, the fence alone tracks completion
+        submit_info.waitSemaphoreCount = 0;
+        submit_info.signalSemaphoreCount = 0;
+      }
   
+      FOXY_PROFILE_SCOPE("Queue submit");
       context_->graphics_queue().submit(submit_info, *image_in_flight_fences_[current_frame_index_]);
     }
     
     void present(u32 image_index)
     {
+      FOXY_PROFILE_SCOPE("Present");
       vk::PresentInfoKHR present_info{
         .waitSemaphoreCount = 1,
         .pWaitSemaphores = &*render_complete_semaphores_[current_frame_index_],
@@ -167,9 +382,8 @@ namespace fx {
           swapchain_->rebuild();
         }
     
-        if (framebuffer_resized_) {
+        if (framebuffer_resized_.exchange(false, std::memory_order_relaxed)) {
           // recreate swapchain and try drawing in the next frame (make sure not to draw THIS frame!)
-          framebuffer_resized_ = false;
           swapchain_->rebuild();
           return;
         }
@@ -195,15 +409,42 @@ namespace fx {
   ):
     p_impl_{ std::make_unique<Impl>(window, context, shader, max_frames_in_flight) } {}
   
+  LowLevelRenderer::LowLevelRenderer(
+    const shared<ookami::Context>& context,
+    const shared<Shader>& shader,
+    const HeadlessCreateInfo& headless_info
+  ):
+    p_impl_{ std::make_unique<Impl>(nullptr, context, shader, headless_info.frames_in_flight, headless_info) } {}
+  
   LowLevelRenderer::~LowLevelRenderer() = default;
   
-  void LowLevelRenderer::draw()
+  void LowLevelRenderer::draw(const RenderWorld& world)
   {
-    p_impl_->draw();
+    p_impl_->draw(world);
   }
   
   void LowLevelRenderer::record_command_buffer(vk::raii::CommandBuffer& command_buffer, u32 image_index)
   {
     p_impl_->record_command_buffer(command_buffer, image_index);
   }
+  
+  auto LowLevelRenderer::read_frame() -> std::vector<u8>
+  {
+    return p_impl_->read_frame();
+  }
+  
+  auto LowLevelRenderer::frame_stats() const -> const FrameStats&
+  {
+    return p_impl_->frame_stats();
+  }
+  
+  auto LowLevelRenderer::gpu_profiler() const -> const GpuProfiler&
+  {
+    return p_impl_->gpu_profiler();
+  }
+  
+  auto LowLevelRenderer::headless() const -> bool
+  {
+    return p_impl_->headless();
+  }
 } // fx
\ No newline at end of file
@@ -11,6 +11,10 @@ namespace vk::raii {
 namespace fx {
   class Window;
   class Shader;
+  class RenderWorld;
+  struct HeadlessCreateInfo;
+  struct FrameStats;
+  class GpuProfiler;
   
   namespace ookami {
     class Context;
@@ -24,10 +28,23 @@ namespace fx {
       const shared<Shader>& shader,
       u32 max_frames_in_flight = 1
     );
+    // Renders into an offscreen target instead of a swapchain, no window required
+    explicit LowLevelRenderer(
+      const shared<ookami::Context>& context,
+      const shared<Shader>& shader,
+      const HeadlessCreateInfo& headless_info
+    );
     ~LowLevelRenderer();
   
     void record_command_buffer(vk::raii::CommandBuffer& command_buffer, u32 image_index);
-    void draw();
+    // Only the instance count is read from the world for now, the forward pass still draws a fixed triangle
+    void draw(const RenderWorld& world);
+    
+    // Tightly packed RGBA8 copy of the last submitted frame (headless with readback only)
+    [[nodiscard]] auto read_frame() -> std::vector<u8>;
+    [[nodiscard]] auto frame_stats() const -> const FrameStats&;
+    [[nodiscard]] auto gpu_profiler() const -> const GpuProfiler&;
+    [[nodiscard]] auto headless() const -> bool;
 
   private:
     class Impl;
@@ -0,0 +1,173 @@
+#include "offscreen_target.hpp"
+
+#include "context.hpp"
+
+#include "vulkan/static.hpp"
+
+namespace fx {
+  class OffscreenTarget::Impl {
+  public:
+    explicit Impl(const shared<ookami::Context>& context, const u32 width, const u32 height, const u32 frame_count):
+      context_{ context },
+      extent_{ .width = width, .height = height }
+    {
+      Log::trace("Creating offscreen target ({}x{}, {} frames)...", width, height, frame_count);
+
+      auto& device{ context_->logical_device() };
+      const vk::DeviceSize frame_size{ static_cast<vk::DeviceSize>(width) * height * bytes_per_pixel_ };
+
+      for (u32 i{ 0 }; i < frame_count; ++i) {
+        try {
+          images_.emplace_back(device, vk::ImageCreateInfo{
+            .imageType = vk::ImageType::e2D,
+            .format = format_,
+            .extent = { .width = width, .height = height, .depth = 1 },
+            .mipLevels = 1,
+            .arrayLayers = 1,
+            .samples = vk::SampleCountFlagBits::e1,
+            .tiling = vk::ImageTiling::eOptimal,
+            .usage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc,
+            .sharingMode = vk::SharingMode::eExclusive,
+            .initialLayout = vk::ImageLayout::eUndefined,
+          });
+          image_memory_.push_back(allocate(
+            images_.back().getMemoryRequirements(),
+            static_cast<u32>(vk::MemoryPropertyFlagBits::eDeviceLocal)
+          ));
+          images_.back().bindMemory(*image_memory_.back(), 0);
+
+          image_views_.emplace_back(device, vk::ImageViewCreateInfo{
+            .image = *images_.back(),
+            .viewType = vk::ImageViewType::e2D,
+            .format = format_,
+            .subresourceRange = {
+              .aspectMask = vk::ImageAspectFlagBits::eColor,
+              .baseMipLevel = 0,
+              .levelCount = 1,
+              .baseArrayLayer = 0,
+              .layerCount = 1,
+            },
+          });
+
+          readback_buffers_.emplace_back(device, vk::BufferCreateInfo{
+            .size = frame_size,
+            .usage = vk::BufferUsageFlagBits::eTransferDst,
+            .sharingMode = vk::SharingMode::eExclusive,
+          });
+          readback_memory_.push_back(allocate(
+            readback_buffers_.back().getMemoryRequirements(),
+            static_cast<u32>(vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent)
+          ));
+          readback_buffers_.back().bindMemory(*readback_memory_.back(), 0);
+          readback_data_.emplace_back(
+            static_cast<const u8*>(readback_memory_.back().mapMemory(0, frame_size)),
+            static_cast<std::size_t>(frame_size)
+          );
+        } catch (const std::exception& e) {
+          Log::fatal("Failed to create offscreen target: {}", e.what());
+        }
+      }
+
+      Log::trace("Created offscreen target.");
+    }
+
+    ~Impl() = default;
+
+    [[nodiscard]] auto format() const -> vk::Format
+    {
+      return format_;
+    }
+
+    [[nodiscard]] auto extent() const -> vk::Extent2D
+    {
+      return extent_;
+    }
+
+    [[nodiscard]] auto image(const u32 index) const -> vk::Image
+    {
+      return *images_.at(index);
+    }
+
+    [[nodiscard]] auto image_view(const u32 index) const -> vk::ImageView
+    {
+      return *image_views_.at(index);
+    }
+
+    [[nodiscard]] auto readback_buffer(const u32 index) const -> vk::Buffer
+    {
+      return *readback_buffers_.at(index);
+    }
+
+    [[nodiscard]] auto readback_data(const u32 index) const -> std::span<const u8>
+    {
+      return readback_data_.at(index);
+    }
+
+  private:
+    // Tightly packed RGBA8 keeps readbacks trivially comparable across drivers (including software ones)
+    static constexpr inline vk::Format format_{ vk::Format::eR8G8B8A8Unorm };
+    static constexpr inline u32 bytes_per_pixel_{ 4 };
+
+    shared<ookami::Context> context_;
+    vk::Extent2D extent_;
+
+    std::vector<vk::raii::DeviceMemory> image_memory_;
+    std::vector<vk::raii::DeviceMemory> readback_memory_;
+    std::vector<vk::raii::Image> images_;
+    std::vector<vk::raii::ImageView> image_views_;
+    std::vector<vk::raii::Buffer> readback_buffers_;
+    std::vector<std::span<const u8>> readback_data_;
+
+    [[nodiscard]] auto allocate(const vk::MemoryRequirements& requirements, const u32 properties) const -> vk::raii::DeviceMemory
+    {
+      const auto memory_type{ context_->find_memory_type(requirements.memoryTypeBits, properties) };
+      if (!memory_type) {
+        Log::fatal("Failed to find a suitable memory type for offscreen target.");
+        return nullptr;
+      }
+      return { context_->logical_device(), vk::MemoryAllocateInfo{
+        .allocationSize = requirements.size,
+        .memoryTypeIndex = *memory_type,
+      }};
+    }
+  };
+
+  //
+  //  OffscreenTarget
+  //
+
+  OffscreenTarget::OffscreenTarget(const shared<ookami::Context>& context, const u32 width, const u32 height, const u32 frame_count):
+    p_impl_{ std::make_unique<Impl>(context, width, height, frame_count) } {}
+
+  OffscreenTarget::~OffscreenTarget() = default;
+
+  auto OffscreenTarget::format() const -> vk::Format
+  {
+    return p_impl_->format();
+  }
+
+  auto OffscreenTarget::extent() const -> vk::Extent2D
+  {
+    return p_impl_->extent();
+  }
+
+  auto OffscreenTarget::image(const u32 index) const -> vk::Image
+  {
+    return p_impl_->image(index);
+  }
+
+  auto OffscreenTarget::image_view(const u32 index) const -> vk::ImageView
+  {
+    return p_impl_->image_view(index);
+  }
+
+  auto OffscreenTarget::readback_buffer(const u32 index) const -> vk::Buffer
+  {
+    return p_impl_->readback_buffer(index);
+  }
+
+  auto OffscreenTarget::readback_data(const u32 index) const -> std::span<const u8>
+  {
+    return p_impl_->readback_data(index);
+  }
+}
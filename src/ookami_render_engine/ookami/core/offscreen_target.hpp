@@ -0,0 +1,35 @@
+#pragma once
+
+namespace vk {
+  enum class Format;
+  class Extent2D;
+  class Image;
+  class ImageView;
+  class Buffer;
+}
+
+namespace fx {
+  namespace ookami {
+    class Context;
+  }
+
+  // Stand-in for the swapchain when rendering without a window. Each frame in flight gets its own color image
+  // plus a persistently mapped, host visible buffer the image can be copied into for readback.
+  class OffscreenTarget {
+  public:
+    explicit OffscreenTarget(const shared<ookami::Context>& context, u32 width, u32 height, u32 frame_count);
+    ~OffscreenTarget();
+
+    [[nodiscard]] auto format() const -> vk::Format;
+    [[nodiscard]] auto extent() const -> vk::Extent2D;
+    [[nodiscard]] auto image(u32 index) const -> vk::Image;
+    [[nodiscard]] auto image_view(u32 index) const -> vk::ImageView;
+    [[nodiscard]] auto readback_buffer(u32 index) const -> vk::Buffer;
+    // Only valid once the frame that copied into this buffer has finished on the GPU
+    [[nodiscard]] auto readback_data(u32 index) const -> std::span<const u8>;
+
+  private:
+    class Impl;
+    unique<Impl> p_impl_;
+  };
+}
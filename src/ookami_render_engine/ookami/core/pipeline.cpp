@@ -5,7 +5,6 @@
 #include "pipeline.hpp"
 
 #include "context.hpp"
-#include "swapchain.hpp"
 #include "shader.hpp"
 
 #include "vulkan/static.hpp"
@@ -15,12 +14,12 @@ namespace fx {
   public:
     explicit Impl(
       const shared<ookami::Context>& context,
-      const shared<Swapchain>& swapchain,
-      const shared<Shader>& shader
+      const shared<Shader>& shader,
+      const vk::Format color_format
     ):
       context_{ context },
-      swapchain_{ swapchain },
-      shader_{ shader }
+      shader_{ shader },
+      color_format_{ color_format }
     {
       Log::trace("Creating Vulkan pipeline...");
 
@@ -57,25 +56,10 @@ namespace fx {
         .primitiveRestartEnable = false,
       };
 
-      viewport_ = vk::Viewport{
-        .x = 0.f,
-        .y = 0.f,
-        .width = static_cast<float>(swapchain_->extent().width),
-        .height = static_cast<float>(swapchain_->extent().height),
-        .minDepth = 0.f,
-        .maxDepth = 1.f,
-      };
-
-      scissor_ = vk::Rect2D{
-        .offset = { 0, 0 },
-        .extent = swapchain_->extent()
-      };
-
+      // Viewport and scissor are dynamic and get set from the render target's extent at record time
       vk::PipelineViewportStateCreateInfo viewport_state_info{
         .viewportCount = 1,
-        .pViewports = &viewport_,
         .scissorCount = 1,
-        .pScissors = &scissor_,
       };
 
       vk::PipelineRasterizationStateCreateInfo rasterizer_info{
@@ -124,7 +108,13 @@ namespace fx {
         Log::fatal("Failed to create pipeline layout: {}", e.what());
       }
 
+      vk::PipelineRenderingCreateInfo rendering_info{
+        .colorAttachmentCount = 1,
+        .pColorAttachmentFormats = &color_format_,
+      };
+
       vk::GraphicsPipelineCreateInfo pipeline_info{
+        .pNext = &rendering_info,
         .stageCount = static_cast<u32>(shader_stages.size()),
         .pStages = shader_stages.data(),
         .pVertexInputState = &vertex_input_info,
@@ -136,7 +126,7 @@ namespace fx {
         .pColorBlendState = &color_blend_info,
         .pDynamicState = &dynamic_state,
         .layout = **layout_,
-        .renderPass = **swapchain_->render_pass(),
+        .renderPass = nullptr,
         .subpass = 0,
       };
 
@@ -151,16 +141,6 @@ namespace fx {
 
     ~Impl() = default;
   
-    [[nodiscard]] auto viewport() const -> const vk::Viewport&
-    {
-      return viewport_;
-    }
-  
-    [[nodiscard]] auto scissor() const -> const vk::Rect2D&
-    {
-      return scissor_;
-    }
-  
     auto operator*() -> unique<vk::raii::Pipeline>&
     {
       return pipeline_;
@@ -168,11 +148,9 @@ namespace fx {
 
   private:
     shared<ookami::Context> context_;
-    shared<Swapchain> swapchain_;
     shared<Shader> shader_;
     
-    vk::Viewport viewport_;
-    vk::Rect2D scissor_;
+    vk::Format color_format_;
     vk::PipelineColorBlendAttachmentState color_blend_attachment_;
     unique<vk::raii::PipelineLayout> layout_;
     unique<vk::raii::Pipeline> pipeline_;
@@ -184,23 +162,13 @@ namespace fx {
 
   Pipeline::Pipeline(
     const shared<ookami::Context>& context,
-    const shared<Swapchain>& swapchain,
-    const shared<Shader>& shader
+    const shared<Shader>& shader,
+    const vk::Format color_format
   ):
-    p_impl_{ std::make_unique<Impl>(context, swapchain, shader) } {}
+    p_impl_{ std::make_unique<Impl>(context, shader, color_format) } {}
 
   Pipeline::~Pipeline() = default;
   
-  auto Pipeline::viewport() const -> const vk::Viewport&
-  {
-    return p_impl_->viewport();
-  }
-  
-  auto Pipeline::scissor() const -> const vk::Rect2D&
-  {
-    return p_impl_->scissor();
-  }
-  
   auto Pipeline::operator*() -> unique<vk::raii::Pipeline>&
   {
     return **p_impl_;
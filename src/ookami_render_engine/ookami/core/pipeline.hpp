@@ -5,18 +5,15 @@
 #pragma once
 
 namespace vk {
-  class Viewport;
-  class Rect2D;
+  enum class Format;
   
   namespace raii {
-    class RenderPass;
     class Pipeline;
   }
 }
 
 namespace fx {
   class Shader;
-  class Swapchain;
 
   namespace ookami {
     class Context;
@@ -24,15 +21,13 @@ namespace fx {
 
   class Pipeline {
   public:
+    // Pipelines target dynamic rendering, so they only need to know the attachment formats up front
     explicit Pipeline(
       const shared<ookami::Context>& context,
-      const shared<Swapchain>& swapchain,
-      const shared<Shader>& shader
+      const shared<Shader>& shader,
+      vk::Format color_format
     );
     ~Pipeline();
-    
-    [[nodiscard]] auto viewport() const -> const vk::Viewport&;
-    [[nodiscard]] auto scissor() const -> const vk::Rect2D&;
   
     auto operator*() -> unique<vk::raii::Pipeline>&;
     
@@ -0,0 +1,800 @@
+#include "render_graph.hpp"
+
+#include "context.hpp"
+#include "frame_stats.hpp"
+#include "gpu_profiler.hpp"
+
+#include "vulkan/static.hpp"
+#include <kitsune/profiler.hpp>
+
+namespace fx {
+  namespace {
+    struct AccessInfo {
+      vk::PipelineStageFlags2 stages{};
+      vk::AccessFlags2 access{};
+      vk::ImageLayout layout{ vk::ImageLayout::eUndefined };
+      vk::ImageUsageFlags usage{};
+      bool write{ false };
+      bool depth{ false };
+    };
+
+    [[nodiscard]] auto access_info(const RenderGraph::Access access) -> AccessInfo
+    {
+      using Stage = vk::PipelineStageFlagBits2;
+      using Flag = vk::AccessFlagBits2;
+      using Usage = vk::ImageUsageFlagBits;
+
+      switch (access) {
+        case RenderGraph::Access::ColorAttachmentWrite:
+          return {
+            Stage::eColorAttachmentOutput, Flag::eColorAttachmentWrite | Flag::eColorAttachmentRead,
+            vk::ImageLayout::eColorAttachmentOptimal, Usage::eColorAttachment, true
+          };
+        case RenderGraph::Access::ColorAttachmentRead:
+          return {
+            Stage::eColorAttachmentOutput, Flag::eColorAttachmentRead,
+            vk::ImageLayout::eColorAttachmentOptimal, Usage::eColorAttachment, false
+          };
+        case RenderGraph::Access::DepthAttachmentWrite:
+          return {
+            Stage::eEarlyFragmentTests | Stage::eLateFragmentTests,
+            Flag::eDepthStencilAttachmentWrite | Flag::eDepthStencilAttachmentRead,
+            vk::ImageLayout::eDepthAttachmentOptimal, Usage::eDepthStencilAttachment, true, true
+          };
+        case RenderGraph::Access::DepthAttachmentRead:
+          return {
+            Stage::eEarlyFragmentTests | Stage::eLateFragmentTests, Flag::eDepthStencilAttachmentRead,
+            vk::ImageLayout::eDepthReadOnlyOptimal, Usage::eDepthStencilAttachment, false, true
+          };
+        case RenderGraph::Access::FragmentShaderRead:
+          return {
+            Stage::eFragmentShader, Flag::eShaderSampledRead,
+            vk::ImageLayout::eShaderReadOnlyOptimal, Usage::eSampled, false
+          };
+        case RenderGraph::Access::ComputeShaderRead:
+          return {
+            Stage::eComputeShader, Flag::eShaderSampledRead,
+            vk::ImageLayout::eShaderReadOnlyOptimal, Usage::eSampled, false
+          };
+        case RenderGraph::Access::ComputeShaderWrite:
+          return {
+            Stage::eComputeShader, Flag::eShaderStorageWrite | Flag::eShaderStorageRead,
+            vk::ImageLayout::eGeneral, Usage::eStorage, true
+          };
+        case RenderGraph::Access::TransferRead:
+          return {
+            Stage::eTransfer, Flag::eTransferRead,
+            vk::ImageLayout::eTransferSrcOptimal, Usage::eTransferSrc, false
+          };
+        case RenderGraph::Access::TransferWrite:
+          return {
+            Stage::eTransfer, Flag::eTransferWrite,
+            vk::ImageLayout::eTransferDstOptimal, Usage::eTransferDst, true
+          };
+        case RenderGraph::Access::SwapchainAcquire:
+          // Matches the stage the acquire semaphore is waited on, so the first transition chains after it
+          return { Stage::eColorAttachmentOutput, Flag::eNone, vk::ImageLayout::eUndefined, {}, false };
+        case RenderGraph::Access::Present:
+          return { Stage::eNone, Flag::eNone, vk::ImageLayout::ePresentSrcKHR, {}, false };
+        case RenderGraph::Access::None:
+        default:  // NOLINT(clang-diagnostic-covered-switch-default)
+          return {};
+      }
+    }
+  }
+
+  class RenderGraph::Impl {
+    friend class RenderGraph;
+
+  public:
+    explicit Impl(const shared<ookami::Context>& context):
+      context_{ context }
+    {
+      Log::trace("Created render graph.");
+    }
+
+    ~Impl() = default;
+
+    auto create_image(const std::string& name, const ImageInfo& info, const bool imported) -> ResourceID
+    {
+      const auto id{ static_cast<ResourceID>(resources_.size()) };
+      resources_.push_back(Resource{
+        .name = name,
+        .info = info,
+        .imported = imported,
+      });
+      dirty_ = true;
+      return id;
+    }
+
+    auto import_image(
+      const std::string& name,
+      const ImageInfo& info,
+      const Access initial_access,
+      const Access final_access
+    ) -> ResourceID
+    {
+      const auto id{ create_image(name, info, true) };
+      resources_[id].initial_access = initial_access;
+      resources_[id].final_access = final_access;
+      return id;
+    }
+
+    void mark_output(const ResourceID resource)
+    {
+      resources_.at(resource).output = true;
+      dirty_ = true;
+    }
+
+    auto add_pass(const std::string& name, ExecuteCallback&& execute) -> u32
+    {
+      const auto index{ static_cast<u32>(passes_.size()) };
+      passes_.push_back(Pass{
+        .name = name,
+        .execute = std::move(execute),
+        .profile_name = kitsune::Profiler::intern(name),
+      });
+      dirty_ = true;
+      return index;
+    }
+
+    void add_access(const u32 pass_index, const ResourceID resource, const Access access, const bool write)
+    {
+      if (resource >= resources_.size()) {
+        Log::fatal(R"(Render graph pass "{}" references unknown resource {})", passes_[pass_index].name, resource);
+        return;
+      }
+      auto& accesses{ write ? passes_[pass_index].writes : passes_[pass_index].reads };
+      accesses.emplace_back(resource, access);
+      dirty_ = true;
+    }
+
+    void set_side_effects(const u32 pass_index, const bool side_effects)
+    {
+      passes_[pass_index].side_effects = side_effects;
+      dirty_ = true;
+    }
+
+    void bind_image(const ResourceID resource, const vk::Image image, const vk::ImageView image_view)
+    {
+      auto& res{ resources_.at(resource) };
+      res.image = image;
+      res.image_view = image_view;
+    }
+
+    void execute(PassContext& pass_context, vk::raii::CommandBuffer& command_buffer, const vk::Extent2D extent)
+    {
+      if (dirty_ || extent != compiled_extent_) {
+        compile(extent);
+      }
+
+      for (auto& pass: passes_) {
+        if (pass.culled) {
+          continue;
+        }
+        const auto start{ std::chrono::steady_clock::now() };
+        FOXY_PROFILE_SCOPE(pass.profile_name);
+        if (profiler_) {
+          profiler_->begin_scope(command_buffer, pass.name);
+        }
+        record_barriers(command_buffer, pass.barriers, pass.barrier_resources);
+        pass.execute(pass_context);
+        if (profiler_) {
+          profiler_->end_scope(command_buffer);
+        }
+        pass.record_time_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+      }
+      record_barriers(command_buffer, final_barriers_, final_barrier_resources_);
+    }
+
+    void invalidate()
+    {
+      dirty_ = true;
+    }
+
+    void set_profiler(const shared<GpuProfiler>& profiler)
+    {
+      profiler_ = profiler;
+    }
+
+    void collect_stats(std::vector<PassStats>& stats) const
+    {
+      stats.clear();
+      for (const auto& pass: passes_) {
+        if (!pass.culled) {
+          stats.push_back(PassStats{ .name = pass.name, .cpu_time_ms = pass.record_time_ms });
+        }
+      }
+    }
+
+    [[nodiscard]] auto image(const ResourceID resource) const -> vk::Image
+    {
+      return resources_.at(resource).image;
+    }
+
+    [[nodiscard]] auto image_view(const ResourceID resource) const -> vk::ImageView
+    {
+      return resources_.at(resource).image_view;
+    }
+
+    [[nodiscard]] auto extent() const -> vk::Extent2D
+    {
+      return compiled_extent_;
+    }
+
+  private:
+    struct Resource {
+      std::string name;
+      ImageInfo info;
+      bool imported{ false };
+      bool output{ false };
+      Access initial_access{ Access::None };
+      Access final_access{ Access::None };
+
+      // Compiled
+      vk::ImageUsageFlags usage{};
+      vk::ImageAspectFlags aspect{ vk::ImageAspectFlagBits::eColor };
+      i32 first_pass{ -1 };
+      i32 last_pass{ -1 };
+      std::optional<ResourceID> alias_predecessor{ std::nullopt };
+      // Set on the first resource placed in each block: the block's last occupant, still in use by the previous
+      // frame in flight when this one starts writing
+      std::optional<ResourceID> frame_predecessor{ std::nullopt };
+
+      // Bound (imported) or allocated (transient)
+      vk::Image image{};
+      vk::ImageView image_view{};
+    };
+
+    struct Pass {
+      std::string name;
+      std::vector<std::pair<ResourceID, Access>> reads{};
+      std::vector<std::pair<ResourceID, Access>> writes{};
+      ExecuteCallback execute;
+      bool side_effects{ false };
+      // Interned copy of the name for CPU profiler zones
+      const char* profile_name{ nullptr };
+
+      // Compiled
+      bool culled{ false };
+      std::vector<vk::ImageMemoryBarrier2> barriers{};
+      std::vector<ResourceID> barrier_resources{};
+
+      // CPU time spent recording this pass (barriers included) during the last execute
+      double record_time_ms{ 0. };
+    };
+
+    struct ResourceState {
+      vk::ImageLayout layout{ vk::ImageLayout::eUndefined };
+      vk::PipelineStageFlags2 write_stages{};
+      vk::AccessFlags2 write_access{};
+      // Read stages that have already been made visible since the last write/transition
+      vk::PipelineStageFlags2 read_stages{};
+    };
+
+    struct MemoryBlock {
+      vk::DeviceSize size{ 0 };
+      u32 type_bits{ ~0U };
+      i32 last_pass{ -1 };
+      ResourceID occupant{ 0 };
+    };
+
+    shared<ookami::Context> context_;
+    shared<GpuProfiler> profiler_{ nullptr };
+
+    bool dirty_{ true };
+    vk::Extent2D compiled_extent_{};
+
+    std::vector<Resource> resources_;
+    std::vector<Pass> passes_;
+    std::vector<vk::ImageMemoryBarrier2> final_barriers_;
+    std::vector<ResourceID> final_barrier_resources_;
+
+    u32 culled_pass_count_{ 0 };
+    u32 barrier_count_{ 0 };
+    u64 transient_memory_size_{ 0 };
+    u64 transient_memory_size_unaliased_{ 0 };
+
+    // Declared in this order so images are destroyed before the memory they are bound to
+    std::vector<vk::raii::DeviceMemory> transient_memory_;
+    std::vector<vk::raii::Image> transient_images_;
+    std::vector<vk::raii::ImageView> transient_image_views_;
+
+    void compile(const vk::Extent2D extent)
+    {
+      FOXY_PROFILE_SCOPE("Compile render graph");
+      Log::trace("Compiling render graph ({}x{})...", extent.width, extent.height);
+      const auto sw{ Stopwatch() };
+
+      if (!transient_images_.empty()) {
+        // Transient images may still be referenced by frames in flight
+        context_->logical_device().waitIdle();
+      }
+      transient_image_views_.clear();
+      transient_images_.clear();
+      transient_memory_.clear();
+
+      compiled_extent_ = extent;
+      cull_passes();
+      compute_lifetimes();
+      allocate_transients();
+      compute_barriers();
+
+      dirty_ = false;
+      Log::trace(
+        "Compiled render graph: {} passes ({} culled), {} barriers, transient memory {} B ({} B without aliasing) ({} s)",
+        passes_.size(), culled_pass_count_, barrier_count_, transient_memory_size_, transient_memory_size_unaliased_,
+        sw.get_time_elapsed<secs>()
+      );
+    }
+
+    void cull_passes()
+    {
+      // Walk passes backwards: a pass survives if it has side effects or produces something that is needed,
+      // and everything a surviving pass touches becomes needed in turn.
+      std::vector needed(resources_.size(), false);
+      for (ResourceID i{ 0 }; i < resources_.size(); ++i) {
+        needed[i] = resources_[i].output || (resources_[i].imported && resources_[i].final_access != Access::None);
+      }
+
+      culled_pass_count_ = 0;
+      for (auto& pass: std::views::reverse(passes_)) {
+        pass.culled = !pass.side_effects && std::ranges::none_of(pass.writes, [&](const auto& write) {
+          return needed[write.first];
+        });
+
+        if (pass.culled) {
+          ++culled_pass_count_;
+          Log::trace(R"(Culled render graph pass "{}")", pass.name);
+          continue;
+        }
+
+        // Writes count as well since earlier contents may be loaded rather than cleared
+        for (const auto& [resource, access]: pass.reads) needed[resource] = true;
+        for (const auto& [resource, access]: pass.writes) needed[resource] = true;
+      }
+    }
+
+    void compute_lifetimes()
+    {
+      for (auto& resource: resources_) {
+        resource.usage = {};
+        resource.aspect = vk::ImageAspectFlagBits::eColor;
+        resource.first_pass = -1;
+        resource.last_pass = -1;
+        resource.alias_predecessor = std::nullopt;
+        resource.frame_predecessor = std::nullopt;
+      }
+
+      for (i32 i{ 0 }; i < static_cast<i32>(passes_.size()); ++i) {
+        if (passes_[i].culled) {
+          continue;
+        }
+        const auto touch{ [&](const ResourceID id, const Access access) {
+          auto& resource{ resources_[id] };
+          const auto info{ access_info(access) };
+          resource.usage |= info.usage;
+          if (info.depth) {
+            resource.aspect = vk::ImageAspectFlagBits::eDepth;
+          }
+          if (resource.first_pass < 0) {
+            resource.first_pass = i;
+          }
+          resource.last_pass = i;
+        } };
+        for (const auto& [resource, access]: passes_[i].reads) touch(resource, access);
+        for (const auto& [resource, access]: passes_[i].writes) touch(resource, access);
+      }
+    }
+
+    void allocate_transients()
+    {
+      auto& device{ context_->logical_device() };
+
+      std::vector<ResourceID> transients;
+      for (ResourceID i{ 0 }; i < resources_.size(); ++i) {
+        if (!resources_[i].imported && resources_[i].first_pass >= 0) {
+          transients.push_back(i);
+        }
+      }
+      std::ranges::sort(transients, {}, [&](const ResourceID id) { return resources_[id].first_pass; });
+
+      std::vector<vk::MemoryRequirements> requirements;
+      for (const auto id: transients) {
+        const auto& resource{ resources_[id] };
+        transient_images_.emplace_back(device, vk::ImageCreateInfo{
+          .imageType = vk::ImageType::e2D,
+          .format = resource.info.format,
+          .extent = {
+            .width = resource.info.width == 0 ? compiled_extent_.width : resource.info.width,
+            .height = resource.info.height == 0 ? compiled_extent_.height : resource.info.height,
+            .depth = 1,
+          },
+          .mipLevels = 1,
+          .arrayLayers = 1,
+          .samples = vk::SampleCountFlagBits::e1,
+          .tiling = vk::ImageTiling::eOptimal,
+          .usage = resource.usage,
+          .sharingMode = vk::SharingMode::eExclusive,
+          .initialLayout = vk::ImageLayout::eUndefined,
+        });
+        requirements.push_back(transient_images_.back().getMemoryRequirements());
+      }
+
+      // Greedy interval packing: a block can be reused once its current occupant is dead. Transients are
+      // visited in order of first use, so any free block is free for the rest of this resource's lifetime.
+      std::vector<MemoryBlock> blocks;
+      std::vector<u32> block_of(transients.size());
+      transient_memory_size_unaliased_ = 0;
+      for (u32 i{ 0 }; i < transients.size(); ++i) {
+        auto& resource{ resources_[transients[i]] };
+        const auto& req{ requirements[i] };
+        transient_memory_size_unaliased_ += req.size;
+
+        std::optional<u32> best{ std::nullopt };
+        for (u32 b{ 0 }; b < blocks.size(); ++b) {
+          if (blocks[b].last_pass >= resource.first_pass || (blocks[b].type_bits & req.memoryTypeBits) == 0) {
+            continue;
+          }
+          // Prefer the smallest block that already fits, otherwise the largest one to grow
+          if (!best
+              || (blocks[b].size >= req.size && (blocks[*best].size < req.size || blocks[b].size < blocks[*best].size))
+              || (blocks[*best].size < req.size && blocks[b].size > blocks[*best].size)) {
+            best = b;
+          }
+        }
+
+        if (best) {
+          resource.alias_predecessor = blocks[*best].occupant;
+        } else {
+          best = static_cast<u32>(blocks.size());
+          blocks.emplace_back();
+        }
+
+        auto& block{ blocks[*best] };
+        block.size = std::max(block.size, (req.size + req.alignment - 1) / req.alignment * req.alignment);
+        block.type_bits &= req.memoryTypeBits;
+        block.last_pass = resource.last_pass;
+        block.occupant = transients[i];
+        block_of[i] = *best;
+      }
+
+      for (u32 i{ 0 }; i < transients.size(); ++i) {
+        if (!resources_[transients[i]].alias_predecessor) {
+          resources_[transients[i]].frame_predecessor = blocks[block_of[i]].occupant;
+        }
+      }
+
+      transient_memory_size_ = 0;
+      for (const auto& block: blocks) {
+        const auto memory_type{
+          context_->find_memory_type(block.type_bits, static_cast<u32>(vk::MemoryPropertyFlagBits::eDeviceLocal))
+        };
+        if (!memory_type) {
+          Log::fatal("Failed to find a device local memory type for render graph transients.");
+          return;
+        }
+        transient_memory_.emplace_back(device, vk::MemoryAllocateInfo{
+          .allocationSize = block.size,
+          .memoryTypeIndex = *memory_type,
+        });
+        transient_memory_size_ += block.size;
+      }
+
+      for (u32 i{ 0 }; i < transients.size(); ++i) {
+        auto& resource{ resources_[transients[i]] };
+        transient_images_[i].bindMemory(*transient_memory_[block_of[i]], 0);
+        transient_image_views_.emplace_back(device, vk::ImageViewCreateInfo{
+          .image = *transient_images_[i],
+          .viewType = vk::ImageViewType::e2D,
+          .format = resource.info.format,
+          .subresourceRange = {
+            .aspectMask = resource.aspect,
+            .baseMipLevel = 0,
+            .levelCount = 1,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+          },
+        });
+        resource.image = *transient_images_[i];
+        resource.image_view = *transient_image_views_.back();
+      }
+    }
+
+    void compute_barriers()
+    {
+      std::vector<ResourceState> states(resources_.size());
+      for (ResourceID i{ 0 }; i < resources_.size(); ++i) {
+        if (resources_[i].imported) {
+          const auto initial{ access_info(resources_[i].initial_access) };
+          states[i] = ResourceState{
+            .layout = initial.layout,
+            .write_stages = initial.stages,
+            .write_access = initial.write ? initial.access : vk::AccessFlags2{},
+          };
+        }
+      }
+
+      // Transients are shared by every frame in flight, so their first use has to wait for the previous frame's
+      // last one. Only the stages (and writes) of the last pass touching each resource are needed for that.
+      std::vector<ResourceState> frame_end(resources_.size());
+      for (i32 p{ 0 }; p < static_cast<i32>(passes_.size()); ++p) {
+        if (passes_[p].culled) {
+          continue;
+        }
+        const auto last_use{ [&](const ResourceID id, const Access access) {
+          if (resources_[id].last_pass != p) {
+            return;
+          }
+          const auto info{ access_info(access) };
+          frame_end[id].write_stages |= info.stages;
+          if (info.write) {
+            frame_end[id].write_access |= info.access;
+          }
+        } };
+        for (const auto& [resource, access]: passes_[p].reads) last_use(resource, access);
+        for (const auto& [resource, access]: passes_[p].writes) last_use(resource, access);
+      }
+
+      // A pass may touch a resource more than once, only its first access picks up the earlier user's state
+      std::vector seeded(resources_.size(), false);
+      barrier_count_ = 0;
+      for (i32 p{ 0 }; p < static_cast<i32>(passes_.size()); ++p) {
+        auto& pass{ passes_[p] };
+        pass.barriers.clear();
+        pass.barrier_resources.clear();
+        if (pass.culled) {
+          continue;
+        }
+
+        const auto transition{ [&](const ResourceID id, const Access access) {
+          auto& resource{ resources_[id] };
+          if (resource.first_pass == p && !std::exchange(seeded[id], true)) {
+            if (resource.alias_predecessor) {
+              // Whatever used this memory before has to be finished before we start scribbling over it
+              const auto& previous{ states[*resource.alias_predecessor] };
+              states[id].write_stages = previous.write_stages | previous.read_stages;
+              states[id].write_access = previous.write_access;
+            } else if (resource.frame_predecessor) {
+              // Contents are discarded, but the previous frame may still be reading or writing this memory
+              states[id].write_stages = frame_end[*resource.frame_predecessor].write_stages;
+              states[id].write_access = frame_end[*resource.frame_predecessor].write_access;
+            }
+          }
+          if (auto barrier{ make_barrier(resource, states[id], access_info(access)) }) {
+            pass.barriers.push_back(*barrier);
+            pass.barrier_resources.push_back(id);
+          }
+        } };
+        for (const auto& [resource, access]: pass.reads) transition(resource, access);
+        for (const auto& [resource, access]: pass.writes) transition(resource, access);
+        barrier_count_ += static_cast<u32>(pass.barriers.size());
+      }
+
+      final_barriers_.clear();
+      final_barrier_resources_.clear();
+      for (ResourceID i{ 0 }; i < resources_.size(); ++i) {
+        const auto& resource{ resources_[i] };
+        if (!resource.imported || resource.final_access == Access::None) {
+          continue;
+        }
+        if (auto barrier{ make_barrier(resource, states[i], access_info(resource.final_access)) }) {
+          final_barriers_.push_back(*barrier);
+          final_barrier_resources_.push_back(i);
+        }
+      }
+      barrier_count_ += static_cast<u32>(final_barriers_.size());
+    }
+
+    [[nodiscard]] static auto make_barrier(
+      const Resource& resource,
+      ResourceState& state,
+      const AccessInfo& next
+    ) -> std::optional<vk::ImageMemoryBarrier2>
+    {
+      const bool layout_change{ state.layout != next.layout && next.layout != vk::ImageLayout::eUndefined };
+
+      vk::ImageMemoryBarrier2 barrier{
+        .srcStageMask = state.write_stages,
+        .srcAccessMask = state.write_access,
+        .dstStageMask = next.stages,
+        .dstAccessMask = next.access,
+        .oldLayout = state.layout,
+        .newLayout = layout_change ? next.layout : state.layout,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .subresourceRange = {
+          .aspectMask = resource.aspect,
+          .baseMipLevel = 0,
+          .levelCount = 1,
+          .baseArrayLayer = 0,
+          .layerCount = 1,
+        },
+      };
+
+      if (!next.write && !layout_change) {
+        // Read after read in the same layout is free, and so is reading something nobody has written yet
+        if (!state.write_stages || (state.read_stages & next.stages) == next.stages) {
+          state.read_stages |= next.stages;
+          return std::nullopt;
+        }
+        state.read_stages |= next.stages;
+        return barrier;
+      }
+
+      // Writes and layout transitions have to wait for earlier readers as well (WAR)
+      barrier.srcStageMask |= state.read_stages;
+      if (next.write) {
+        state.write_stages = next.stages;
+        state.write_access = next.access;
+        state.read_stages = {};
+      } else {
+        // The transition itself acts as the last write for anything reading afterwards
+        state.write_stages = next.stages;
+        state.write_access = {};
+        state.read_stages = next.stages;
+      }
+      state.layout = barrier.newLayout;
+      return barrier;
+    }
+
+    void record_barriers(
+      vk::raii::CommandBuffer& command_buffer,
+      std::vector<vk::ImageMemoryBarrier2>& barriers,
+      const std::vector<ResourceID>& barrier_resources
+    ) const
+    {
+      if (barriers.empty()) {
+        return;
+      }
+      for (u32 i{ 0 }; i < barriers.size(); ++i) {
+        barriers[i].image = resources_[barrier_resources[i]].image;
+      }
+      command_buffer.pipelineBarrier2(vk::DependencyInfo{
+        .imageMemoryBarrierCount = static_cast<u32>(barriers.size()),
+        .pImageMemoryBarriers = barriers.data(),
+      });
+    }
+  };
+
+  //
+  //  PassBuilder
+  //
+
+  RenderGraph::PassBuilder::PassBuilder(RenderGraph& graph, const u32 pass_index):
+    graph_{ graph },
+    pass_index_{ pass_index } {}
+
+  auto RenderGraph::PassBuilder::create_image(const std::string& name, const ImageInfo& info) -> ResourceID
+  {
+    return graph_.p_impl_->create_image(name, info, false);
+  }
+
+  auto RenderGraph::PassBuilder::read(const ResourceID resource, const Access access) -> PassBuilder&
+  {
+    graph_.p_impl_->add_access(pass_index_, resource, access, false);
+    return *this;
+  }
+
+  auto RenderGraph::PassBuilder::write(const ResourceID resource, const Access access) -> PassBuilder&
+  {
+    graph_.p_impl_->add_access(pass_index_, resource, access, true);
+    return *this;
+  }
+
+  auto RenderGraph::PassBuilder::set_side_effects(const bool side_effects) -> PassBuilder&
+  {
+    graph_.p_impl_->set_side_effects(pass_index_, side_effects);
+    return *this;
+  }
+
+  //
+  //  PassContext
+  //
+
+  RenderGraph::PassContext::PassContext(const RenderGraph& graph, vk::raii::CommandBuffer& command_buffer):
+    graph_{ graph },
+    command_buffer_{ command_buffer } {}
+
+  auto RenderGraph::PassContext::command_buffer() -> vk::raii::CommandBuffer&
+  {
+    return command_buffer_;
+  }
+
+  auto RenderGraph::PassContext::extent() const -> vk::Extent2D
+  {
+    return graph_.p_impl_->extent();
+  }
+
+  auto RenderGraph::PassContext::image(const ResourceID resource) const -> vk::Image
+  {
+    return graph_.p_impl_->image(resource);
+  }
+
+  auto RenderGraph::PassContext::image_view(const ResourceID resource) const -> vk::ImageView
+  {
+    return graph_.p_impl_->image_view(resource);
+  }
+
+  //
+  //  RenderGraph
+  //
+
+  RenderGraph::RenderGraph(const shared<ookami::Context>& context):
+    p_impl_{ std::make_unique<Impl>(context) } {}
+
+  RenderGraph::~RenderGraph() = default;
+
+  auto RenderGraph::import_image(
+    const std::string& name,
+    const ImageInfo& info,
+    const Access initial_access,
+    const Access final_access
+  ) -> ResourceID
+  {
+    return p_impl_->import_image(name, info, initial_access, final_access);
+  }
+
+  void RenderGraph::mark_output(const ResourceID resource)
+  {
+    p_impl_->mark_output(resource);
+  }
+
+  auto RenderGraph::add_pass(const std::string& name, const SetupCallback& setup, ExecuteCallback&& execute) -> RenderGraph&
+  {
+    PassBuilder builder{ *this, p_impl_->add_pass(name, std::move(execute)) };
+    setup(builder);
+    return *this;
+  }
+
+  void RenderGraph::bind_image(const ResourceID resource, const vk::Image image, const vk::ImageView image_view)
+  {
+    p_impl_->bind_image(resource, image, image_view);
+  }
+
+  void RenderGraph::execute(vk::raii::CommandBuffer& command_buffer, const vk::Extent2D extent)
+  {
+    PassContext pass_context{ *this, command_buffer };
+    p_impl_->execute(pass_context, command_buffer, extent);
+  }
+
+  void RenderGraph::invalidate()
+  {
+    p_impl_->invalidate();
+  }
+
+  void RenderGraph::set_profiler(const shared<GpuProfiler>& profiler)
+  {
+    p_impl_->set_profiler(profiler);
+  }
+
+  void RenderGraph::collect_stats(std::vector<PassStats>& stats) const
+  {
+    p_impl_->collect_stats(stats);
+  }
+
+  auto RenderGraph::pass_count() const -> u32
+  {
+    return static_cast<u32>(p_impl_->passes_.size());
+  }
+
+  auto RenderGraph::culled_pass_count() const -> u32
+  {
+    return p_impl_->culled_pass_count_;
+  }
+
+  auto RenderGraph::barrier_count() const -> u32
+  {
+    return p_impl_->barrier_count_;
+  }
+
+  auto RenderGraph::transient_memory_size() const -> u64
+  {
+    return p_impl_->transient_memory_size_;
+  }
+
+  auto RenderGraph::transient_memory_size_unaliased() const -> u64
+  {
+    return p_impl_->transient_memory_size_unaliased_;
+  }
+}
@@ -0,0 +1,129 @@
+//
+// Frame graph for Ookami. Passes declare the images they read and write up front, and the graph
+// works out the rest: which passes are actually needed, where barriers/layout transitions go, and
+// which transient attachments can share the same memory.
+//
+// Sources:
+// https://www.gdcvault.com/play/1024612/FrameGraph-Extensible-Rendering-Architecture-in
+// https://themaister.net/blog/2017/08/15/render-graphs-and-vulkan-a-deep-dive/
+//
+
+#pragma once
+
+namespace vk {
+  enum class Format;
+  class Extent2D;
+  class Image;
+  class ImageView;
+
+  namespace raii {
+    class CommandBuffer;
+  }
+}
+
+namespace fx {
+  struct PassStats;
+  class GpuProfiler;
+
+  namespace ookami {
+    class Context;
+  }
+
+  class RenderGraph {
+  public:
+    using ResourceID = u32;
+
+    enum class Access: u32 {
+      None,
+      ColorAttachmentWrite,
+      ColorAttachmentRead,
+      DepthAttachmentWrite,
+      DepthAttachmentRead,
+      FragmentShaderRead,
+      ComputeShaderRead,
+      ComputeShaderWrite,
+      TransferRead,
+      TransferWrite,
+      SwapchainAcquire,
+      Present,
+    };
+
+    struct ImageInfo {
+      vk::Format format{};
+      // Zero means "match the extent the graph is compiled for" (usually the backbuffer)
+      u32 width{ 0 };
+      u32 height{ 0 };
+    };
+
+    class PassBuilder {
+    public:
+      auto create_image(const std::string& name, const ImageInfo& info) -> ResourceID;
+      auto read(ResourceID resource, Access access) -> PassBuilder&;
+      auto write(ResourceID resource, Access access) -> PassBuilder&;
+      // Passes with side effects (readbacks, queries, etc.) are never culled
+      auto set_side_effects(bool side_effects = true) -> PassBuilder&;
+
+    private:
+      friend class RenderGraph;
+      PassBuilder(RenderGraph& graph, u32 pass_index);
+
+      RenderGraph& graph_;
+      u32 pass_index_;
+    };
+
+    class PassContext {
+    public:
+      [[nodiscard]] auto command_buffer() -> vk::raii::CommandBuffer&;
+      [[nodiscard]] auto extent() const -> vk::Extent2D;
+      [[nodiscard]] auto image(ResourceID resource) const -> vk::Image;
+      [[nodiscard]] auto image_view(ResourceID resource) const -> vk::ImageView;
+
+    private:
+      friend class RenderGraph;
+      PassContext(const RenderGraph& graph, vk::raii::CommandBuffer& command_buffer);
+
+      const RenderGraph& graph_;
+      vk::raii::CommandBuffer& command_buffer_;
+    };
+
+    using SetupCallback = std::function<void(PassBuilder&)>;
+    using ExecuteCallback = std::function<void(PassContext&)>;
+
+    explicit RenderGraph(const shared<ookami::Context>& context);
+    ~RenderGraph();
+
+    // Images owned outside the graph (swapchain images, readback targets). The graph transitions them
+    // out of initial_access on first use and into final_access after the last pass that touches them.
+    auto import_image(
+      const std::string& name,
+      const ImageInfo& info,
+      Access initial_access = Access::None,
+      Access final_access = Access::None
+    ) -> ResourceID;
+    // Marks a resource as a graph output so the passes producing it survive culling
+    void mark_output(ResourceID resource);
+    auto add_pass(const std::string& name, const SetupCallback& setup, ExecuteCallback&& execute) -> RenderGraph&;
+
+    // Imported images may change every frame (e.g. the acquired swapchain image)
+    void bind_image(ResourceID resource, vk::Image image, vk::ImageView image_view);
+
+    // Compiles the graph if it has changed or the extent differs from the cached build, then records every
+    // surviving pass along with its barriers into the command buffer.
+    void execute(vk::raii::CommandBuffer& command_buffer, vk::Extent2D extent);
+    void invalidate();
+    // Wraps every surviving pass in a GPU profiler scope named after the pass
+    void set_profiler(const shared<GpuProfiler>& profiler);
+    // Fills stats with every surviving pass and the CPU time it took to record during the last execute
+    void collect_stats(std::vector<PassStats>& stats) const;
+
+    [[nodiscard]] auto pass_count() const -> u32;
+    [[nodiscard]] auto culled_pass_count() const -> u32;
+    [[nodiscard]] auto barrier_count() const -> u32;
+    [[nodiscard]] auto transient_memory_size() const -> u64;
+    [[nodiscard]] auto transient_memory_size_unaliased() const -> u64;
+
+  private:
+    class Impl;
+    unique<Impl> p_impl_;
+  };
+}
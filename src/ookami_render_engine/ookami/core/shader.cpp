@@ -5,13 +5,16 @@
 #include "shader.hpp"
 
 #include "vulkan/static.hpp"
+#include <kitsune/profiler.hpp>
 
 namespace fx {
   class Shader::Impl {
   public:
     Impl(const vk::raii::Device& device, const ShaderCreateInfo& shader_create_info):
-      name_{ shader_create_info.shader_directory.stem().string() }
+      name_{ shader_create_info.shader_directory.stem().string() },
+      read_source_{ shader_create_info.read_source }
     {
+      FOXY_PROFILE_SCOPE("Shader compile");
       Log::info("Please wait while shader[\"{}\"] loads...", name_);
       const auto sw{ Stopwatch() };
       
@@ -53,6 +56,7 @@ namespace fx {
     static constexpr inline word spirv_magic_number_{ 0x07230203 };
     
     std::string name_;
+    ShaderSourceReader read_source_;
     std::unordered_map<Stage, std::vector<word>> bytecode_;
     std::unordered_map<Stage, vk::raii::ShaderModule> shader_modules_;
     
@@ -66,10 +70,12 @@ namespace fx {
         fs::path{ "tmp" } / fs::path{ "shader_cache" } / relative(create_info.shader_directory, {"res/foxy/shaders"}).parent_path() / create_info.shader_directory.stem()
       };
       
-      if (!exists(create_info.shader_directory)) {
+      // Sources coming through a reader (a packed archive) have no directory on disk to check
+      const bool from_disk{ !read_source_ };
+      if (from_disk && !exists(create_info.shader_directory)) {
         Log::error("Directory {} does not exist", create_info.shader_directory.string());
       } else {
-        if (is_directory(create_info.shader_directory)) {
+        if (!from_disk || is_directory(create_info.shader_directory)) {
           Log::trace("Fetching shader from dir: {}", name_);
           
           for (const auto& stage: stages) {
@@ -127,7 +133,7 @@ namespace fx {
       const Stage stage
     ) -> std::optional<std::vector<u32>>
     {
-      if (const auto result{ io::read_file(in_file) }) {
+      if (const auto result{ read_source_ ? read_source_(in_file) : io::read_file(in_file) }) {
         auto code_str{ (*result).c_str() };
         
         Log::trace("Compiling {}: {}...", *stage.to_string(), name_);
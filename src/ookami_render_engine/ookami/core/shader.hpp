@@ -10,12 +10,17 @@ namespace vk::raii {
 }
 
 namespace fx {
+  // Returns a shader source file's text, or nothing if it isn't there
+  using ShaderSourceReader = std::function<std::optional<std::string>(const std::filesystem::path&)>;
+  
   struct ShaderCreateInfo {
     bool vertex{ false };
     bool fragment{ false };
     bool compute{ false };
     bool geometry{ false };
     std::filesystem::path shader_directory;
+    // Reads the HLSL straight off the disk when empty. Set it to load shaders out of a packed archive instead.
+    ShaderSourceReader read_source{};
     bool disable_optimizations{
       #if defined(FOXY_DEBUG_MODE) and not(defined(FOXY_RELEASE_MODE))
       true
@@ -3,34 +3,18 @@
 #include "context.hpp"
 
 #include "vulkan/static.hpp"
-#include <GLFW/glfw3.h>
 
 namespace fx {
   class Swapchain::Impl {
   public:
-    explicit Impl(const shared<ookami::Context>& context):
-      window_{ context->window() },
+    Impl(const shared<ookami::Context>& context, FramebufferSize&& framebuffer_size):
+      framebuffer_size_{ std::move(framebuffer_size) },
       context_{ context },
       swapchain_image_format_{ vk::Format::eB8G8R8A8Unorm },
       swapchain_{ create_swapchain() },
       swap_images_{ swapchain_.getImages() },
-      swap_image_views_{ create_image_views() },
-      render_pass_{ create_render_pass() }
+      swap_image_views_{ create_image_views() }
     {
-      for (const auto& image_view: swap_image_views_) {
-        framebuffers_.emplace_back(
-          context_->logical_device(),
-          vk::FramebufferCreateInfo{
-            .renderPass = **render_pass_,
-            .attachmentCount = 1,
-            .pAttachments = &*image_view,
-            .width = swapchain_extent_.width,
-            .height = swapchain_extent_.height,
-            .layers = 1,
-          }
-        );
-      }
-      
       Log::trace("Created Vulkan swapchain.");
     }
 
@@ -46,39 +30,22 @@ namespace fx {
       Log::trace("Rebuilding Vulkan swapchain...");
       dirty_ = true;
       
-      ivec2 size{};
-      glfwGetFramebufferSize(window_.get(), &size.x, &size.y);
-      if (size.x == 0 || size.y == 0) {
+      // Asked of the surface rather than GLFW, whose framebuffer size query is main thread only
+      if (const auto extent{ context_->query_swapchain_support().capabilities.currentExtent };
+          extent.width == 0 || extent.height == 0) {
         return;
       }
       
       context_->logical_device().waitIdle();
       
       // Reset
-      swapchain_.clear();
-      swap_images_.clear();
       swap_image_views_.clear();
-      render_pass_->clear();
-      framebuffers_.clear();
+      swap_images_.clear();
   
-      // Rebuild
-      swapchain_ = create_swapchain();
+      // Rebuild (handing the old swapchain over lets the driver recycle its resources)
+      swapchain_ = create_swapchain(*swapchain_);
       swap_images_ = swapchain_.getImages();
       swap_image_views_ = create_image_views();
-      render_pass_ = create_render_pass();
-      for (const auto& image_view: swap_image_views_) {
-        framebuffers_.emplace_back(
-          context_->logical_device(),
-          vk::FramebufferCreateInfo{
-            .renderPass = **render_pass_,
-            .attachmentCount = 1,
-            .pAttachments = &*image_view,
-            .width = swapchain_extent_.width,
-            .height = swapchain_extent_.height,
-            .layers = 1,
-          }
-        );
-      }
     
       Log::trace("Rebuilt Vulkan swapchain.");
       dirty_ = false;
@@ -111,20 +78,14 @@ namespace fx {
       return swapchain_extent_;
     }
 
+    [[nodiscard]] auto image(const u32 index) const -> vk::Image {
+      return vk::Image{ swap_images_.at(index) };
+    }
+
     [[nodiscard]] auto image_views() -> std::vector<vk::raii::ImageView>& {
       return swap_image_views_;
     }
   
-    [[nodiscard]] auto render_pass() const -> const shared<vk::raii::RenderPass>&
-    {
-      return render_pass_;
-    }
-  
-    [[nodiscard]] auto framebuffers() -> std::vector<vk::raii::Framebuffer>&
-    {
-      return framebuffers_;
-    }
-  
     auto operator*() -> vk::raii::SwapchainKHR&
     {
       return swapchain_;
@@ -133,7 +94,7 @@ namespace fx {
   private:
     bool dirty_{ false };
     
-    shared<GLFWwindow> window_;
+    FramebufferSize framebuffer_size_;
     shared<ookami::Context> context_;
 
     vk::Format swapchain_image_format_;
@@ -142,9 +103,6 @@ namespace fx {
 
     std::vector<VkImage> swap_images_;
     std::vector<vk::raii::ImageView> swap_image_views_;
-    
-    shared<vk::raii::RenderPass> render_pass_;
-    std::vector<vk::raii::Framebuffer> framebuffers_;
 
     [[nodiscard]] auto pick_swap_surface_format(const std::vector<vk::SurfaceFormatKHR>& formats) const -> vk::SurfaceFormatKHR {
       for (auto& format: formats) {
@@ -176,9 +134,8 @@ namespace fx {
         return capabilities.currentExtent;
       }
 
-      ivec2 size{};
-      glfwGetFramebufferSize(window_.get(), &size.x, &size.y);
-
+      // The surface leaves the size up to us (Wayland), this runs on the render thread so GLFW can't be asked
+      const auto size{ framebuffer_size_() };
       const vk::Extent2D true_extent{
         std::clamp(static_cast<u32>(size.x), capabilities.minImageExtent.width, capabilities.maxImageExtent.width),
         std::clamp(static_cast<u32>(size.y), capabilities.minImageExtent.height, capabilities.maxImageExtent.height),
@@ -187,7 +144,7 @@ namespace fx {
       return true_extent;
     }
 
-    [[nodiscard]] auto create_swapchain() -> vk::raii::SwapchainKHR {
+    [[nodiscard]] auto create_swapchain(const vk::SwapchainKHR old_swapchain = {}) -> vk::raii::SwapchainKHR {
       auto [capabilities, formats, present_modes]{ context_->query_swapchain_support() };
       SwapchainInfo swapchain_info{
         .format = pick_swap_surface_format(formats),
@@ -220,7 +177,7 @@ namespace fx {
         .compositeAlpha = vk::CompositeAlphaFlagBitsKHR::eOpaque,
         .presentMode = swapchain_info.present_mode,
         .clipped = true,
-        .oldSwapchain = nullptr,
+        .oldSwapchain = old_swapchain,
       };
 
       if (graphics != present) {
@@ -270,64 +227,15 @@ namespace fx {
       );
       return image_views;
     }
-  
-    [[nodiscard]] auto create_render_pass() const -> unique<vk::raii::RenderPass> {
-      vk::AttachmentDescription color_attachment{
-        .format = swapchain_image_format_,
-        .samples = vk::SampleCountFlagBits::e1,
-        .loadOp = vk::AttachmentLoadOp::eClear,
-        .storeOp = vk::AttachmentStoreOp::eStore,
-        .stencilLoadOp = vk::AttachmentLoadOp::eDontCare,
-        .stencilStoreOp = vk::AttachmentStoreOp::eDontCare,
-        .initialLayout = vk::ImageLayout::eUndefined,
-        .finalLayout = vk::ImageLayout::ePresentSrcKHR,
-      };
-    
-      vk::AttachmentReference color_attachment_ref{
-        .attachment = 0,
-        .layout = vk::ImageLayout::eColorAttachmentOptimal,
-      };
-    
-      vk::SubpassDescription subpass{
-        .pipelineBindPoint = vk::PipelineBindPoint::eGraphics,
-        .colorAttachmentCount = 1,
-        .pColorAttachments = &color_attachment_ref,
-      };
-    
-      vk::SubpassDependency dependency{
-        .srcSubpass = VK_SUBPASS_EXTERNAL,
-        .dstSubpass = 0,
-        .srcStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput,
-        .dstStageMask = vk::PipelineStageFlagBits::eColorAttachmentOutput,
-        .srcAccessMask = vk::AccessFlagBits::eNone,
-        .dstAccessMask = vk::AccessFlagBits::eColorAttachmentWrite,
-      };
-    
-      try {
-        return std::make_unique<vk::raii::RenderPass>(
-          context_->logical_device(),
-          vk::RenderPassCreateInfo{
-            .attachmentCount = 1,
-            .pAttachments = &color_attachment,
-            .subpassCount = 1,
-            .pSubpasses = &subpass,
-            .dependencyCount = 1,
-            .pDependencies = &dependency,
-          }
-        );
-      } catch (const std::exception& e) {
-        Log::fatal("Failed to create render pass: {}", e.what());
-        return nullptr;
-      }
-    }
+
   };
 
   //
   //  Swapchain
   //
 
-  Swapchain::Swapchain(const shared<ookami::Context>& context)
-    : p_impl_{std::make_unique<Impl>(context)} {}
+  Swapchain::Swapchain(const shared<ookami::Context>& context, FramebufferSize&& framebuffer_size)
+    : p_impl_{std::make_unique<Impl>(context, std::move(framebuffer_size))} {}
 
   Swapchain::~Swapchain() = default;
   
@@ -354,20 +262,14 @@ namespace fx {
     return p_impl_->extent();
   }
 
+  auto Swapchain::image(const u32 index) const -> vk::Image {
+    return p_impl_->image(index);
+  }
+
   auto Swapchain::image_views() const -> std::vector<vk::raii::ImageView>& {
     return p_impl_->image_views();
   }
   
-  auto Swapchain::render_pass() const -> const shared<vk::raii::RenderPass>&
-  {
-    return p_impl_->render_pass();
-  }
-  
-  auto Swapchain::framebuffers() -> std::vector<vk::raii::Framebuffer>&
-  {
-    return p_impl_->framebuffers();
-  }
-  
   auto Swapchain::operator*() -> vk::raii::SwapchainKHR&
   {
     return **p_impl_;
@@ -5,12 +5,11 @@ class GLFWwindow;
 namespace vk {
   enum class Format;
   class Extent2D;
+  class Image;
 
   namespace raii {
     class ImageView;
     class SwapchainKHR;
-    class RenderPass;
-    class Framebuffer;
     class Semaphore;
   }
 }
@@ -22,7 +21,10 @@ namespace fx {
 
   class Swapchain {
   public:
-    explicit Swapchain(const fx::shared<ookami::Context>& context);
+    // Any thread: the framebuffer size in pixels, for surfaces that leave the swapchain extent up to us
+    using FramebufferSize = std::function<ivec2()>;
+
+    Swapchain(const fx::shared<ookami::Context>& context, FramebufferSize&& framebuffer_size);
     ~Swapchain();
   
     [[nodiscard]] auto dirty() const -> bool;
@@ -32,9 +34,8 @@ namespace fx {
     [[nodiscard]] auto context() const -> const shared<ookami::Context>&;
     [[nodiscard]] auto format() const -> vk::Format;
     [[nodiscard]] auto extent() const -> vk::Extent2D;
+    [[nodiscard]] auto image(u32 index) const -> vk::Image;
     [[nodiscard]] auto image_views() const -> std::vector<vk::raii::ImageView>&;
-    [[nodiscard]] auto render_pass() const -> const shared<vk::raii::RenderPass>&;
-    [[nodiscard]] auto framebuffers() -> std::vector<vk::raii::Framebuffer>&;
   
     auto operator*() -> vk::raii::SwapchainKHR&;
     
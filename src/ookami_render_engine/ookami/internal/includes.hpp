@@ -24,6 +24,10 @@
 // Utilities
 #include <compare>
 #include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <charconv>
+#include <bit>
 #include <algorithm>
 #include <numeric>
 #include <utility>
@@ -39,6 +43,8 @@
 #include <typeinfo>
 #include <format>
 #include <string_view>
+#include <span>
+#include <optional>
 // Threading
 #include <thread>
 #include <mutex>
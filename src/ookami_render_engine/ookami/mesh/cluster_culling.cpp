@@ -0,0 +1,106 @@
+#include "cluster_culling.hpp"
+
+namespace fx {
+  namespace {
+    [[nodiscard]] auto row(const mat4& matrix, const i32 index) -> vec4
+    {
+      return vec4{ matrix[0][index], matrix[1][index], matrix[2][index], matrix[3][index] };
+    }
+
+    [[nodiscard]] auto add(const vec4& a, const vec4& b) -> vec4
+    {
+      return vec4{ a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w };
+    }
+
+    [[nodiscard]] auto subtract(const vec4& a, const vec4& b) -> vec4
+    {
+      return vec4{ a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w };
+    }
+  }
+
+  auto ClusterCullInfo::from_camera(const mat4& view, const mat4& projection, const mat4& transform) -> ClusterCullInfo
+  {
+    // Gribb-Hartmann: a point is inside when -w <= x, y <= w and 0 <= z <= w in clip space, each inequality is
+    // a plane made of rows of the object to clip matrix
+    const auto object_to_clip{ projection * view * transform };
+    const auto x{ row(object_to_clip, 0) };
+    const auto y{ row(object_to_clip, 1) };
+    const auto z{ row(object_to_clip, 2) };
+    const auto w{ row(object_to_clip, 3) };
+    const auto eye{ glm::inverse(view * transform) * vec4{ 0.f, 0.f, 0.f, 1.f } };
+    return ClusterCullInfo{
+      .frustum_planes = { add(w, x), subtract(w, x), add(w, y), subtract(w, y), z, subtract(w, z) },
+      .eye = vec3{ eye.x / eye.w, eye.y / eye.w, eye.z / eye.w },
+    };
+  }
+
+  auto ClusterCullStats::operator+=(const ClusterCullStats& other) -> ClusterCullStats&
+  {
+    visible += other.visible;
+    frustum_culled += other.frustum_culled;
+    backface_culled += other.backface_culled;
+    return *this;
+  }
+
+  auto meshlet_outside_frustum(const MeshletBounds& bounds, const ClusterCullInfo& info) -> bool
+  {
+    const auto& c{ bounds.center };
+    for (const auto& plane: info.frustum_planes) {
+      const auto distance{ plane.x * c[0] + plane.y * c[1] + plane.z * c[2] + plane.w };
+      // Unnormalized planes scale the distance, so scale the radius to match instead of normalizing
+      if (distance < -bounds.radius * std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  auto meshlet_backfacing(const MeshletBounds& bounds, const ClusterCullInfo& info) -> bool
+  {
+    const auto& apex{ bounds.cone_apex };
+    const auto& axis{ bounds.cone_axis };
+    const std::array view{ apex[0] - info.eye.x, apex[1] - info.eye.y, apex[2] - info.eye.z };
+    const auto distance{ std::sqrt(view[0] * view[0] + view[1] * view[1] + view[2] * view[2]) };
+    // dot(normalize(view), axis) >= cutoff, without the divide
+    return distance > 0.f && view[0] * axis[0] + view[1] * axis[1] + view[2] * axis[2] >= bounds.cone_cutoff * distance;
+  }
+
+  auto cull_meshlets(
+    const std::span<const Meshlet> meshlets,
+    const std::span<const MeshletBounds> bounds,
+    const ClusterCullInfo& info,
+    const u32 first_index,
+    const u32 instance,
+    std::vector<DrawIndexedIndirectCommand>& draws
+  ) -> ClusterCullStats
+  {
+    ClusterCullStats stats;
+    const auto first_new_draw{ draws.size() };
+    for (std::size_t i{ 0 }; i < meshlets.size(); ++i) {
+      if (info.frustum_culling && meshlet_outside_frustum(bounds[i], info)) {
+        ++stats.frustum_culled;
+        continue;
+      }
+      if (info.backface_culling && meshlet_backfacing(bounds[i], info)) {
+        ++stats.backface_culled;
+        continue;
+      }
+      ++stats.visible;
+
+      const auto& meshlet{ meshlets[i] };
+      const auto start{ first_index + meshlet.triangle_offset * 3 };
+      if (draws.size() > first_new_draw && draws.back().first_index + draws.back().index_count == start) {
+        draws.back().index_count += meshlet.triangle_count * 3;
+        continue;
+      }
+      draws.push_back(DrawIndexedIndirectCommand{
+        .index_count = meshlet.triangle_count * 3,
+        .instance_count = 1,
+        .first_index = start,
+        .vertex_offset = 0,
+        .first_instance = instance,
+      });
+    }
+    return stats;
+  }
+}
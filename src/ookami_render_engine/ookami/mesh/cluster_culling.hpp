@@ -0,0 +1,63 @@
+//
+// Per meshlet culling ahead of indirect draws: clusters whose bounding sphere is outside the view frustum or
+// whose normal cone faces away from the camera are dropped, and the rest become draw commands. The compute
+// shader in res/foxy/shaders/meshlet_cull runs the same tests on the GPU over the same buffer layouts.
+//
+// Everything is tested in the mesh's object space. Planes and the eye are moved there rather than the bounds
+// moved out, which keeps both tests exact under any affine transform, non-uniform scale and shear included.
+//
+// Sources:
+// https://www.gamedevs.org/uploads/fast-extraction-viewing-frustum-planes-from-world-view-projection-matrix.pdf
+// https://advances.realtimerendering.com/s2015/aaltonenhaar_siggraph2015_combined_final_footer_220dpi.pdf
+//
+
+#pragma once
+
+#include "meshlet.hpp"
+
+namespace fx {
+  // Matches VkDrawIndexedIndirectCommand
+  struct DrawIndexedIndirectCommand {
+    u32 index_count;
+    u32 instance_count;
+    u32 first_index;
+    i32 vertex_offset;
+    u32 first_instance;
+  };
+
+  static_assert(sizeof(DrawIndexedIndirectCommand) == 20, "Consumed by vkCmdDrawIndexedIndirect");
+
+  struct ClusterCullInfo {
+    // Object space (a, b, c, d) with normals facing into the frustum, any length: left, right, bottom, top, near, far
+    std::array<vec4, 6> frustum_planes{};
+    // Object space
+    vec3 eye{ 0.f, 0.f, 0.f };
+    bool frustum_culling{ true };
+    bool backface_culling{ true };
+
+    // From the camera and an instance's object to world transform. Expects Vulkan's 0 to 1 clip depth.
+    [[nodiscard]] static auto from_camera(const mat4& view, const mat4& projection, const mat4& transform) -> ClusterCullInfo;
+  };
+
+  struct ClusterCullStats {
+    u32 visible{ 0 };
+    u32 frustum_culled{ 0 };
+    u32 backface_culled{ 0 };
+
+    auto operator+=(const ClusterCullStats& other) -> ClusterCullStats&;
+  };
+
+  [[nodiscard]] auto meshlet_outside_frustum(const MeshletBounds& bounds, const ClusterCullInfo& info) -> bool;
+  [[nodiscard]] auto meshlet_backfacing(const MeshletBounds& bounds, const ClusterCullInfo& info) -> bool;
+
+  // Appends a draw for each surviving meshlet of one instance, indexing the buffer meshlet_index_buffer() built
+  // (placed at first_index). Survivors whose index ranges touch are merged into one draw.
+  auto cull_meshlets(
+    std::span<const Meshlet> meshlets,
+    std::span<const MeshletBounds> bounds,
+    const ClusterCullInfo& info,
+    u32 first_index,
+    u32 instance,
+    std::vector<DrawIndexedIndirectCommand>& draws
+  ) -> ClusterCullStats;
+}
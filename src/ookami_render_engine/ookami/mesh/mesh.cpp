@@ -0,0 +1,466 @@
+#include "mesh.hpp"
+
+namespace fx {
+  namespace {
+    [[nodiscard]] auto sign_not_zero(const float value) -> float
+    {
+      return value >= 0.f ? 1.f : -1.f;
+    }
+
+    [[nodiscard]] auto to_snorm16(const float value) -> u16
+    {
+      return static_cast<u16>(static_cast<i16>(std::round(std::clamp(value, -1.f, 1.f) * 32767.f)));
+    }
+
+    [[nodiscard]] auto from_snorm16(const u16 value) -> float
+    {
+      return std::max(static_cast<float>(static_cast<i16>(value)) / 32767.f, -1.f);
+    }
+
+    [[nodiscard]] auto to_unorm8(const float value) -> u32
+    {
+      return static_cast<u32>(std::round(std::clamp(value, 0.f, 1.f) * 255.f));
+    }
+
+    [[nodiscard]] auto align_up(const u64 offset) -> u64
+    {
+      return (offset + mesh_format::block_alignment - 1) & ~static_cast<u64>(mesh_format::block_alignment - 1);
+    }
+  }
+
+  namespace mesh_format {
+    auto pack_normal(const vec3& normal) -> u32
+    {
+      const auto length{ std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z) };
+      if (length == 0.f) {
+        return 0;
+      }
+      // Project onto the octahedron, then fold the lower half over the upper one
+      auto x{ normal.x / length };
+      auto y{ normal.y / length };
+      if (normal.z < 0.f) {
+        const auto folded_x{ (1.f - std::abs(y)) * sign_not_zero(x) };
+        const auto folded_y{ (1.f - std::abs(x)) * sign_not_zero(y) };
+        x = folded_x;
+        y = folded_y;
+      }
+      return static_cast<u32>(to_snorm16(x)) | static_cast<u32>(to_snorm16(y)) << 16;
+    }
+
+    auto unpack_normal(const u32 packed) -> vec3
+    {
+      auto x{ from_snorm16(static_cast<u16>(packed & 0xFFFF)) };
+      auto y{ from_snorm16(static_cast<u16>(packed >> 16)) };
+      const auto z{ 1.f - std::abs(x) - std::abs(y) };
+      const auto t{ std::clamp(-z, 0.f, 1.f) };
+      x += x >= 0.f ? -t : t;
+      y += y >= 0.f ? -t : t;
+      const auto length{ std::sqrt(x * x + y * y + z * z) };
+      return vec3{ x / length, y / length, z / length };
+    }
+
+    auto pack_color(const vec4& color) -> u32
+    {
+      return to_unorm8(color.x) | to_unorm8(color.y) << 8 | to_unorm8(color.z) << 16 | to_unorm8(color.w) << 24;
+    }
+
+    auto unpack_color(const u32 packed) -> vec4
+    {
+      return vec4{
+        static_cast<float>(packed & 0xFF) / 255.f,
+        static_cast<float>(packed >> 8 & 0xFF) / 255.f,
+        static_cast<float>(packed >> 16 & 0xFF) / 255.f,
+        static_cast<float>(packed >> 24) / 255.f,
+      };
+    }
+  }
+
+  //
+  //  MeshView
+  //
+
+  MeshView::MeshView(const std::span<const std::byte> bytes):
+    bytes_{ bytes } {}
+
+  auto MeshView::parse(const std::span<const std::byte> bytes) -> std::optional<MeshView>
+  {
+    using namespace mesh_format;
+    if (bytes.size() < sizeof(Header) || reinterpret_cast<std::uintptr_t>(bytes.data()) % block_alignment != 0) {
+      return std::nullopt;
+    }
+    const auto& header{ *reinterpret_cast<const Header*>(bytes.data()) };
+    if (header.magic != magic || header.version != version) {
+      return std::nullopt;
+    }
+    if (header.index_size != 2 && header.index_size != 4) {
+      return std::nullopt;
+    }
+
+    const auto fits{ [&bytes](const u64 offset, const u64 size) {
+      return offset % block_alignment == 0 && offset <= bytes.size() && size <= bytes.size() - offset;
+    } };
+    if (!fits(header.vertex_offset, static_cast<u64>(header.vertex_count) * sizeof(PackedVertex)) ||
+        !fits(header.index_offset, static_cast<u64>(header.index_count) * header.index_size) ||
+        !fits(header.lod_offset, static_cast<u64>(header.lod_count) * sizeof(Lod)) ||
+        !fits(header.meshlet_offset, static_cast<u64>(header.meshlet_count) * sizeof(Meshlet)) ||
+        !fits(header.meshlet_bounds_offset, static_cast<u64>(header.meshlet_count) * sizeof(MeshletBounds)) ||
+        !fits(header.meshlet_vertices_offset, static_cast<u64>(header.meshlet_vertex_count) * sizeof(u32)) ||
+        !fits(header.meshlet_triangles_offset, static_cast<u64>(header.meshlet_triangle_count) * 3) ||
+        header.lod_count == 0) {
+      return std::nullopt;
+    }
+
+    // Checked once here so nothing downstream (or on the GPU) can index out of bounds
+    const MeshView view{ bytes };
+    for (u32 i{ 0 }; i < header.index_count; ++i) {
+      if (view.index(i) >= header.vertex_count) {
+        return std::nullopt;
+      }
+    }
+    for (u32 level{ 0 }; level < header.lod_count; ++level) {
+      const auto lod{ view.lod(level) };
+      if (lod.index_offset > header.index_count || lod.index_count > header.index_count - lod.index_offset) {
+        return std::nullopt;
+      }
+    }
+    if (std::ranges::any_of(view.meshlet_vertices(), [&header](const u32 vertex) { return vertex >= header.vertex_count; })) {
+      return std::nullopt;
+    }
+    const auto triangles{ view.meshlet_triangles() };
+    for (const auto& meshlet: view.meshlets()) {
+      if (meshlet.vertex_offset > header.meshlet_vertex_count ||
+          meshlet.vertex_count > header.meshlet_vertex_count - meshlet.vertex_offset ||
+          meshlet.triangle_offset > header.meshlet_triangle_count ||
+          meshlet.triangle_count > header.meshlet_triangle_count - meshlet.triangle_offset) {
+        return std::nullopt;
+      }
+      const auto local{ triangles.subspan(static_cast<std::size_t>(meshlet.triangle_offset) * 3, static_cast<std::size_t>(meshlet.triangle_count) * 3) };
+      if (std::ranges::any_of(local, [&meshlet](const u8 index) { return index >= meshlet.vertex_count; })) {
+        return std::nullopt;
+      }
+    }
+    return view;
+  }
+
+  auto MeshView::header() const -> const mesh_format::Header&
+  {
+    return *reinterpret_cast<const mesh_format::Header*>(bytes_.data());
+  }
+
+  auto MeshView::vertex_count() const -> u32
+  {
+    return header().vertex_count;
+  }
+
+  auto MeshView::index_count() const -> u32
+  {
+    return header().index_count;
+  }
+
+  auto MeshView::has_normals() const -> bool
+  {
+    return (header().flags & mesh_format::HasNormals) != 0;
+  }
+
+  auto MeshView::has_colors() const -> bool
+  {
+    return (header().flags & mesh_format::HasColors) != 0;
+  }
+
+  auto MeshView::lod_count() const -> u32
+  {
+    return header().lod_count;
+  }
+
+  auto MeshView::lod(const u32 level) const -> MeshLod
+  {
+    mesh_format::Lod lod;
+    std::memcpy(&lod, bytes_.data() + header().lod_offset + static_cast<std::size_t>(level) * sizeof(lod), sizeof(lod));
+    return MeshLod{ .index_offset = lod.index_offset, .index_count = lod.index_count, .error = lod.error };
+  }
+
+  auto MeshView::vertices() const -> std::span<const PackedVertex>
+  {
+    return {
+      reinterpret_cast<const PackedVertex*>(bytes_.data() + header().vertex_offset),
+      header().vertex_count
+    };
+  }
+
+  auto MeshView::indices16() const -> std::span<const u16>
+  {
+    if (header().index_size != 2) {
+      return {};
+    }
+    return { reinterpret_cast<const u16*>(bytes_.data() + header().index_offset), header().index_count };
+  }
+
+  auto MeshView::indices32() const -> std::span<const u32>
+  {
+    if (header().index_size != 4) {
+      return {};
+    }
+    return { reinterpret_cast<const u32*>(bytes_.data() + header().index_offset), header().index_count };
+  }
+
+  auto MeshView::vertex_bytes() const -> std::span<const std::byte>
+  {
+    return std::as_bytes(vertices());
+  }
+
+  auto MeshView::index_bytes() const -> std::span<const std::byte>
+  {
+    return bytes_.subspan(
+      static_cast<std::size_t>(header().index_offset),
+      static_cast<std::size_t>(header().index_count) * header().index_size
+    );
+  }
+
+  auto MeshView::meshlets() const -> std::span<const Meshlet>
+  {
+    return { reinterpret_cast<const Meshlet*>(bytes_.data() + header().meshlet_offset), header().meshlet_count };
+  }
+
+  auto MeshView::meshlet_bounds() const -> std::span<const MeshletBounds>
+  {
+    return { reinterpret_cast<const MeshletBounds*>(bytes_.data() + header().meshlet_bounds_offset), header().meshlet_count };
+  }
+
+  auto MeshView::meshlet_vertices() const -> std::span<const u32>
+  {
+    return { reinterpret_cast<const u32*>(bytes_.data() + header().meshlet_vertices_offset), header().meshlet_vertex_count };
+  }
+
+  auto MeshView::meshlet_triangles() const -> std::span<const u8>
+  {
+    return {
+      reinterpret_cast<const u8*>(bytes_.data() + header().meshlet_triangles_offset),
+      static_cast<std::size_t>(header().meshlet_triangle_count) * 3
+    };
+  }
+
+  auto MeshView::dequantize_scale() const -> vec3
+  {
+    const auto& h{ header() };
+    return vec3{
+      (h.bounds_max[0] - h.bounds_min[0]) / 65535.f,
+      (h.bounds_max[1] - h.bounds_min[1]) / 65535.f,
+      (h.bounds_max[2] - h.bounds_min[2]) / 65535.f,
+    };
+  }
+
+  auto MeshView::dequantize_offset() const -> vec3
+  {
+    const auto& h{ header() };
+    return vec3{ h.bounds_min[0], h.bounds_min[1], h.bounds_min[2] };
+  }
+
+  auto MeshView::position(const u32 vertex) const -> vec3
+  {
+    const auto& q{ vertices()[vertex].position };
+    const auto scale{ dequantize_scale() };
+    const auto offset{ dequantize_offset() };
+    return vec3{
+      static_cast<float>(q[0]) * scale.x + offset.x,
+      static_cast<float>(q[1]) * scale.y + offset.y,
+      static_cast<float>(q[2]) * scale.z + offset.z,
+    };
+  }
+
+  auto MeshView::normal(const u32 vertex) const -> vec3
+  {
+    return mesh_format::unpack_normal(vertices()[vertex].normal);
+  }
+
+  auto MeshView::color(const u32 vertex) const -> vec4
+  {
+    return mesh_format::unpack_color(vertices()[vertex].color);
+  }
+
+  auto MeshView::index(const u32 i) const -> u32
+  {
+    const auto* data{ bytes_.data() + header().index_offset };
+    if (header().index_size == 2) {
+      u16 value;
+      std::memcpy(&value, data + static_cast<std::size_t>(i) * 2, sizeof(value));
+      return value;
+    }
+    u32 value;
+    std::memcpy(&value, data + static_cast<std::size_t>(i) * 4, sizeof(value));
+    return value;
+  }
+
+  auto MeshView::unpack() const -> MeshData
+  {
+    MeshData data;
+    data.positions.reserve(vertex_count());
+    for (u32 i{ 0 }; i < vertex_count(); ++i) {
+      data.positions.push_back(position(i));
+      if (has_normals()) {
+        data.normals.push_back(normal(i));
+      }
+      if (has_colors()) {
+        data.colors.push_back(color(i));
+      }
+    }
+    data.indices.reserve(index_count());
+    for (u32 i{ 0 }; i < index_count(); ++i) {
+      data.indices.push_back(index(i));
+    }
+    data.lods.reserve(lod_count());
+    for (u32 level{ 0 }; level < lod_count(); ++level) {
+      data.lods.push_back(lod(level));
+    }
+    data.meshlets = MeshletData{
+      .meshlets = { meshlets().begin(), meshlets().end() },
+      .bounds = { meshlet_bounds().begin(), meshlet_bounds().end() },
+      .vertices = { meshlet_vertices().begin(), meshlet_vertices().end() },
+      .triangles = { meshlet_triangles().begin(), meshlet_triangles().end() },
+    };
+    return data;
+  }
+
+  //
+  //  Mesh
+  //
+
+  Mesh::Mesh(std::vector<std::byte>&& storage, const MeshView& view):
+    storage_{ std::move(storage) },
+    view_{ view } {}
+
+  auto Mesh::from_bytes(const std::span<const std::byte> bytes) -> std::optional<Mesh>
+  {
+    std::vector<std::byte> storage{ bytes.begin(), bytes.end() };
+    if (const auto view{ MeshView::parse(storage) }) {
+      return Mesh{ std::move(storage), *view };
+    }
+    return std::nullopt;
+  }
+
+  auto Mesh::view() const -> const MeshView&
+  {
+    return view_;
+  }
+
+  auto Mesh::size_bytes() const -> u64
+  {
+    return storage_.size();
+  }
+
+  //
+  //  Encoding
+  //
+
+  auto encode_mesh(const MeshData& data) -> std::vector<std::byte>
+  {
+    using namespace mesh_format;
+    const auto vertex_count{ static_cast<u32>(data.positions.size()) };
+    if ((!data.normals.empty() && data.normals.size() != vertex_count) ||
+        (!data.colors.empty() && data.colors.size() != vertex_count)) {
+      Log::error("Mesh attributes don't match its {} positions", vertex_count);
+      return {};
+    }
+    if (std::ranges::any_of(data.indices, [vertex_count](const u32 index) { return index >= vertex_count; })) {
+      Log::error("Mesh has indices past its {} vertices", vertex_count);
+      return {};
+    }
+    const auto index_count{ static_cast<u32>(data.indices.size()) };
+    const auto lods{
+      data.lods.empty() ? std::vector<MeshLod>{ MeshLod{ .index_offset = 0, .index_count = index_count, .error = 0.f } } : data.lods
+    };
+    if (std::ranges::any_of(lods, [index_count](const MeshLod& lod) {
+      return lod.index_offset > index_count || lod.index_count > index_count - lod.index_offset;
+    })) {
+      Log::error("Mesh has LODs past its {} indices", index_count);
+      return {};
+    }
+    const auto& meshlets{ data.meshlets };
+    if (meshlets.bounds.size() != meshlets.meshlets.size() || meshlets.triangles.size() % 3 != 0 ||
+        std::ranges::any_of(meshlets.vertices, [vertex_count](const u32 vertex) { return vertex >= vertex_count; })) {
+      Log::error("Mesh has malformed meshlets");
+      return {};
+    }
+
+    std::array<float, 3> bounds_min{};
+    std::array<float, 3> bounds_max{};
+    if (vertex_count != 0) {
+      bounds_min = { data.positions[0].x, data.positions[0].y, data.positions[0].z };
+      bounds_max = bounds_min;
+      for (const auto& position: data.positions) {
+        const std::array<float, 3> p{ position.x, position.y, position.z };
+        for (std::size_t axis{ 0 }; axis < 3; ++axis) {
+          bounds_min[axis] = std::min(bounds_min[axis], p[axis]);
+          bounds_max[axis] = std::max(bounds_max[axis], p[axis]);
+        }
+      }
+    }
+
+    const u32 index_size{ vertex_count <= 65536 ? 2U : 4U };
+    Header header{
+      .magic = magic,
+      .version = version,
+      .flags = (data.normals.empty() ? None : HasNormals) | (data.colors.empty() ? None : HasColors),
+      .vertex_count = vertex_count,
+      .index_count = index_count,
+      .index_size = index_size,
+      .bounds_min = bounds_min,
+      .bounds_max = bounds_max,
+      .vertex_offset = align_up(sizeof(Header)),
+      .lod_count = static_cast<u32>(lods.size()),
+      .meshlet_count = static_cast<u32>(meshlets.meshlets.size()),
+      .meshlet_vertex_count = static_cast<u32>(meshlets.vertices.size()),
+      .meshlet_triangle_count = static_cast<u32>(meshlets.triangles.size() / 3),
+    };
+    header.index_offset = align_up(header.vertex_offset + static_cast<u64>(vertex_count) * sizeof(PackedVertex));
+    header.lod_offset = align_up(header.index_offset + static_cast<u64>(header.index_count) * index_size);
+    header.meshlet_offset = align_up(header.lod_offset + static_cast<u64>(header.lod_count) * sizeof(Lod));
+    header.meshlet_bounds_offset = align_up(header.meshlet_offset + std::span{ meshlets.meshlets }.size_bytes());
+    header.meshlet_vertices_offset = align_up(header.meshlet_bounds_offset + std::span{ meshlets.bounds }.size_bytes());
+    header.meshlet_triangles_offset = align_up(header.meshlet_vertices_offset + std::span{ meshlets.vertices }.size_bytes());
+    const auto total_size{ header.meshlet_triangles_offset + meshlets.triangles.size() };
+
+    std::vector<std::byte> bytes(static_cast<std::size_t>(total_size));
+    std::memcpy(bytes.data(), &header, sizeof(header));
+
+    auto* vertices{ reinterpret_cast<PackedVertex*>(bytes.data() + header.vertex_offset) };
+    for (u32 i{ 0 }; i < vertex_count; ++i) {
+      const std::array<float, 3> p{ data.positions[i].x, data.positions[i].y, data.positions[i].z };
+      auto& vertex{ vertices[i] };
+      vertex = PackedVertex{};
+      for (std::size_t axis{ 0 }; axis < 3; ++axis) {
+        const auto extent{ bounds_max[axis] - bounds_min[axis] };
+        const auto t{ extent > 0.f ? (p[axis] - bounds_min[axis]) / extent : 0.f };
+        vertex.position[axis] = static_cast<u16>(std::round(std::clamp(t, 0.f, 1.f) * 65535.f));
+      }
+      vertex.normal = data.normals.empty() ? 0 : pack_normal(data.normals[i]);
+      // Opaque white without colors, so shaders can multiply unconditionally
+      vertex.color = data.colors.empty() ? 0xFFFFFFFF : pack_color(data.colors[i]);
+    }
+
+    auto* indices{ bytes.data() + header.index_offset };
+    for (std::size_t i{ 0 }; i < data.indices.size(); ++i) {
+      if (index_size == 2) {
+        const auto index{ static_cast<u16>(data.indices[i]) };
+        std::memcpy(indices + i * 2, &index, sizeof(index));
+      } else {
+        std::memcpy(indices + i * 4, &data.indices[i], sizeof(u32));
+      }
+    }
+
+    for (std::size_t level{ 0 }; level < lods.size(); ++level) {
+      const Lod lod{ .index_offset = lods[level].index_offset, .index_count = lods[level].index_count, .error = lods[level].error };
+      std::memcpy(bytes.data() + header.lod_offset + level * sizeof(Lod), &lod, sizeof(lod));
+    }
+
+    const auto copy_block{ [&bytes](const u64 offset, const auto& block) {
+      if (!block.empty()) {
+        std::memcpy(bytes.data() + offset, block.data(), std::span{ block }.size_bytes());
+      }
+    } };
+    copy_block(header.meshlet_offset, meshlets.meshlets);
+    copy_block(header.meshlet_bounds_offset, meshlets.bounds);
+    copy_block(header.meshlet_vertices_offset, meshlets.vertices);
+    copy_block(header.meshlet_triangles_offset, meshlets.triangles);
+    return bytes;
+  }
+}
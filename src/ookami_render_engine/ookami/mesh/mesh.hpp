@@ -0,0 +1,181 @@
+//
+// Compact mesh format (.fxm) and its in-memory layout, which are one and the same: a header followed by
+// interleaved 16 byte vertices and then the indices, each block aligned so it can be copied into a staging
+// buffer (or bound) straight out of a memory mapped file.
+//
+//   position  3 x u16  quantized to the mesh bounds, plus one u16 of padding
+//   normal    u32      octahedral encoding, 2 x snorm16
+//   color     u32      RGBA8 unorm
+//
+// Indices are 16 bit whenever the vertex count allows it. That's 16 bytes per vertex against the 40 of
+// unpacked vec3 positions, vec3 normals, and vec4 colors. Levels of detail share the vertex block, each one is
+// a range of the index block listed in the LOD table that follows it. Meshes may also carry LOD 0 split into
+// meshlets (see meshlet.hpp), stored as their four arrays after the LOD table.
+//
+// Sources:
+// https://jcgt.org/published/0003/02/01/
+// https://knarkowicz.wordpress.com/2014/04/16/octahedron-normal-vector-encoding/
+//
+
+#pragma once
+
+#include "meshlet.hpp"
+
+namespace fx {
+  // A range of MeshData::indices (or the index block) drawn for one level of detail
+  struct MeshLod {
+    u32 index_offset;
+    u32 index_count;
+    // Object space distance the simplified surface may deviate from the full detail one, zero for LOD 0
+    float error;
+  };
+
+  // Unpacked mesh, what importers produce and the encoder consumes
+  struct MeshData {
+    std::vector<vec3> positions;
+    // Empty, or one per position
+    std::vector<vec3> normals;
+    std::vector<vec4> colors;
+    std::vector<u32> indices;
+    // Finest first. Empty means one level covering every index.
+    std::vector<MeshLod> lods;
+    // Optional, LOD 0's triangles
+    MeshletData meshlets;
+  };
+
+  struct PackedVertex {
+    std::array<u16, 4> position;
+    u32 normal;
+    u32 color;
+  };
+
+  static_assert(sizeof(PackedVertex) == 16, "PackedVertex is the on-disk and GPU layout");
+
+  namespace mesh_format {
+    inline constexpr u32 magic{ 0x534D5846 }; // "FXMS"
+    inline constexpr u32 version{ 3 };
+    // Vertex and index blocks start on multiples of this
+    inline constexpr u32 block_alignment{ 16 };
+
+    enum Flags: u32 {
+      None       = 0,
+      HasNormals = 1 << 0,
+      HasColors  = 1 << 1,
+    };
+
+    struct Header {
+      u32 magic;
+      u32 version;
+      u32 flags;
+      u32 vertex_count;
+      u32 index_count;
+      // 2 or 4
+      u32 index_size;
+      // Quantization range, position = bounds_min + q / 65535 * (bounds_max - bounds_min)
+      std::array<float, 3> bounds_min;
+      std::array<float, 3> bounds_max;
+      u64 vertex_offset;
+      u64 index_offset;
+      // Always at least one
+      u32 lod_count;
+      // All zero without meshlets
+      u32 meshlet_count;
+      u64 lod_offset;
+      u32 meshlet_vertex_count;
+      // In triangles, three bytes each
+      u32 meshlet_triangle_count;
+      u64 meshlet_offset;
+      u64 meshlet_bounds_offset;
+      u64 meshlet_vertices_offset;
+      u64 meshlet_triangles_offset;
+      u64 reserved;
+    };
+
+    static_assert(sizeof(Header) == 128, "Header is on disk, keep it packed");
+
+    struct Lod {
+      u32 index_offset;
+      u32 index_count;
+      float error;
+      u32 reserved;
+    };
+
+    static_assert(sizeof(Lod) == 16, "Lod is on disk, keep it packed");
+
+    [[nodiscard]] auto pack_normal(const vec3& normal) -> u32;
+    [[nodiscard]] auto unpack_normal(u32 packed) -> vec3;
+    [[nodiscard]] auto pack_color(const vec4& color) -> u32;
+    [[nodiscard]] auto unpack_color(u32 packed) -> vec4;
+  }
+
+  // Non-owning, validated view over a .fxm file's bytes. The bytes must outlive it and be 16 byte aligned
+  // (mapped files and archive entries are).
+  class MeshView {
+  public:
+    // Nothing when the bytes aren't a valid mesh
+    [[nodiscard]] static auto parse(std::span<const std::byte> bytes) -> std::optional<MeshView>;
+
+    [[nodiscard]] auto header() const -> const mesh_format::Header&;
+    [[nodiscard]] auto vertex_count() const -> u32;
+    [[nodiscard]] auto index_count() const -> u32;
+    [[nodiscard]] auto has_normals() const -> bool;
+    [[nodiscard]] auto has_colors() const -> bool;
+    [[nodiscard]] auto lod_count() const -> u32;
+    [[nodiscard]] auto lod(u32 level) const -> MeshLod;
+
+    [[nodiscard]] auto vertices() const -> std::span<const PackedVertex>;
+    // Exactly one of these is non-empty (unless there are no indices)
+    [[nodiscard]] auto indices16() const -> std::span<const u16>;
+    [[nodiscard]] auto indices32() const -> std::span<const u32>;
+    // GPU ready blocks, a single memcpy each into a staging buffer
+    [[nodiscard]] auto vertex_bytes() const -> std::span<const std::byte>;
+    [[nodiscard]] auto index_bytes() const -> std::span<const std::byte>;
+    // Empty without meshlets, each one is a GPU ready block as well
+    [[nodiscard]] auto meshlets() const -> std::span<const Meshlet>;
+    [[nodiscard]] auto meshlet_bounds() const -> std::span<const MeshletBounds>;
+    [[nodiscard]] auto meshlet_vertices() const -> std::span<const u32>;
+    [[nodiscard]] auto meshlet_triangles() const -> std::span<const u8>;
+
+    // For the vertex shader: position = q * dequantize_scale() + dequantize_offset(), q as raw u16
+    [[nodiscard]] auto dequantize_scale() const -> vec3;
+    [[nodiscard]] auto dequantize_offset() const -> vec3;
+    [[nodiscard]] auto position(u32 vertex) const -> vec3;
+    [[nodiscard]] auto normal(u32 vertex) const -> vec3;
+    [[nodiscard]] auto color(u32 vertex) const -> vec4;
+    [[nodiscard]] auto index(u32 i) const -> u32;
+
+    // Back to floats, lossy
+    [[nodiscard]] auto unpack() const -> MeshData;
+
+  private:
+    std::span<const std::byte> bytes_{};
+
+    explicit MeshView(std::span<const std::byte> bytes);
+  };
+
+  // A mesh that owns its bytes, e.g. what the asset manager keeps around. Movable, the view moves along.
+  class Mesh {
+  public:
+    // Nothing when the bytes aren't a valid mesh
+    [[nodiscard]] static auto from_bytes(std::span<const std::byte> bytes) -> std::optional<Mesh>;
+
+    Mesh(Mesh&& other) noexcept = default;
+    auto operator=(Mesh&& other) noexcept -> Mesh& = default;
+    // A copy's view would still point into the original
+    Mesh(const Mesh& other) = delete;
+    auto operator=(const Mesh& other) -> Mesh& = delete;
+
+    [[nodiscard]] auto view() const -> const MeshView&;
+    [[nodiscard]] auto size_bytes() const -> u64;
+
+  private:
+    // Heap blocks are 16 byte aligned, which is all the view needs
+    std::vector<std::byte> storage_;
+    MeshView view_;
+
+    Mesh(std::vector<std::byte>&& storage, const MeshView& view);
+  };
+
+  // Quantizes and packs a mesh into .fxm bytes. Normals and colors are dropped when the data has none.
+  [[nodiscard]] auto encode_mesh(const MeshData& data) -> std::vector<std::byte>;
+}
@@ -0,0 +1,745 @@
+#include "mesh_optimizer.hpp"
+
+namespace fx {
+  namespace {
+    constexpr u32 no_vertex{ std::numeric_limits<u32>::max() };
+
+    [[nodiscard]] auto subtract(const vec3& a, const vec3& b) -> vec3
+    {
+      return vec3{ a.x - b.x, a.y - b.y, a.z - b.z };
+    }
+
+    [[nodiscard]] auto cross(const vec3& a, const vec3& b) -> vec3
+    {
+      return vec3{ a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+    }
+
+    [[nodiscard]] auto dot(const vec3& a, const vec3& b) -> float
+    {
+      return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    [[nodiscard]] auto length(const vec3& v) -> float
+    {
+      return std::sqrt(dot(v, v));
+    }
+
+    // Largest side of the bounds of every referenced vertex, what relative errors are measured against
+    [[nodiscard]] auto mesh_extent(const std::span<const u32> indices, const std::span<const vec3> positions) -> float
+    {
+      if (indices.empty()) {
+        return 0.f;
+      }
+      auto min{ positions[indices[0]] };
+      auto max{ min };
+      for (const auto index: indices) {
+        const auto& p{ positions[index] };
+        min = vec3{ std::min(min.x, p.x), std::min(min.y, p.y), std::min(min.z, p.z) };
+        max = vec3{ std::max(max.x, p.x), std::max(max.y, p.y), std::max(max.z, p.z) };
+      }
+      return std::max({ max.x - min.x, max.y - min.y, max.z - min.z });
+    }
+
+    // FIFO cache simulated with timestamps: a vertex is cached if it was transformed within the last cache_size
+    // misses. Returns how many of the triangle's vertices missed.
+    [[nodiscard]] auto cache_misses(
+      const std::span<const u32> triangle,
+      const u32 cache_size,
+      std::vector<u32>& timestamps,
+      u32& timestamp
+    ) -> u32
+    {
+      u32 misses{ 0 };
+      for (const auto vertex: triangle) {
+        if (timestamp - timestamps[vertex] > cache_size) {
+          timestamps[vertex] = timestamp++;
+          ++misses;
+        }
+      }
+      return misses;
+    }
+
+    //
+    //  Forsyth's scoring, the constants are the ones from the paper
+    //
+
+    constexpr u32 forsyth_cache_size{ 32 };
+
+    [[nodiscard]] auto forsyth_vertex_score(const i32 cache_position, const u32 remaining_triangles) -> float
+    {
+      if (remaining_triangles == 0) {
+        return -1.f;
+      }
+      float score{ 0.f };
+      if (cache_position >= 0) {
+        // The last triangle's vertices are scored flat so it isn't immediately reused by a neighbor sharing an edge
+        score = cache_position < 3
+          ? 0.75f
+          : std::pow(1.f - static_cast<float>(cache_position - 3) / static_cast<float>(forsyth_cache_size - 3), 1.5f);
+      }
+      // Boosts vertices with few triangles left so they get finished off instead of lingering
+      return score + 2.f / std::sqrt(static_cast<float>(remaining_triangles));
+    }
+
+    //
+    //  Quadric error metric
+    //
+
+    struct Quadric {
+      // Symmetric 3x3 A, b, and c of the plane distance form p^T A p + 2 b.p + c, plus the total weight
+      double a00{ 0. }, a01{ 0. }, a02{ 0. }, a11{ 0. }, a12{ 0. }, a22{ 0. };
+      double b0{ 0. }, b1{ 0. }, b2{ 0. };
+      double c{ 0. };
+      double weight{ 0. };
+
+      void add_plane(const vec3& normal, const float distance, const double plane_weight)
+      {
+        const double x{ normal.x }, y{ normal.y }, z{ normal.z }, d{ distance };
+        a00 += plane_weight * x * x; a01 += plane_weight * x * y; a02 += plane_weight * x * z;
+        a11 += plane_weight * y * y; a12 += plane_weight * y * z; a22 += plane_weight * z * z;
+        b0 += plane_weight * x * d; b1 += plane_weight * y * d; b2 += plane_weight * z * d;
+        c += plane_weight * d * d;
+        weight += plane_weight;
+      }
+
+      auto operator+=(const Quadric& other) -> Quadric&
+      {
+        a00 += other.a00; a01 += other.a01; a02 += other.a02;
+        a11 += other.a11; a12 += other.a12; a22 += other.a22;
+        b0 += other.b0; b1 += other.b1; b2 += other.b2;
+        c += other.c;
+        weight += other.weight;
+        return *this;
+      }
+
+      // Weighted mean squared distance from p to the planes
+      [[nodiscard]] auto error(const vec3& p) const -> double
+      {
+        const double x{ p.x }, y{ p.y }, z{ p.z };
+        const auto sum{
+          a00 * x * x + a11 * y * y + a22 * z * z + 2. * (a01 * x * y + a02 * x * z + a12 * y * z) +
+          2. * (b0 * x + b1 * y + b2 * z) + c
+        };
+        return weight > 0. ? std::max(sum, 0.) / weight : 0.;
+      }
+    };
+
+    // Open borders are held in place by planes through the edge, perpendicular to the face
+    constexpr double border_weight{ 10. };
+
+    [[nodiscard]] auto edge_key(const u32 a, const u32 b) -> u64
+    {
+      return static_cast<u64>(std::min(a, b)) << 32 | std::max(a, b);
+    }
+
+    struct Collapse {
+      double cost;
+      u32 from;
+      u32 to;
+
+      [[nodiscard]] auto operator>(const Collapse& other) const -> bool
+      {
+        return cost > other.cost;
+      }
+    };
+  }
+
+  auto analyze_vertex_cache(
+    const std::span<const u32> indices,
+    const u32 vertex_count,
+    const u32 cache_size,
+    const u32 vertex_size
+  ) -> VertexCacheStats
+  {
+    const auto triangle_count{ static_cast<u32>(indices.size() / 3) };
+    if (triangle_count == 0) {
+      return {};
+    }
+
+    // Direct mapped 16 KiB of 64 byte lines, roughly what sits in front of vertex fetch
+    constexpr u32 line_size{ 64 };
+    constexpr u32 line_count{ 256 };
+    std::array<u64, line_count> lines;
+    lines.fill(std::numeric_limits<u64>::max());
+
+    std::vector<u32> timestamps(vertex_count, 0);
+    std::vector<bool> referenced(vertex_count, false);
+    auto timestamp{ cache_size + 1 };
+    u32 unique_vertices{ 0 };
+    u64 fetched_bytes{ 0 };
+    for (const auto vertex: indices.first(static_cast<std::size_t>(triangle_count) * 3)) {
+      if (!referenced[vertex]) {
+        referenced[vertex] = true;
+        ++unique_vertices;
+      }
+      if (timestamp - timestamps[vertex] <= cache_size) {
+        continue;
+      }
+      timestamps[vertex] = timestamp++;
+      const auto first_byte{ static_cast<u64>(vertex) * vertex_size };
+      for (auto line{ first_byte / line_size }; line <= (first_byte + vertex_size - 1) / line_size; ++line) {
+        if (lines[line % line_count] != line) {
+          lines[line % line_count] = line;
+          fetched_bytes += line_size;
+        }
+      }
+    }
+
+    const auto transformed{ timestamp - (cache_size + 1) };
+    return VertexCacheStats{
+      .vertices_transformed = transformed,
+      .acmr = static_cast<float>(transformed) / static_cast<float>(triangle_count),
+      .atvr = static_cast<float>(transformed) / static_cast<float>(unique_vertices),
+      .overfetch = static_cast<float>(fetched_bytes) / static_cast<float>(static_cast<u64>(unique_vertices) * vertex_size),
+    };
+  }
+
+  auto optimize_vertex_cache(const std::span<const u32> indices, const u32 vertex_count) -> std::vector<u32>
+  {
+    const auto triangle_count{ static_cast<u32>(indices.size() / 3) };
+    std::vector<u32> result;
+    result.reserve(static_cast<std::size_t>(triangle_count) * 3);
+    if (triangle_count == 0) {
+      return result;
+    }
+
+    // Triangles per vertex, packed. Emitted triangles are swapped past the end of their vertex's live range.
+    std::vector<u32> remaining(vertex_count, 0);
+    for (u32 i{ 0 }; i < triangle_count * 3; ++i) {
+      ++remaining[indices[i]];
+    }
+    std::vector<u32> offsets(vertex_count, 0);
+    std::exclusive_scan(remaining.begin(), remaining.end(), offsets.begin(), 0U);
+    std::vector<u32> adjacency(static_cast<std::size_t>(triangle_count) * 3);
+    {
+      auto cursor{ offsets };
+      for (u32 i{ 0 }; i < triangle_count * 3; ++i) {
+        adjacency[cursor[indices[i]]++] = i / 3;
+      }
+    }
+
+    std::vector<i32> cache_positions(vertex_count, -1);
+    std::vector<float> vertex_scores(vertex_count);
+    for (u32 vertex{ 0 }; vertex < vertex_count; ++vertex) {
+      vertex_scores[vertex] = forsyth_vertex_score(-1, remaining[vertex]);
+    }
+    std::vector<float> triangle_scores(triangle_count);
+    std::vector<bool> emitted(triangle_count, false);
+    auto best{ no_vertex };
+    auto best_score{ -1.f };
+    for (u32 triangle{ 0 }; triangle < triangle_count; ++triangle) {
+      const auto* corners{ &indices[static_cast<std::size_t>(triangle) * 3] };
+      triangle_scores[triangle] = vertex_scores[corners[0]] + vertex_scores[corners[1]] + vertex_scores[corners[2]];
+      if (triangle_scores[triangle] > best_score) {
+        best = triangle;
+        best_score = triangle_scores[triangle];
+      }
+    }
+
+    std::vector<u32> cache;
+    std::vector<u32> next_cache;
+    cache.reserve(forsyth_cache_size + 3);
+    next_cache.reserve(forsyth_cache_size + 3);
+    u32 cursor{ 0 };
+    while (result.size() < static_cast<std::size_t>(triangle_count) * 3) {
+      if (best == no_vertex) {
+        // Nothing in the cache has triangles left, restart from the next unemitted one in input order
+        while (emitted[cursor]) {
+          ++cursor;
+        }
+        best = cursor;
+      }
+
+      const auto corners{ indices.subspan(static_cast<std::size_t>(best) * 3, 3) };
+      result.insert(result.end(), corners.begin(), corners.end());
+      emitted[best] = true;
+
+      next_cache.clear();
+      for (const auto vertex: corners) {
+        auto* first{ &adjacency[offsets[vertex]] };
+        auto* last{ first + remaining[vertex] };
+        *std::find(first, last, best) = *(last - 1);
+        --remaining[vertex];
+        if (std::ranges::find(next_cache, vertex) == next_cache.end()) {
+          next_cache.push_back(vertex);
+        }
+      }
+      for (const auto vertex: cache) {
+        if (std::ranges::find(corners, vertex) == corners.end()) {
+          next_cache.push_back(vertex);
+        }
+      }
+
+      // Rescore everything that moved in (or fell out of) the cache and propagate into its triangles
+      for (std::size_t position{ 0 }; position < next_cache.size(); ++position) {
+        const auto vertex{ next_cache[position] };
+        cache_positions[vertex] = position < forsyth_cache_size ? static_cast<i32>(position) : -1;
+        const auto score{ forsyth_vertex_score(cache_positions[vertex], remaining[vertex]) };
+        const auto delta{ score - vertex_scores[vertex] };
+        vertex_scores[vertex] = score;
+        for (u32 i{ 0 }; i < remaining[vertex]; ++i) {
+          triangle_scores[adjacency[offsets[vertex] + i]] += delta;
+        }
+      }
+      next_cache.resize(std::min<std::size_t>(next_cache.size(), forsyth_cache_size));
+      std::swap(cache, next_cache);
+
+      best = no_vertex;
+      best_score = -1.f;
+      for (const auto vertex: cache) {
+        for (u32 i{ 0 }; i < remaining[vertex]; ++i) {
+          const auto triangle{ adjacency[offsets[vertex] + i] };
+          if (triangle_scores[triangle] > best_score) {
+            best = triangle;
+            best_score = triangle_scores[triangle];
+          }
+        }
+      }
+    }
+    return result;
+  }
+
+  auto optimize_overdraw(
+    const std::span<const u32> indices,
+    const std::span<const vec3> positions,
+    const float threshold
+  ) -> std::vector<u32>
+  {
+    constexpr u32 cache_size{ 16 };
+    const auto triangle_count{ static_cast<u32>(indices.size() / 3) };
+    if (triangle_count == 0) {
+      return {};
+    }
+    const auto triangle{ [&indices](const u32 i) { return indices.subspan(static_cast<std::size_t>(i) * 3, 3); } };
+
+    std::vector<u32> timestamps(positions.size(), 0);
+    u32 timestamp{ 0 };
+    const auto reset_cache{ [&timestamp] { timestamp += cache_size + 1; } };
+
+    // Hard boundaries: a triangle missing on all three vertices starts a disjoint patch of the mesh
+    std::vector<u32> patches;
+    reset_cache();
+    for (u32 i{ 0 }; i < triangle_count; ++i) {
+      if (cache_misses(triangle(i), cache_size, timestamps, timestamp) == 3 || i == 0) {
+        patches.push_back(i);
+      }
+    }
+
+    // Soft boundaries: split each patch wherever the ACMR so far is already within threshold of the patch's own,
+    // so reordering the pieces costs little cache efficiency
+    std::vector<u32> clusters;
+    for (std::size_t patch{ 0 }; patch < patches.size(); ++patch) {
+      const auto start{ patches[patch] };
+      const auto end{ patch + 1 < patches.size() ? patches[patch + 1] : triangle_count };
+
+      reset_cache();
+      u32 patch_misses{ 0 };
+      for (auto i{ start }; i < end; ++i) {
+        patch_misses += cache_misses(triangle(i), cache_size, timestamps, timestamp);
+      }
+      const auto target_acmr{ threshold * static_cast<float>(patch_misses) / static_cast<float>(end - start) };
+
+      clusters.push_back(start);
+      reset_cache();
+      u32 misses{ 0 };
+      u32 triangles{ 0 };
+      for (auto i{ start }; i < end; ++i) {
+        misses += cache_misses(triangle(i), cache_size, timestamps, timestamp);
+        ++triangles;
+        if (static_cast<float>(misses) / static_cast<float>(triangles) <= target_acmr) {
+          clusters.push_back(i + 1);
+          reset_cache();
+          misses = 0;
+          triangles = 0;
+        }
+      }
+      // The tail after the last split rarely reaches the target by itself, it's merged into the cluster before it
+      if (clusters.back() != start) {
+        clusters.pop_back();
+      }
+    }
+
+    // Clusters facing away from the mesh's center are the likeliest occluders, so they're drawn first
+    vec3 mesh_center{ 0.f, 0.f, 0.f };
+    float mesh_area{ 0.f };
+    std::vector<vec3> centers(clusters.size(), vec3{ 0.f, 0.f, 0.f });
+    std::vector<vec3> normals(clusters.size(), vec3{ 0.f, 0.f, 0.f });
+    std::vector<float> areas(clusters.size(), 0.f);
+    for (std::size_t cluster{ 0 }; cluster < clusters.size(); ++cluster) {
+      const auto end{ cluster + 1 < clusters.size() ? clusters[cluster + 1] : triangle_count };
+      for (auto i{ clusters[cluster] }; i < end; ++i) {
+        const auto corners{ triangle(i) };
+        const auto& a{ positions[corners[0]] };
+        const auto& b{ positions[corners[1]] };
+        const auto& c{ positions[corners[2]] };
+        const auto normal{ cross(subtract(b, a), subtract(c, a)) };
+        const auto area{ length(normal) };
+        const auto& center{ centers[cluster] };
+        centers[cluster] = vec3{
+          center.x + (a.x + b.x + c.x) / 3.f * area,
+          center.y + (a.y + b.y + c.y) / 3.f * area,
+          center.z + (a.z + b.z + c.z) / 3.f * area,
+        };
+        normals[cluster] = vec3{ normals[cluster].x + normal.x, normals[cluster].y + normal.y, normals[cluster].z + normal.z };
+        areas[cluster] += area;
+      }
+      const auto& center{ centers[cluster] };
+      mesh_center = vec3{ mesh_center.x + center.x, mesh_center.y + center.y, mesh_center.z + center.z };
+      mesh_area += areas[cluster];
+    }
+    if (mesh_area > 0.f) {
+      mesh_center = vec3{ mesh_center.x / mesh_area, mesh_center.y / mesh_area, mesh_center.z / mesh_area };
+    }
+
+    std::vector<float> sort_keys(clusters.size(), 0.f);
+    for (std::size_t cluster{ 0 }; cluster < clusters.size(); ++cluster) {
+      const auto normal_length{ length(normals[cluster]) };
+      if (areas[cluster] <= 0.f || normal_length <= 0.f) {
+        continue;
+      }
+      const auto& center{ centers[cluster] };
+      const vec3 offset{
+        center.x / areas[cluster] - mesh_center.x,
+        center.y / areas[cluster] - mesh_center.y,
+        center.z / areas[cluster] - mesh_center.z,
+      };
+      sort_keys[cluster] = dot(offset, normals[cluster]) / normal_length;
+    }
+
+    std::vector<u32> order(clusters.size());
+    std::iota(order.begin(), order.end(), 0U);
+    std::ranges::stable_sort(order, [&sort_keys](const u32 a, const u32 b) { return sort_keys[a] > sort_keys[b]; });
+
+    std::vector<u32> result;
+    result.reserve(static_cast<std::size_t>(triangle_count) * 3);
+    for (const auto cluster: order) {
+      const auto end{ cluster + 1 < clusters.size() ? clusters[cluster + 1] : triangle_count };
+      const auto range{ indices.subspan(static_cast<std::size_t>(clusters[cluster]) * 3, static_cast<std::size_t>(end - clusters[cluster]) * 3) };
+      result.insert(result.end(), range.begin(), range.end());
+    }
+    return result;
+  }
+
+  void optimize_vertex_fetch(MeshData& mesh)
+  {
+    std::vector<u32> remap(mesh.positions.size(), no_vertex);
+    u32 vertex_count{ 0 };
+    for (auto& index: mesh.indices) {
+      if (remap[index] == no_vertex) {
+        remap[index] = vertex_count++;
+      }
+      index = remap[index];
+    }
+
+    const auto reorder{ [&remap, vertex_count]<typename T>(std::vector<T>& attribute) {
+      if (attribute.empty()) {
+        return;
+      }
+      std::vector<T> reordered(vertex_count);
+      for (std::size_t vertex{ 0 }; vertex < attribute.size(); ++vertex) {
+        if (remap[vertex] != no_vertex) {
+          reordered[remap[vertex]] = attribute[vertex];
+        }
+      }
+      attribute = std::move(reordered);
+    } };
+    reorder(mesh.positions);
+    reorder(mesh.normals);
+    reorder(mesh.colors);
+    for (auto& vertex: mesh.meshlets.vertices) {
+      vertex = remap[vertex];
+    }
+  }
+
+  auto simplify(
+    const std::span<const u32> indices,
+    const std::span<const vec3> positions,
+    const u32 target_index_count,
+    const float target_error
+  ) -> SimplifyResult
+  {
+    const auto vertex_count{ static_cast<u32>(positions.size()) };
+    const auto triangle_count{ static_cast<u32>(indices.size() / 3) };
+    std::vector<std::array<u32, 3>> triangles(triangle_count);
+    for (u32 i{ 0 }; i < triangle_count; ++i) {
+      triangles[i] = { indices[i * 3], indices[i * 3 + 1], indices[i * 3 + 2] };
+    }
+
+    std::unordered_map<u64, u32> edge_counts;
+    for (const auto& triangle: triangles) {
+      for (u32 corner{ 0 }; corner < 3; ++corner) {
+        ++edge_counts[edge_key(triangle[corner], triangle[(corner + 1) % 3])];
+      }
+    }
+
+    // Seam vertices (same position, different attributes) would tear apart if collapsed on their own, and
+    // non-manifold ones can't be reasoned about locally, so both stay put
+    std::vector<bool> locked(vertex_count, false);
+    std::vector<bool> border(vertex_count, false);
+    {
+      std::unordered_map<u64, u32> first_at_position;
+      std::vector<bool> referenced(vertex_count, false);
+      for (const auto& triangle: triangles) {
+        for (const auto vertex: triangle) {
+          if (referenced[vertex]) {
+            continue;
+          }
+          referenced[vertex] = true;
+          const auto& p{ positions[vertex] };
+          const auto key{
+            static_cast<u64>(std::bit_cast<u32>(p.x)) * 0x9E3779B97F4A7C15ULL ^
+            static_cast<u64>(std::bit_cast<u32>(p.y)) * 0xC2B2AE3D27D4EB4FULL ^
+            static_cast<u64>(std::bit_cast<u32>(p.z))
+          };
+          const auto [it, inserted]{ first_at_position.try_emplace(key, vertex) };
+          if (!inserted) {
+            locked[vertex] = true;
+            locked[it->second] = true;
+          }
+        }
+      }
+      for (const auto& [key, count]: edge_counts) {
+        const auto a{ static_cast<u32>(key >> 32) };
+        const auto b{ static_cast<u32>(key & 0xFFFFFFFF) };
+        if (count == 1) {
+          border[a] = border[b] = true;
+        } else if (count > 2) {
+          locked[a] = locked[b] = true;
+        }
+      }
+    }
+
+    std::vector<Quadric> quadrics(vertex_count);
+    std::vector<std::vector<u32>> vertex_triangles(vertex_count);
+    for (u32 t{ 0 }; t < triangle_count; ++t) {
+      const auto& triangle{ triangles[t] };
+      const auto& a{ positions[triangle[0]] };
+      const auto face{ cross(subtract(positions[triangle[1]], a), subtract(positions[triangle[2]], a)) };
+      const auto double_area{ length(face) };
+      for (u32 corner{ 0 }; corner < 3; ++corner) {
+        vertex_triangles[triangle[corner]].push_back(t);
+      }
+      if (double_area <= 0.f) {
+        continue;
+      }
+      const vec3 normal{ face.x / double_area, face.y / double_area, face.z / double_area };
+      for (u32 corner{ 0 }; corner < 3; ++corner) {
+        quadrics[triangle[corner]].add_plane(normal, -dot(normal, a), double_area * 0.5);
+      }
+      for (u32 corner{ 0 }; corner < 3; ++corner) {
+        const auto from{ triangle[corner] };
+        const auto to{ triangle[(corner + 1) % 3] };
+        if (edge_counts[edge_key(from, to)] != 1) {
+          continue;
+        }
+        const auto edge{ subtract(positions[to], positions[from]) };
+        const auto side{ cross(edge, normal) };
+        const auto side_length{ length(side) };
+        if (side_length <= 0.f) {
+          continue;
+        }
+        const vec3 plane{ side.x / side_length, side.y / side_length, side.z / side_length };
+        const auto weight{ static_cast<double>(dot(edge, edge)) * border_weight };
+        quadrics[from].add_plane(plane, -dot(plane, positions[from]), weight);
+        quadrics[to].add_plane(plane, -dot(plane, positions[from]), weight);
+      }
+    }
+
+    std::vector<bool> live_triangles(triangle_count, true);
+    const auto shared_triangles{ [&](const u32 from, const u32 to) {
+      u32 count{ 0 };
+      for (const auto t: vertex_triangles[from]) {
+        count += live_triangles[t] && std::ranges::find(triangles[t], to) != triangles[t].end() ? 1 : 0;
+      }
+      return count;
+    } };
+    // Half edge collapse from -> to, the surviving vertex keeps its position
+    const auto collapse_cost{ [&](const u32 from, const u32 to) {
+      auto combined{ quadrics[from] };
+      combined += quadrics[to];
+      return combined.error(positions[to]);
+    } };
+    const auto flips_triangle{ [&](const u32 from, const u32 to) {
+      for (const auto t: vertex_triangles[from]) {
+        const auto& triangle{ triangles[t] };
+        if (!live_triangles[t] || std::ranges::find(triangle, to) != triangle.end()) {
+          continue;
+        }
+        std::array<vec3, 3> corners{};
+        for (u32 corner{ 0 }; corner < 3; ++corner) {
+          corners[corner] = positions[triangle[corner] == from ? to : triangle[corner]];
+        }
+        const auto& a{ positions[triangle[0]] };
+        const auto before{ cross(subtract(positions[triangle[1]], a), subtract(positions[triangle[2]], a)) };
+        const auto after{ cross(subtract(corners[1], corners[0]), subtract(corners[2], corners[0])) };
+        if (dot(before, after) <= 0.f) {
+          return true;
+        }
+      }
+      return false;
+    } };
+
+    std::priority_queue<Collapse, std::vector<Collapse>, std::greater<>> queue;
+    const auto push_edges{ [&](const u32 vertex) {
+      for (const auto t: vertex_triangles[vertex]) {
+        if (!live_triangles[t]) {
+          continue;
+        }
+        for (const auto other: triangles[t]) {
+          if (other == vertex) {
+            continue;
+          }
+          if (!locked[vertex]) {
+            queue.push(Collapse{ collapse_cost(vertex, other), vertex, other });
+          }
+          if (!locked[other]) {
+            queue.push(Collapse{ collapse_cost(other, vertex), other, vertex });
+          }
+        }
+      }
+    } };
+    for (u32 t{ 0 }; t < triangle_count; ++t) {
+      for (u32 corner{ 0 }; corner < 3; ++corner) {
+        const auto from{ triangles[t][corner] };
+        const auto to{ triangles[t][(corner + 1) % 3] };
+        if (!locked[from]) {
+          queue.push(Collapse{ collapse_cost(from, to), from, to });
+        }
+        if (!locked[to]) {
+          queue.push(Collapse{ collapse_cost(to, from), to, from });
+        }
+      }
+    }
+
+    const auto extent{ mesh_extent(indices, positions) };
+    const auto max_cost{ static_cast<double>(target_error) * extent * static_cast<double>(target_error) * extent };
+    std::vector<bool> collapsed(vertex_count, false);
+    auto live_count{ triangle_count };
+    double result_cost{ 0. };
+    while (live_count * 3 > target_index_count && !queue.empty()) {
+      const auto candidate{ queue.top() };
+      queue.pop();
+      const auto from{ candidate.from };
+      const auto to{ candidate.to };
+      if (collapsed[from] || collapsed[to]) {
+        continue;
+      }
+      const auto shared{ shared_triangles(from, to) };
+      // Border vertices only slide along the border, otherwise they'd open a hole
+      if (shared == 0 || (border[from] && shared != 1)) {
+        continue;
+      }
+      // Entries are stale once either quadric has grown, requeue at the current cost
+      const auto cost{ collapse_cost(from, to) };
+      if (cost > candidate.cost * (1. + 1e-6) + 1e-30) {
+        queue.push(Collapse{ cost, from, to });
+        continue;
+      }
+      if (cost > max_cost) {
+        break;
+      }
+      if (flips_triangle(from, to)) {
+        continue;
+      }
+
+      quadrics[to] += quadrics[from];
+      collapsed[from] = true;
+      for (const auto t: vertex_triangles[from]) {
+        if (!live_triangles[t]) {
+          continue;
+        }
+        auto& triangle{ triangles[t] };
+        if (std::ranges::find(triangle, to) != triangle.end()) {
+          live_triangles[t] = false;
+          --live_count;
+          continue;
+        }
+        std::ranges::replace(triangle, from, to);
+        vertex_triangles[to].push_back(t);
+      }
+      vertex_triangles[from].clear();
+      std::erase_if(vertex_triangles[to], [&live_triangles](const u32 t) { return !live_triangles[t]; });
+      result_cost = std::max(result_cost, cost);
+      push_edges(to);
+    }
+
+    SimplifyResult result;
+    result.indices.reserve(static_cast<std::size_t>(live_count) * 3);
+    for (u32 t{ 0 }; t < triangle_count; ++t) {
+      if (live_triangles[t]) {
+        result.indices.insert(result.indices.end(), triangles[t].begin(), triangles[t].end());
+      }
+    }
+    result.error = extent > 0.f ? static_cast<float>(std::sqrt(result_cost) / extent) : 0.f;
+    return result;
+  }
+
+  auto optimize_mesh(MeshData& mesh, const MeshOptimizeInfo& info) -> MeshOptimizeReport
+  {
+    MeshOptimizeReport report;
+    const auto vertex_count{ static_cast<u32>(mesh.positions.size()) };
+    const auto full_detail{
+      mesh.lods.empty()
+        ? std::vector<u32>{ mesh.indices }
+        : std::vector<u32>{
+          mesh.indices.begin() + mesh.lods[0].index_offset,
+          mesh.indices.begin() + mesh.lods[0].index_offset + mesh.lods[0].index_count
+        }
+    };
+    report.before = analyze_vertex_cache(full_detail, vertex_count);
+
+    std::vector<std::vector<u32>> levels{ full_detail };
+    std::vector<float> errors{ 0.f };
+    const auto extent{ mesh_extent(full_detail, mesh.positions) };
+    while (levels.size() < info.lod_count) {
+      const auto& previous{ levels.back() };
+      const auto target{ static_cast<u32>(static_cast<float>(previous.size() / 3) * info.lod_ratio) * 3 };
+      if (target == 0) {
+        break;
+      }
+      auto simplified{ simplify(previous, mesh.positions, target, info.lod_max_error) };
+      // Barely any smaller means the mesh is out of collapses within the error budget
+      if (simplified.indices.empty() || static_cast<float>(simplified.indices.size()) > static_cast<float>(previous.size()) * 0.9f) {
+        break;
+      }
+      // Each level is measured against the one before, summing keeps the bound conservative
+      errors.push_back(errors.back() + simplified.error * extent);
+      levels.push_back(std::move(simplified.indices));
+    }
+
+    mesh.indices.clear();
+    mesh.lods.clear();
+    // Built against the old order, they're rebuilt below when wanted
+    mesh.meshlets = {};
+    for (std::size_t level{ 0 }; level < levels.size(); ++level) {
+      auto& indices{ levels[level] };
+      if (info.vertex_cache) {
+        indices = optimize_vertex_cache(indices, vertex_count);
+      }
+      if (info.overdraw) {
+        indices = optimize_overdraw(indices, mesh.positions);
+      }
+      mesh.lods.push_back(MeshLod{
+        .index_offset = static_cast<u32>(mesh.indices.size()),
+        .index_count = static_cast<u32>(indices.size()),
+        .error = errors[level],
+      });
+      mesh.indices.insert(mesh.indices.end(), indices.begin(), indices.end());
+      report.lod_triangles.push_back(static_cast<u32>(indices.size() / 3));
+    }
+    // LOD 0 comes first, so its vertices end up in the order it reads them
+    if (info.vertex_fetch) {
+      optimize_vertex_fetch(mesh);
+    }
+    if (info.meshlets) {
+      mesh.meshlets = build_meshlets(std::span{ mesh.indices }.first(mesh.lods[0].index_count), mesh.positions);
+      report.meshlet_count = static_cast<u32>(mesh.meshlets.meshlets.size());
+    }
+
+    report.after = analyze_vertex_cache(
+      std::span{ mesh.indices }.first(mesh.lods[0].index_count),
+      static_cast<u32>(mesh.positions.size())
+    );
+    return report;
+  }
+}
@@ -0,0 +1,93 @@
+//
+// Mesh processing run after import (or on meshes built at runtime) so the GPU does less work drawing them:
+//
+//   vertex cache   triangles reordered so recently transformed vertices get reused (Forsyth)
+//   overdraw       cache friendly clusters of those triangles sorted to draw outward facing ones first (Sander)
+//   vertex fetch   vertices renumbered in the order the indices first touch them, so fetches stream linearly
+//   LODs           progressively simplified index buffers over the same vertices (Garland-Heckbert quadrics)
+//   meshlets       LOD 0 split into cullable clusters (see meshlet.hpp)
+//
+// ACMR is the average number of vertices transformed per triangle (0.5 is the ideal for big regular grids,
+// 3 the worst), ATVR the same per unique vertex (1 is ideal).
+//
+// Sources:
+// https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+// https://gfx.cs.princeton.edu/pubs/Sander_2007_%3ETR/tipsy.pdf
+// https://www.cs.cmu.edu/~garland/Papers/quadrics.pdf
+// https://github.com/zeux/meshoptimizer
+//
+
+#pragma once
+
+#include "mesh.hpp"
+
+namespace fx {
+  struct VertexCacheStats {
+    u32 vertices_transformed{ 0 };
+    float acmr{ 0.f };
+    float atvr{ 0.f };
+    // Vertex bytes fetched through a cache of 64 byte lines against the size of the vertices referenced,
+    // 1 is ideal
+    float overfetch{ 0.f };
+  };
+
+  // Simulates a FIFO post transform cache, the common case on current hardware
+  [[nodiscard]] auto analyze_vertex_cache(
+    std::span<const u32> indices,
+    u32 vertex_count,
+    u32 cache_size = 16,
+    u32 vertex_size = sizeof(PackedVertex)
+  ) -> VertexCacheStats;
+
+  [[nodiscard]] auto optimize_vertex_cache(std::span<const u32> indices, u32 vertex_count) -> std::vector<u32>;
+  // Expects indices already optimized for the vertex cache. A higher threshold gives up more cache efficiency
+  // for smaller clusters that sort better.
+  [[nodiscard]] auto optimize_overdraw(
+    std::span<const u32> indices,
+    std::span<const vec3> positions,
+    float threshold = 1.05f
+  ) -> std::vector<u32>;
+  // Renumbers every attribute and index (LODs and meshlets included) in first use order, unreferenced vertices
+  // are dropped
+  void optimize_vertex_fetch(MeshData& mesh);
+
+  struct SimplifyResult {
+    std::vector<u32> indices;
+    // Deviation from the input surface, relative to the mesh's extent
+    float error{ 0.f };
+  };
+
+  // Collapses edges until at most target_index_count indices are left or the next collapse would deviate more
+  // than target_error (relative to the mesh's extent). Vertices are never moved or created, so the result
+  // indexes the same vertex buffer. Open borders and vertices split by attribute seams are preserved.
+  [[nodiscard]] auto simplify(
+    std::span<const u32> indices,
+    std::span<const vec3> positions,
+    u32 target_index_count,
+    float target_error
+  ) -> SimplifyResult;
+
+  struct MeshOptimizeInfo {
+    bool vertex_cache{ true };
+    bool overdraw{ true };
+    bool vertex_fetch{ true };
+    bool meshlets{ true };
+    // Including the full detail one, generation stops early once a mesh won't simplify any further
+    u32 lod_count{ 4 };
+    // Triangle count of each LOD against the one before it
+    float lod_ratio{ 0.5f };
+    // Relative to the mesh's extent, per LOD step
+    float lod_max_error{ 0.02f };
+  };
+
+  struct MeshOptimizeReport {
+    VertexCacheStats before;
+    VertexCacheStats after;
+    // Triangles per generated LOD, finest first
+    std::vector<u32> lod_triangles;
+    u32 meshlet_count{ 0 };
+  };
+
+  // Runs the whole pipeline in place, LOD 0 is the mesh's first LOD (or all of its indices)
+  auto optimize_mesh(MeshData& mesh, const MeshOptimizeInfo& info = {}) -> MeshOptimizeReport;
+}
@@ -0,0 +1,300 @@
+#include "meshlet.hpp"
+
+namespace fx {
+  namespace {
+    constexpr u8 not_in_meshlet{ 0xFF };
+    constexpr u32 no_triangle{ std::numeric_limits<u32>::max() };
+    // How much a triangle facing away from the meshlet's average normal counts against it, in new vertices. Below
+    // 0.5 so it only ever breaks ties between triangles adding the same number of vertices.
+    constexpr float cone_weight{ 0.25f };
+    // Pulls growth toward the meshlet's center so it fills up with triangles before running out of vertices,
+    // kept small since rounder meshlets also tend to have wider normal cones
+    constexpr float compact_weight{ 0.05f };
+
+    [[nodiscard]] auto subtract(const vec3& a, const vec3& b) -> vec3
+    {
+      return vec3{ a.x - b.x, a.y - b.y, a.z - b.z };
+    }
+
+    [[nodiscard]] auto cross(const vec3& a, const vec3& b) -> vec3
+    {
+      return vec3{ a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+    }
+
+    [[nodiscard]] auto dot(const vec3& a, const vec3& b) -> float
+    {
+      return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+
+    [[nodiscard]] auto length(const vec3& v) -> float
+    {
+      return std::sqrt(dot(v, v));
+    }
+
+    [[nodiscard]] auto normalize(const vec3& v) -> vec3
+    {
+      const auto l{ length(v) };
+      return l > 0.f ? vec3{ v.x / l, v.y / l, v.z / l } : vec3{ 0.f, 0.f, 0.f };
+    }
+
+    [[nodiscard]] auto face_normal(const vec3& a, const vec3& b, const vec3& c) -> vec3
+    {
+      return cross(subtract(b, a), subtract(c, a));
+    }
+
+    [[nodiscard]] auto to_array(const vec3& v) -> std::array<float, 3>
+    {
+      return { v.x, v.y, v.z };
+    }
+  }
+
+  auto build_meshlets(
+    const std::span<const u32> indices,
+    const std::span<const vec3> positions,
+    u32 max_vertices,
+    u32 max_triangles
+  ) -> MeshletData
+  {
+    max_vertices = std::clamp(max_vertices, 3U, 255U);
+    max_triangles = std::max(max_triangles, 1U);
+    const auto vertex_count{ static_cast<u32>(positions.size()) };
+    const auto triangle_count{ static_cast<u32>(indices.size() / 3) };
+
+    MeshletData data;
+    if (triangle_count == 0) {
+      return data;
+    }
+
+    // Triangles per vertex, packed
+    std::vector<u32> offsets(vertex_count + 1, 0);
+    for (u32 i{ 0 }; i < triangle_count * 3; ++i) {
+      ++offsets[indices[i] + 1];
+    }
+    std::inclusive_scan(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<u32> adjacency(static_cast<std::size_t>(triangle_count) * 3);
+    {
+      auto cursor{ offsets };
+      for (u32 i{ 0 }; i < triangle_count * 3; ++i) {
+        adjacency[cursor[indices[i]]++] = i / 3;
+      }
+    }
+
+    std::vector<vec3> normals(triangle_count);
+    for (u32 t{ 0 }; t < triangle_count; ++t) {
+      normals[t] = normalize(face_normal(positions[indices[t * 3]], positions[indices[t * 3 + 1]], positions[indices[t * 3 + 2]]));
+    }
+
+    std::vector<bool> used(triangle_count, false);
+    std::vector<u8> local(vertex_count, not_in_meshlet);
+    Meshlet meshlet{};
+    vec3 normal_sum{ 0.f, 0.f, 0.f };
+    vec3 position_sum{ 0.f, 0.f, 0.f };
+
+    const auto new_vertices{ [&](const u32 triangle) {
+      u32 count{ 0 };
+      for (u32 corner{ 0 }; corner < 3; ++corner) {
+        const auto vertex{ indices[triangle * 3 + corner] };
+        // Degenerate triangles name a vertex twice, it's only new once
+        const auto repeated{ (corner > 0 && indices[triangle * 3] == vertex) || (corner > 1 && indices[triangle * 3 + 1] == vertex) };
+        count += local[vertex] == not_in_meshlet && !repeated ? 1 : 0;
+      }
+      return count;
+    } };
+
+    const auto flush{ [&] {
+      if (meshlet.triangle_count == 0) {
+        return;
+      }
+      for (u32 i{ 0 }; i < meshlet.vertex_count; ++i) {
+        local[data.vertices[meshlet.vertex_offset + i]] = not_in_meshlet;
+      }
+      data.bounds.push_back(compute_meshlet_bounds(meshlet, data.vertices, data.triangles, positions));
+      data.meshlets.push_back(meshlet);
+      meshlet = Meshlet{
+        .vertex_offset = static_cast<u32>(data.vertices.size()),
+        .triangle_offset = static_cast<u32>(data.triangles.size() / 3),
+      };
+      normal_sum = vec3{ 0.f, 0.f, 0.f };
+      position_sum = vec3{ 0.f, 0.f, 0.f };
+    } };
+
+    u32 seed{ 0 };
+    u32 emitted{ 0 };
+    while (emitted < triangle_count) {
+      auto best{ no_triangle };
+      auto best_score{ std::numeric_limits<float>::max() };
+      const auto axis{ normalize(normal_sum) };
+      const auto count{ static_cast<float>(std::max(meshlet.vertex_count, 1U)) };
+      const vec3 center{ position_sum.x / count, position_sum.y / count, position_sum.z / count };
+      auto spread{ 0.f };
+      for (u32 i{ 0 }; i < meshlet.vertex_count; ++i) {
+        spread = std::max(spread, length(subtract(positions[data.vertices[meshlet.vertex_offset + i]], center)));
+      }
+      for (u32 i{ 0 }; i < meshlet.vertex_count; ++i) {
+        const auto vertex{ data.vertices[meshlet.vertex_offset + i] };
+        for (auto entry{ offsets[vertex] }; entry < offsets[vertex + 1]; ++entry) {
+          const auto triangle{ adjacency[entry] };
+          if (used[triangle]) {
+            continue;
+          }
+          const auto extra{ new_vertices(triangle) };
+          if (meshlet.vertex_count + extra > max_vertices) {
+            continue;
+          }
+          const auto& a{ positions[indices[triangle * 3]] };
+          const auto& b{ positions[indices[triangle * 3 + 1]] };
+          const auto& c{ positions[indices[triangle * 3 + 2]] };
+          const vec3 centroid{ (a.x + b.x + c.x) / 3.f, (a.y + b.y + c.y) / 3.f, (a.z + b.z + c.z) / 3.f };
+          const auto distance{ spread > 0.f ? length(subtract(centroid, center)) / spread : 0.f };
+          const auto score{ static_cast<float>(extra) + cone_weight * (1.f - dot(normals[triangle], axis)) + compact_weight * distance };
+          if (score < best_score) {
+            best = triangle;
+            best_score = score;
+          }
+        }
+      }
+
+      if (best == no_triangle) {
+        // Nothing connected fits (or the meshlet is empty), continue with the next triangle in index order
+        while (used[seed]) {
+          ++seed;
+        }
+        if (meshlet.vertex_count + new_vertices(seed) > max_vertices) {
+          flush();
+          continue;
+        }
+        best = seed;
+      }
+
+      for (u32 corner{ 0 }; corner < 3; ++corner) {
+        const auto vertex{ indices[best * 3 + corner] };
+        if (local[vertex] == not_in_meshlet) {
+          local[vertex] = static_cast<u8>(meshlet.vertex_count++);
+          data.vertices.push_back(vertex);
+          const auto& p{ positions[vertex] };
+          position_sum = vec3{ position_sum.x + p.x, position_sum.y + p.y, position_sum.z + p.z };
+        }
+        data.triangles.push_back(local[vertex]);
+      }
+      used[best] = true;
+      ++emitted;
+      ++meshlet.triangle_count;
+      const auto& normal{ normals[best] };
+      normal_sum = vec3{ normal_sum.x + normal.x, normal_sum.y + normal.y, normal_sum.z + normal.z };
+      if (meshlet.triangle_count == max_triangles) {
+        flush();
+      }
+    }
+    flush();
+    return data;
+  }
+
+  auto compute_meshlet_bounds(
+    const Meshlet& meshlet,
+    const std::span<const u32> vertices,
+    const std::span<const u8> triangles,
+    const std::span<const vec3> positions
+  ) -> MeshletBounds
+  {
+    const auto meshlet_vertices{ vertices.subspan(meshlet.vertex_offset, meshlet.vertex_count) };
+    const auto meshlet_triangles{ triangles.subspan(static_cast<std::size_t>(meshlet.triangle_offset) * 3, static_cast<std::size_t>(meshlet.triangle_count) * 3) };
+    const auto position{ [&](const u8 local_index) -> const vec3& { return positions[meshlet_vertices[local_index]]; } };
+
+    // Ritter's sphere: start from an approximately widest pair of points, then grow to cover the rest
+    const auto farthest_from{ [&](const vec3& from) {
+      u32 farthest{ 0 };
+      float distance{ -1.f };
+      for (u32 i{ 0 }; i < meshlet.vertex_count; ++i) {
+        const auto d{ length(subtract(positions[meshlet_vertices[i]], from)) };
+        if (d > distance) {
+          farthest = i;
+          distance = d;
+        }
+      }
+      return positions[meshlet_vertices[farthest]];
+    } };
+    const auto a{ farthest_from(positions[meshlet_vertices[0]]) };
+    const auto b{ farthest_from(a) };
+    vec3 center{ (a.x + b.x) * 0.5f, (a.y + b.y) * 0.5f, (a.z + b.z) * 0.5f };
+    auto radius{ length(subtract(b, a)) * 0.5f };
+    for (const auto vertex: meshlet_vertices) {
+      const auto offset{ subtract(positions[vertex], center) };
+      const auto distance{ length(offset) };
+      if (distance > radius) {
+        const auto grown{ (radius + distance) * 0.5f };
+        const auto shift{ (grown - radius) / distance };
+        center = vec3{ center.x + offset.x * shift, center.y + offset.y * shift, center.z + offset.z * shift };
+        radius = grown;
+      }
+    }
+
+    MeshletBounds bounds{
+      .center = to_array(center),
+      .radius = radius,
+      .cone_axis = { 0.f, 0.f, 0.f },
+      .cone_cutoff = 1.f,
+      .cone_apex = to_array(center),
+      .reserved = 0.f,
+    };
+
+    std::vector<vec3> normals;
+    normals.reserve(meshlet.triangle_count);
+    vec3 axis{ 0.f, 0.f, 0.f };
+    for (std::size_t i{ 0 }; i < meshlet_triangles.size(); i += 3) {
+      const auto normal{ normalize(face_normal(position(meshlet_triangles[i]), position(meshlet_triangles[i + 1]), position(meshlet_triangles[i + 2]))) };
+      if (length(normal) == 0.f) {
+        continue;
+      }
+      normals.push_back(normal);
+      axis = vec3{ axis.x + normal.x, axis.y + normal.y, axis.z + normal.z };
+    }
+    axis = normalize(axis);
+    if (normals.empty() || length(axis) == 0.f) {
+      return bounds;
+    }
+    auto min_dot{ 1.f };
+    for (const auto& normal: normals) {
+      min_dot = std::min(min_dot, dot(normal, axis));
+    }
+    // Normals spreading 90 degrees or more from the axis, some triangle faces every viewpoint
+    if (min_dot <= 0.f) {
+      return bounds;
+    }
+
+    // Slide the apex back along the axis until it's behind every triangle's plane, so the test holds for any
+    // viewpoint and not just distant ones
+    auto max_t{ 0.f };
+    std::size_t normal{ 0 };
+    for (std::size_t i{ 0 }; i < meshlet_triangles.size(); i += 3) {
+      const auto& corner{ position(meshlet_triangles[i]) };
+      const auto face{ face_normal(corner, position(meshlet_triangles[i + 1]), position(meshlet_triangles[i + 2])) };
+      if (length(face) == 0.f) {
+        continue;
+      }
+      const auto& n{ normals[normal++] };
+      max_t = std::max(max_t, dot(subtract(center, corner), n) / dot(axis, n));
+    }
+    bounds.cone_axis = to_array(axis);
+    bounds.cone_apex = to_array(vec3{ center.x - axis.x * max_t, center.y - axis.y * max_t, center.z - axis.z * max_t });
+    // The normals span acos(min_dot) around the axis, the viewpoints that see none of them span 90 degrees less
+    // on either side, mirrored: cos(90 - acos(min_dot)) = sin(acos(min_dot))
+    bounds.cone_cutoff = std::sqrt(1.f - min_dot * min_dot);
+    return bounds;
+  }
+
+  auto meshlet_index_buffer(
+    const std::span<const Meshlet> meshlets,
+    const std::span<const u32> vertices,
+    const std::span<const u8> triangles
+  ) -> std::vector<u32>
+  {
+    std::vector<u32> indices(triangles.size());
+    for (const auto& meshlet: meshlets) {
+      for (u32 i{ 0 }; i < meshlet.triangle_count * 3; ++i) {
+        const auto corner{ static_cast<std::size_t>(meshlet.triangle_offset) * 3 + i };
+        indices[corner] = vertices[meshlet.vertex_offset + triangles[corner]];
+      }
+    }
+    return indices;
+  }
+}
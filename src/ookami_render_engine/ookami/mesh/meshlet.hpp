@@ -0,0 +1,78 @@
+//
+// Meshlets: small clusters of at most 64 vertices and 124 triangles, each with a bounding sphere and a normal
+// cone so whole clusters can be culled (off screen or facing away) before anything is drawn. A meshlet's
+// vertices are indices into the mesh's vertex block and its triangles are byte sized indices into those, the
+// same layout mesh shaders consume, and meshlet_index_buffer() flattens them back into a regular index buffer
+// for indirect draws.
+//
+// Sources:
+// https://developer.nvidia.com/blog/introduction-turing-mesh-shaders/
+// https://github.com/zeux/meshoptimizer
+//
+
+#pragma once
+
+namespace fx {
+  struct Meshlet {
+    // Into MeshletData::vertices
+    u32 vertex_offset;
+    // Into MeshletData::triangles, in triangles (three bytes each)
+    u32 triangle_offset;
+    u32 vertex_count;
+    u32 triangle_count;
+  };
+
+  static_assert(sizeof(Meshlet) == 16, "Meshlet is the on-disk and GPU layout");
+
+  // Object space, laid out for std430 (see res/foxy/shaders/meshlet_cull)
+  struct MeshletBounds {
+    std::array<float, 3> center;
+    float radius;
+    // The cluster faces away from every viewpoint where dot(normalize(cone_apex - eye), cone_axis) >= cone_cutoff.
+    // A cutoff of 1 never culls, for clusters whose normals spread too far.
+    std::array<float, 3> cone_axis;
+    float cone_cutoff;
+    std::array<float, 3> cone_apex;
+    float reserved;
+  };
+
+  static_assert(sizeof(MeshletBounds) == 48, "MeshletBounds is the on-disk and GPU layout");
+
+  struct MeshletData {
+    std::vector<Meshlet> meshlets;
+    // One per meshlet
+    std::vector<MeshletBounds> bounds;
+    std::vector<u32> vertices;
+    std::vector<u8> triangles;
+  };
+
+  namespace meshlet_limits {
+    inline constexpr u32 max_vertices{ 64 };
+    // 124 * 3 bytes of triangles keeps each meshlet's index data a multiple of 4 bytes
+    inline constexpr u32 max_triangles{ 124 };
+  }
+
+  // Grows each meshlet from triangles adjacent to it, preferring ones that add no new vertices and then ones
+  // facing the same way, so the normal cones stay tight. Expects indices already optimized for the vertex cache,
+  // new meshlets are seeded in index order. max_vertices is capped at 255.
+  [[nodiscard]] auto build_meshlets(
+    std::span<const u32> indices,
+    std::span<const vec3> positions,
+    u32 max_vertices = meshlet_limits::max_vertices,
+    u32 max_triangles = meshlet_limits::max_triangles
+  ) -> MeshletData;
+
+  [[nodiscard]] auto compute_meshlet_bounds(
+    const Meshlet& meshlet,
+    std::span<const u32> vertices,
+    std::span<const u8> triangles,
+    std::span<const vec3> positions
+  ) -> MeshletBounds;
+
+  // Meshlet i's triangles start at meshlets[i].triangle_offset * 3
+  [[nodiscard]] auto meshlet_index_buffer(
+    std::span<const Meshlet> meshlets,
+    std::span<const u32> vertices,
+    std::span<const u8> triangles
+  ) -> std::vector<u32>;
+}
@@ -0,0 +1,190 @@
+#include "obj_importer.hpp"
+
+namespace fx {
+  namespace {
+    [[nodiscard]] auto next_token(std::string_view& line) -> std::string_view
+    {
+      const auto start{ line.find_first_not_of(" \t\r") };
+      if (start == std::string_view::npos) {
+        line = {};
+        return {};
+      }
+      line.remove_prefix(start);
+      const auto end{ std::min(line.find_first_of(" \t\r"), line.size()) };
+      const auto token{ line.substr(0, end) };
+      line.remove_prefix(end);
+      return token;
+    }
+
+    [[nodiscard]] auto parse_float(const std::string_view token) -> std::optional<float>
+    {
+      float value{};
+      const auto [end, error]{ std::from_chars(token.data(), token.data() + token.size(), value) };
+      if (error != std::errc{} || end != token.data() + token.size()) {
+        return std::nullopt;
+      }
+      return value;
+    }
+
+    // OBJ indices are 1 based, negative ones count back from the newest element
+    [[nodiscard]] auto parse_index(const std::string_view token, const std::size_t count) -> std::optional<u32>
+    {
+      i64 value{};
+      const auto [end, error]{ std::from_chars(token.data(), token.data() + token.size(), value) };
+      if (error != std::errc{} || end != token.data() + token.size() || value == 0) {
+        return std::nullopt;
+      }
+      const auto resolved{ value > 0 ? value - 1 : static_cast<i64>(count) + value };
+      if (resolved < 0 || resolved >= static_cast<i64>(count)) {
+        return std::nullopt;
+      }
+      return static_cast<u32>(resolved);
+    }
+
+    [[nodiscard]] auto parse_floats(std::string_view& line, std::span<float> out) -> u32
+    {
+      u32 parsed{ 0 };
+      for (auto& value: out) {
+        const auto token{ next_token(line) };
+        const auto number{ token.empty() ? std::nullopt : parse_float(token) };
+        if (!number) {
+          break;
+        }
+        value = *number;
+        ++parsed;
+      }
+      return parsed;
+    }
+
+    [[nodiscard]] auto cross(const vec3& a, const vec3& b) -> vec3
+    {
+      return vec3{ a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+    }
+
+    [[nodiscard]] auto subtract(const vec3& a, const vec3& b) -> vec3
+    {
+      return vec3{ a.x - b.x, a.y - b.y, a.z - b.z };
+    }
+
+    // Area weighted: the cross product's length is twice the triangle's area
+    void generate_normals(MeshData& mesh)
+    {
+      mesh.normals.assign(mesh.positions.size(), vec3{ 0.f, 0.f, 0.f });
+      for (std::size_t i{ 0 }; i + 2 < mesh.indices.size(); i += 3) {
+        const auto a{ mesh.indices[i] };
+        const auto b{ mesh.indices[i + 1] };
+        const auto c{ mesh.indices[i + 2] };
+        const auto face{ cross(subtract(mesh.positions[b], mesh.positions[a]), subtract(mesh.positions[c], mesh.positions[a])) };
+        for (const auto vertex: { a, b, c }) {
+          auto& normal{ mesh.normals[vertex] };
+          normal = vec3{ normal.x + face.x, normal.y + face.y, normal.z + face.z };
+        }
+      }
+      for (auto& normal: mesh.normals) {
+        const auto length{ std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z) };
+        normal = length > 0.f ? vec3{ normal.x / length, normal.y / length, normal.z / length } : vec3{ 0.f, 0.f, 1.f };
+      }
+    }
+  }
+
+  auto import_obj(const std::string_view source) -> std::optional<MeshData>
+  {
+    std::vector<vec3> positions;
+    std::vector<vec4> colors;
+    std::vector<vec3> normals;
+    bool any_colors{ false };
+
+    struct Corner {
+      u32 position;
+      std::optional<u32> normal;
+    };
+    std::vector<Corner> corners;
+    std::vector<Corner> face;
+
+    MeshData mesh;
+    u32 line_number{ 0 };
+    for (std::size_t begin{ 0 }; begin < source.size();) {
+      const auto end{ std::min(source.find('\n', begin), source.size()) };
+      auto line{ source.substr(begin, end - begin) };
+      begin = end + 1;
+      ++line_number;
+
+      const auto keyword{ next_token(line) };
+      if (keyword == "v") {
+        std::array<float, 6> values{ 0.f, 0.f, 0.f, 1.f, 1.f, 1.f };
+        const auto parsed{ parse_floats(line, values) };
+        if (parsed < 3) {
+          Log::error("OBJ line {}: vertex needs three coordinates", line_number);
+          return std::nullopt;
+        }
+        positions.push_back(vec3{ values[0], values[1], values[2] });
+        colors.push_back(vec4{ values[3], values[4], values[5], 1.f });
+        any_colors = any_colors || parsed >= 6;
+      } else if (keyword == "vn") {
+        std::array<float, 3> values{};
+        if (parse_floats(line, values) < 3) {
+          Log::error("OBJ line {}: normal needs three components", line_number);
+          return std::nullopt;
+        }
+        normals.push_back(vec3{ values[0], values[1], values[2] });
+      } else if (keyword == "f") {
+        face.clear();
+        for (auto token{ next_token(line) }; !token.empty(); token = next_token(line)) {
+          // v, v/vt, v/vt/vn, or v//vn
+          const auto first_slash{ token.find('/') };
+          const auto last_slash{ token.rfind('/') };
+          const auto position{ parse_index(token.substr(0, first_slash), positions.size()) };
+          std::optional<u32> normal{};
+          if (first_slash != std::string_view::npos && last_slash != first_slash) {
+            normal = parse_index(token.substr(last_slash + 1), normals.size());
+            if (!normal) {
+              Log::error("OBJ line {}: bad normal index in \"{}\"", line_number, token);
+              return std::nullopt;
+            }
+          }
+          if (!position) {
+            Log::error("OBJ line {}: bad vertex index in \"{}\"", line_number, token);
+            return std::nullopt;
+          }
+          face.push_back(Corner{ .position = *position, .normal = normal });
+        }
+        for (std::size_t i{ 2 }; i < face.size(); ++i) {
+          corners.push_back(face[0]);
+          corners.push_back(face[i - 1]);
+          corners.push_back(face[i]);
+        }
+      }
+    }
+
+    if (corners.empty()) {
+      Log::error("OBJ has no faces");
+      return std::nullopt;
+    }
+
+    // Weld corners that share both position and normal
+    const bool has_normals{ std::ranges::all_of(corners, [](const Corner& corner) { return corner.normal.has_value(); }) };
+    std::unordered_map<u64, u32> welded;
+    welded.reserve(corners.size());
+    mesh.indices.reserve(corners.size());
+    for (const auto& corner: corners) {
+      const auto normal{ has_normals ? *corner.normal : 0U };
+      const auto key{ static_cast<u64>(corner.position) << 32 | normal };
+      const auto [found, inserted]{ welded.try_emplace(key, static_cast<u32>(mesh.positions.size())) };
+      if (inserted) {
+        mesh.positions.push_back(positions[corner.position]);
+        if (has_normals) {
+          mesh.normals.push_back(normals[normal]);
+        }
+        if (any_colors) {
+          mesh.colors.push_back(colors[corner.position]);
+        }
+      }
+      mesh.indices.push_back(found->second);
+    }
+
+    if (!has_normals) {
+      generate_normals(mesh);
+    }
+    return mesh;
+  }
+}
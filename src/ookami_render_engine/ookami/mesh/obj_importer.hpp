@@ -0,0 +1,17 @@
+//
+// Wavefront OBJ importer. Faces are triangulated as fans, corners sharing a position and normal are welded
+// into one vertex, "v x y z r g b" vertex colors are picked up, and smooth normals are generated when the file
+// has none. Texture coordinates, materials, and groups are ignored.
+//
+// Sources:
+// https://paulbourke.net/dataformats/obj/
+//
+
+#pragma once
+
+#include "mesh.hpp"
+
+namespace fx {
+  // Nothing (and an error log) when the source is malformed or has no faces
+  [[nodiscard]] auto import_obj(std::string_view source) -> std::optional<MeshData>;
+}
@@ -1,33 +1,36 @@
 #include "render_engine.hpp"
+#include "render_world.hpp"
 
 #include "ookami/core/context.hpp"
 #include "ookami/core/shader.hpp"
 #include "ookami/core/low_level_renderer.hpp"
+#include "ookami/core/gpu_profiler.hpp"
 
 #include "vulkan/static.hpp"
 #include <inferno/window.hpp>
+#include <kitsune/profiler.hpp>
 
 namespace fx {
   class RenderEngine::Impl: types::SingleInstance<RenderEngine> {
   public:
-    explicit Impl(const shared<Window>& window):
-      context_{ std::make_shared<ookami::Context>(**window) }
+    Impl(const shared<Window>& window, const ShaderSourceReader& read_shader_source):
+      context_{ std::make_shared<ookami::Context>(**window) },
+      read_shader_source_{ read_shader_source }
     {
-      std::shared_ptr fixed_value_shader{
-        context_->create_shader(
-          ShaderCreateInfo{
-            .vertex = true,
-            .fragment = true,
-            .shader_directory = "res/foxy/shaders/fixed_value"
-          }
-        )
-      };
-      
-      renderer_ = std::make_unique<LowLevelRenderer>(window, context_, fixed_value_shader, 2);
+      renderer_ = std::make_unique<LowLevelRenderer>(window, context_, create_default_shader(), 2);
       
       Log::trace("Ookami Render Engine ready.");
     }
     
+    Impl(const HeadlessCreateInfo& headless_info, const ShaderSourceReader& read_shader_source):
+      context_{ std::make_shared<ookami::Context>(nullptr) },
+      read_shader_source_{ read_shader_source }
+    {
+      renderer_ = std::make_unique<LowLevelRenderer>(context_, create_default_shader(), headless_info);
+      
+      Log::trace("Ookami Render Engine ready (headless {}x{}).", headless_info.width, headless_info.height);
+    }
+    
     ~Impl()
     {
       Log::trace("Destroying Ookami Render Engine...");
@@ -38,27 +41,88 @@ namespace fx {
     
     }
   
-    void draw_frame()
+    void draw_frame(const RenderWorld& world)
     {
-      renderer_->draw();
+      FOXY_PROFILE_SCOPE("draw_frame");
+      renderer_->draw(world);
+      
+      std::scoped_lock lock{ stats_mutex_ };
+      frame_stats_ = renderer_->frame_stats();
     }
   
     void wait_idle()
     {
       context_->logical_device().waitIdle();
     }
+    
+    void draw_frame()
+    {
+      draw_frame(empty_world_);
+    }
+    
+    [[nodiscard]] auto headless() const -> bool
+    {
+      return renderer_->headless();
+    }
+    
+    [[nodiscard]] auto read_frame() -> std::vector<u8>
+    {
+      return renderer_->read_frame();
+    }
+    
+    [[nodiscard]] auto frame_stats() const -> FrameStats
+    {
+      std::scoped_lock lock{ stats_mutex_ };
+      return frame_stats_;
+    }
+    
+    void dump_gpu_timings(const std::filesystem::path& path) const
+    {
+      std::ofstream file{ path };
+      if (!file) {
+        Log::error("Failed to open {} for GPU timings.", path.string());
+        return;
+      }
+      
+      if (path.extension() == ".json") {
+        renderer_->gpu_profiler().write_json(file);
+      } else {
+        renderer_->gpu_profiler().write_csv(file);
+      }
+    }
   
   private:
     shared<ookami::Context> context_;
+    const ShaderSourceReader read_shader_source_;
     unique<LowLevelRenderer> renderer_;
+    RenderWorld empty_world_{};
+    
+    // Copied after every frame so other threads can read stats while the render thread draws the next one
+    mutable std::mutex stats_mutex_;
+    FrameStats frame_stats_{};
+    
+    [[nodiscard]] auto create_default_shader() -> shared<Shader>
+    {
+      return context_->create_shader(
+        ShaderCreateInfo{
+          .vertex = true,
+          .fragment = true,
+          .shader_directory = "res/foxy/shaders/fixed_value",
+          .read_source = read_shader_source_,
+        }
+      );
+    }
   };
   
   //
   //  Renderer
   //
   
-  RenderEngine::RenderEngine(const shared<Window>& window):
-    p_impl_{ std::make_unique<Impl>(window) } {}
+  RenderEngine::RenderEngine(const shared<Window>& window, const ShaderSourceReader& read_shader_source):
+    p_impl_{ std::make_unique<Impl>(window, read_shader_source) } {}
+  
+  RenderEngine::RenderEngine(const HeadlessCreateInfo& headless_info, const ShaderSourceReader& read_shader_source):
+    p_impl_{ std::make_unique<Impl>(headless_info, read_shader_source) } {}
   
   RenderEngine::~RenderEngine() = default;
   
@@ -72,8 +136,33 @@ namespace fx {
     p_impl_->draw_frame();
   }
   
+  void RenderEngine::draw_frame(const RenderWorld& world)
+  {
+    p_impl_->draw_frame(world);
+  }
+  
   void RenderEngine::wait_idle()
   {
     p_impl_->wait_idle();
   }
+  
+  auto RenderEngine::headless() const -> bool
+  {
+    return p_impl_->headless();
+  }
+  
+  auto RenderEngine::read_frame() -> std::vector<u8>
+  {
+    return p_impl_->read_frame();
+  }
+  
+  auto RenderEngine::frame_stats() const -> FrameStats
+  {
+    return p_impl_->frame_stats();
+  }
+  
+  void RenderEngine::dump_gpu_timings(const std::filesystem::path& path) const
+  {
+    p_impl_->dump_gpu_timings(path);
+  }
 }
@@ -4,17 +4,44 @@
 
 #pragma once
 
+#include "ookami/core/frame_stats.hpp"
+#include "ookami/core/shader.hpp"
+
 namespace fx {
   class Window;
+  class RenderWorld;
+  
+  // Renders into offscreen images instead of a window, for benchmarks and CI machines without a display
+  struct HeadlessCreateInfo {
+    u32 width{ 1280 };
+    u32 height{ 720 };
+    // Copy every frame back into host memory so it can be fetched with read_frame()
+    bool readback{ true };
+    u32 frames_in_flight{ 2 };
+  };
   
   class RenderEngine {
   public:
-    explicit RenderEngine(const shared<Window>& window);
+    // Shader sources are read straight off the disk unless a reader is given (e.g. the app's Vfs)
+    explicit RenderEngine(const shared<Window>& window, const ShaderSourceReader& read_shader_source = {});
+    explicit RenderEngine(const HeadlessCreateInfo& headless_info, const ShaderSourceReader& read_shader_source = {});
     ~RenderEngine();
     
     void submit();
+    // Draws an empty world
     void draw_frame();
+    // The world must stay untouched by other threads until this returns
+    void draw_frame(const RenderWorld& world);
     void wait_idle();
+    
+    [[nodiscard]] auto headless() const -> bool;
+    // Tightly packed RGBA8 pixels of the most recent frame, waits for it to finish if it is still in flight
+    [[nodiscard]] auto read_frame() -> std::vector<u8>;
+    // Timings of the most recent frame, with the CPU time each render graph pass took to record. Safe to call
+    // from any thread.
+    [[nodiscard]] auto frame_stats() const -> FrameStats;
+    // Writes the latest GPU timing tree to a file, as JSON if the extension is .json and CSV otherwise
+    void dump_gpu_timings(const std::filesystem::path& path) const;
 
   private:
     class Impl;
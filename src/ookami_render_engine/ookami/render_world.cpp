@@ -0,0 +1,69 @@
+#include "render_world.hpp"
+
+namespace fx {
+  namespace {
+    template<class T>
+    void append_column(std::vector<T>& destination, const std::span<const T> source)
+    {
+      static_assert(std::is_trivially_copyable_v<T>, "Render world columns are copied with memcpy");
+      if (source.empty()) {
+        return;
+      }
+      const auto offset{ destination.size() };
+      destination.resize(offset + source.size());
+      std::memcpy(destination.data() + offset, source.data(), source.size_bytes());
+    }
+  }
+
+  void RenderWorld::clear()
+  {
+    transforms_.clear();
+    meshes_.clear();
+    camera_ = {};
+  }
+
+  void RenderWorld::set_frame(const u64 frame)
+  {
+    frame_ = frame;
+  }
+
+  void RenderWorld::set_camera(const CameraData& camera)
+  {
+    camera_ = camera;
+  }
+
+  void RenderWorld::append_instances(const std::span<const mat4> transforms, const std::span<const MeshHandle> meshes)
+  {
+    if (transforms.size() != meshes.size()) {
+      Log::error("Render world instance columns don't match ({} transforms, {} meshes).", transforms.size(), meshes.size());
+      return;
+    }
+    append_column(transforms_, transforms);
+    append_column(meshes_, meshes);
+  }
+
+  auto RenderWorld::frame() const -> u64
+  {
+    return frame_;
+  }
+
+  auto RenderWorld::camera() const -> const CameraData&
+  {
+    return camera_;
+  }
+
+  auto RenderWorld::transforms() const -> std::span<const mat4>
+  {
+    return transforms_;
+  }
+
+  auto RenderWorld::meshes() const -> std::span<const MeshHandle>
+  {
+    return meshes_;
+  }
+
+  auto RenderWorld::instance_count() const -> u32
+  {
+    return static_cast<u32>(transforms_.size());
+  }
+}
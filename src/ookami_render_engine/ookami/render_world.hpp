@@ -0,0 +1,41 @@
+//
+// Compact, render-only copy of the scene. The game thread fills one during the Extract stage and the render
+// thread consumes it afterwards, so rendering never has to touch live game state.
+//
+
+#pragma once
+
+namespace fx {
+  using MeshHandle = u32;
+
+  struct CameraData {
+    mat4 view{ 1.f };
+    mat4 projection{ 1.f };
+    mat4 view_projection{ 1.f };
+  };
+
+  class RenderWorld {
+  public:
+    RenderWorld() = default;
+    ~RenderWorld() = default;
+
+    // Keeps capacity, so once the scene size settles extraction stops allocating
+    void clear();
+    void set_frame(u64 frame);
+    void set_camera(const CameraData& camera);
+    // Bulk copies whole component columns. Transforms and meshes are paired by index.
+    void append_instances(std::span<const mat4> transforms, std::span<const MeshHandle> meshes);
+
+    [[nodiscard]] auto frame() const -> u64;
+    [[nodiscard]] auto camera() const -> const CameraData&;
+    [[nodiscard]] auto transforms() const -> std::span<const mat4>;
+    [[nodiscard]] auto meshes() const -> std::span<const MeshHandle>;
+    [[nodiscard]] auto instance_count() const -> u32;
+
+  private:
+    u64 frame_{ 0 };
+    CameraData camera_{};
+    std::vector<mat4> transforms_;
+    std::vector<MeshHandle> meshes_;
+  };
+}
@@ -0,0 +1,191 @@
+//
+// Measures what dispatching one App stage costs with each kind of callback list: the std::function vector
+// the old Event used, StageEvent's contiguous Delegates, and a BakedEvent fixed at compile time. Each stage
+// holds a mix of free functions, bound member functions, and capturing lambdas, like App registers. Heap
+// allocations made while registering are counted as well, since that's where std::function loses most.
+//
+//   foxy_delegate_bench [--iterations <count>]
+//
+
+#include "foxy/delegate.hpp"
+
+namespace {
+  std::atomic<std::size_t> allocation_count{ 0 };
+}
+
+auto operator new(const std::size_t size) -> void*
+{
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  if (void* pointer{ std::malloc(size == 0 ? 1 : size) }) {
+    return pointer;
+  }
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* pointer) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+  std::free(pointer);
+}
+
+namespace {
+  using Clock = std::chrono::steady_clock;
+
+  // Stand-ins for App and Time, the callbacks only need something to touch
+  struct BenchApp {
+    fx::u64 counter{ 0 };
+  };
+
+  struct BenchTime {
+    double delta{ 1. / 128. };
+  };
+
+  using Function = std::function<void(BenchApp&, const BenchTime&)>;
+  using Event = fx::StageEvent<BenchApp&, const BenchTime&>;
+
+  void free_callback(BenchApp& app, const BenchTime&)
+  {
+    ++app.counter;
+  }
+
+  struct System {
+    fx::u64 steps{ 0 };
+
+    void update(BenchApp& app, const BenchTime&)
+    {
+      ++steps;
+      app.counter += 2;
+    }
+  };
+
+  // A capture the size of App's FOXY_LAMBDA style callbacks that also hold a little state: too big for
+  // libstdc++'s std::function buffer, small enough for a Delegate
+  struct Captures {
+    fx::u64* a;
+    fx::u64* b;
+    fx::u64* c;
+  };
+
+  template<class Add>
+  void register_callbacks(const fx::u32 count, System& system, Captures captures, Add&& add)
+  {
+    for (fx::u32 i{ 0 }; i < count; ++i) {
+      switch (i % 3) {
+        case 0:
+          add(&free_callback);
+          break;
+        case 1:
+          add([&system](BenchApp& app, const BenchTime& time) { system.update(app, time); });
+          break;
+        default:
+          add([captures](BenchApp& app, const BenchTime&) {
+            ++*captures.a;
+            *captures.b += app.counter;
+            *captures.c ^= app.counter;
+          });
+          break;
+      }
+    }
+  }
+
+  // Best of a few runs, in nanoseconds per dispatch of the whole stage
+  template<class Dispatch>
+  [[nodiscard]] auto time_dispatch(const fx::u32 iterations, Dispatch&& dispatch) -> double
+  {
+    double best{ std::numeric_limits<double>::max() };
+    for (int run{ 0 }; run < 5; ++run) {
+      const auto start{ Clock::now() };
+      for (fx::u32 i{ 0 }; i < iterations; ++i) {
+        dispatch();
+        // Stops the compiler from folding inlined callbacks across iterations
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+      }
+      const auto ns{ std::chrono::duration<double, std::nano>(Clock::now() - start).count() };
+      best = std::min(best, ns / static_cast<double>(iterations));
+    }
+    return best;
+  }
+
+  System baked_system;
+
+  void baked_update(BenchApp& app, const BenchTime& time)
+  {
+    baked_system.update(app, time);
+  }
+}
+
+auto main(const int argc, char** argv) -> int
+{
+  fx::u32 iterations{ 2'000'000 };
+  for (int i{ 1 }; i < argc; ++i) {
+    const std::string_view arg{ argv[i] };
+    if (arg == "--iterations" && i + 1 < argc) {
+      iterations = static_cast<fx::u32>(std::max(std::atoi(argv[++i]), 1));
+    } else {
+      std::cerr << "usage: foxy_delegate_bench [--iterations <count>]\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  BenchApp app;
+  const BenchTime time;
+  System system;
+  fx::u64 a{ 0 }, b{ 0 }, c{ 0 };
+  const Captures captures{ &a, &b, &c };
+
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << "callbacks  std::function (ns, allocs)  StageEvent (ns, allocs)  per callback (ns)\n";
+  for (const fx::u32 count: { 1U, 4U, 10U, 32U }) {
+    std::vector<Function> functions;
+    functions.reserve(count);
+    auto allocations_before{ allocation_count.load() };
+    register_callbacks(count, system, captures, [&](auto&& callback) {
+      functions.emplace_back(std::forward<decltype(callback)>(callback));
+    });
+    const auto function_allocations{ allocation_count.load() - allocations_before };
+
+    Event event;
+    event.reserve(count);
+    allocations_before = allocation_count.load();
+    register_callbacks(count, system, captures, [&](auto&& callback) {
+      event.add_callback(std::forward<decltype(callback)>(callback));
+    });
+    const auto delegate_allocations{ allocation_count.load() - allocations_before };
+
+    const auto function_ns{ time_dispatch(iterations, [&] {
+      for (const auto& function: functions) {
+        function(app, time);
+      }
+    }) };
+    const auto delegate_ns{ time_dispatch(iterations, [&] { event(app, time); }) };
+
+    std::cout << std::setw(9) << count
+              << std::setw(17) << function_ns << ", " << std::setw(6) << function_allocations
+              << std::setw(19) << delegate_ns << ", " << std::setw(4) << delegate_allocations
+              << std::setw(12) << function_ns / count << " / " << delegate_ns / count << "\n";
+  }
+
+  // Four callbacks known at compile time, against the same four registered at runtime
+  using Baked = fx::BakedEvent<&free_callback, &baked_update, &free_callback, &baked_update>;
+  Event runtime;
+  runtime.add_callback(&free_callback);
+  runtime.add_callback(&baked_update);
+  runtime.add_callback(&free_callback);
+  runtime.add_callback(&baked_update);
+  // The same four baked into one stage callback, how App::add_baked_to_stage registers them
+  Event baked_stage;
+  baked_stage.add_callback(Baked::delegate<BenchApp&, const BenchTime&>());
+  const auto baked_ns{ time_dispatch(iterations, [&] { Baked::dispatch(app, time); }) };
+  const auto baked_stage_ns{ time_dispatch(iterations, [&] { baked_stage(app, time); }) };
+  const auto runtime_ns{ time_dispatch(iterations, [&] { runtime(app, time); }) };
+  std::cout << "4 fixed callbacks: BakedEvent " << baked_ns << " ns, as one stage callback " << baked_stage_ns
+            << " ns, StageEvent " << runtime_ns << " ns\n";
+
+  // Keeps the callbacks' side effects observable so none of the loops get optimized away
+  std::cout << "(checksum " << (app.counter ^ a ^ b ^ c ^ system.steps ^ baked_system.steps) << ")\n";
+  return EXIT_SUCCESS;
+}
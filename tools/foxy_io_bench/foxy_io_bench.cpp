@@ -0,0 +1,171 @@
+//
+// Cold cache read benchmark: writes a set of files, drops them from the page cache, then reads them all back
+// with plain blocking reads one after another, with AsyncIO's thread pool fallback, and with io_uring. The
+// cache is dropped again before every pass so each one actually goes to the disk. Dropping the cache needs
+// posix_fadvise, so elsewhere than Linux every pass after the first reads warm.
+//
+//   foxy_io_bench [--files <count>] [--size <KiB>] [--passes <count>] [--dir <path>]
+//
+
+#include "inu/async_io.hpp"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+  using Clock = std::chrono::steady_clock;
+
+  [[nodiscard]] auto evict(const std::vector<std::filesystem::path>& paths) -> bool
+  {
+    #if defined(__linux__)
+    for (const auto& path: paths) {
+      const auto fd{ open(path.c_str(), O_RDONLY) };
+      if (fd < 0) {
+        return false;
+      }
+      // Dirty pages can't be dropped, so make sure nothing is
+      fdatasync(fd);
+      const auto result{ posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) };
+      close(fd);
+      if (result != 0) {
+        return false;
+      }
+    }
+    return true;
+    #else
+    return false;
+    #endif
+  }
+
+  [[nodiscard]] auto read_blocking(const std::vector<std::filesystem::path>& paths) -> fx::u64
+  {
+    fx::u64 total{ 0 };
+    std::vector<char> buffer;
+    for (const auto& path: paths) {
+      std::ifstream file{ path, std::ios::binary | std::ios::ate };
+      buffer.resize(static_cast<std::size_t>(file.tellg()));
+      file.seekg(0);
+      file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+      total += static_cast<fx::u64>(file.gcount());
+    }
+    return total;
+  }
+
+  [[nodiscard]] auto read_async(fx::AsyncIO& io, const std::vector<std::filesystem::path>& paths) -> fx::u64
+  {
+    std::atomic<fx::u64> total{ 0 };
+    for (const auto& path: paths) {
+      io.read(path, [&total](const fx::AsyncIO::Result& result) {
+        if (!result.error) {
+          total.fetch_add(result.data.size(), std::memory_order_relaxed);
+        }
+      }, fx::JobSystem::Priority::Normal);
+    }
+    io.wait_idle();
+    return total.load();
+  }
+
+  struct Pass {
+    double ms{ 0. };
+    fx::u64 bytes{ 0 };
+  };
+
+  // Best of the passes, each one cold
+  template<class Read>
+  [[nodiscard]] auto measure(const std::vector<std::filesystem::path>& paths, const fx::u32 passes, Read&& read) -> Pass
+  {
+    Pass best{ .ms = std::numeric_limits<double>::max() };
+    for (fx::u32 i{ 0 }; i < passes; ++i) {
+      [[maybe_unused]] const auto evicted{ evict(paths) };
+      const auto start{ Clock::now() };
+      const auto bytes{ read() };
+      const auto ms{ std::chrono::duration<double, std::milli>(Clock::now() - start).count() };
+      if (ms < best.ms) {
+        best = Pass{ .ms = ms, .bytes = bytes };
+      }
+    }
+    return best;
+  }
+
+  void print(const char* label, const Pass& pass, const std::size_t file_count)
+  {
+    const auto mib{ static_cast<double>(pass.bytes) / (1024. * 1024.) };
+    std::cout << std::left << std::setw(22) << label << std::right
+              << std::setw(9) << pass.ms << " ms" << std::setw(10) << mib / (pass.ms / 1000.) << " MiB/s"
+              << std::setw(9) << pass.ms * 1000. / static_cast<double>(file_count) << " us/file\n";
+  }
+}
+
+auto main(const int argc, char** argv) -> int
+{
+  fx::u32 file_count{ 256 };
+  fx::u32 file_kib{ 256 };
+  fx::u32 passes{ 3 };
+  std::filesystem::path directory{ std::filesystem::temp_directory_path() / "foxy_io_bench" };
+  for (int i{ 1 }; i < argc; ++i) {
+    const std::string_view arg{ argv[i] };
+    const auto value{ [&] { return static_cast<fx::u32>(std::max(std::atoi(argv[++i]), 1)); } };
+    if (arg == "--files" && i + 1 < argc) {
+      file_count = value();
+    } else if (arg == "--size" && i + 1 < argc) {
+      file_kib = value();
+    } else if (arg == "--passes" && i + 1 < argc) {
+      passes = value();
+    } else if (arg == "--dir" && i + 1 < argc) {
+      directory = argv[++i];
+    } else {
+      std::cerr << "usage: foxy_io_bench [--files <count>] [--size <KiB>] [--passes <count>] [--dir <path>]\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::create_directories(directory, error);
+  if (error) {
+    std::cerr << "foxy_io_bench: can't create " << directory.string() << ": " << error.message() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  std::vector<std::filesystem::path> paths;
+  {
+    std::mt19937_64 random{ 7 };
+    std::vector<fx::u64> contents(file_kib * 1024 / sizeof(fx::u64));
+    for (fx::u32 i{ 0 }; i < file_count; ++i) {
+      for (auto& word: contents) {
+        word = random();
+      }
+      auto& path{ paths.emplace_back(directory / ("file" + std::to_string(i) + ".bin")) };
+      std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+      if (!file.write(reinterpret_cast<const char*>(contents.data()), static_cast<std::streamsize>(contents.size() * sizeof(fx::u64)))) {
+        std::cerr << "foxy_io_bench: can't write " << path.string() << "\n";
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  const bool cold{ evict(paths) };
+  std::cout << file_count << " files of " << file_kib << " KiB in " << directory.string() << ", best of " << passes
+            << (cold ? " cold passes\n" : " passes (couldn't drop the page cache, reads are warm)\n");
+  std::cout << std::fixed << std::setprecision(1);
+
+  print("blocking, sequential", measure(paths, passes, [&] { return read_blocking(paths); }), paths.size());
+
+  fx::JobSystem jobs{};
+  {
+    fx::AsyncIO io{ jobs, fx::AsyncIO::CreateInfo{ .fallback_threads = 4, .force_fallback = true } };
+    print("AsyncIO thread pool", measure(paths, passes, [&] { return read_async(io, paths); }), paths.size());
+  }
+  {
+    fx::AsyncIO io{ jobs };
+    if (io.backend() == fx::AsyncIO::Backend::IoUring) {
+      print("AsyncIO io_uring", measure(paths, passes, [&] { return read_async(io, paths); }), paths.size());
+    } else {
+      std::cout << "io_uring unavailable here\n";
+    }
+  }
+
+  std::filesystem::remove_all(directory, error);
+  return EXIT_SUCCESS;
+}
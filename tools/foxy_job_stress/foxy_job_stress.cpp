@@ -0,0 +1,170 @@
+//
+// Stress test for nested fork/join in the job system. Every job forks a batch of children and waits on them,
+// levels deep, from the main thread, from inside worker jobs, from inside main thread jobs, and entirely at
+// background priority (which only a few workers may run at once), with leaves that hop over to the main thread. A wait that blocked its worker instead of helping would deadlock well
+// before the deepest level; a watchdog turns that into a failure instead of a hang. Exits non-zero if any
+// round loses a job or times out.
+//
+//   foxy_job_stress [--depth <levels>] [--fanout <jobs>] [--rounds <count>] [--workers <count>]
+//
+
+#include "inu/job_system.hpp"
+
+namespace {
+  using Clock = std::chrono::steady_clock;
+
+  struct Config {
+    fx::u32 depth{ 6 };
+    fx::u32 fanout{ 4 };
+    fx::u32 rounds{ 20 };
+    fx::u32 workers{ 0 };
+  };
+
+  struct Stress {
+    fx::JobSystem& job_system;
+    const Config& config;
+    // Every child at background priority, so waiting jobs hold background slots their children need
+    bool background{ false };
+    std::atomic<fx::u64> leaves{ 0 };
+    std::atomic<fx::u64> main_thread_leaves{ 0 };
+
+    // fanout^depth leaves under every call
+    void fork(const fx::u32 depth, const fx::u32 path)
+    {
+      if (depth == 0) {
+        leaves.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+
+      fx::JobSystem::Counter counter{};
+      for (fx::u32 i{ 0 }; i < config.fanout; ++i) {
+        const auto child{ path * config.fanout + i };
+        if (depth == 1 && child % 17 == 0) {
+          // Some leaves have to run on the main thread, so whoever is waiting for them depends on it helping
+          job_system.submit_to_main_thread([this] {
+            leaves.fetch_add(1, std::memory_order_relaxed);
+            main_thread_leaves.fetch_add(1, std::memory_order_relaxed);
+          }, &counter);
+          continue;
+        }
+        const auto priority{
+          background ? fx::JobSystem::Priority::Background
+          : child % 3 == 0 ? fx::JobSystem::Priority::High : fx::JobSystem::Priority::Normal
+        };
+        job_system.submit([this, depth, child] { fork(depth - 1, child); }, &counter, priority);
+      }
+      job_system.wait(counter);
+    }
+
+    [[nodiscard]] auto expected(const fx::u32 forks) const -> fx::u64
+    {
+      fx::u64 count{ forks };
+      for (fx::u32 i{ 0 }; i < config.depth; ++i) {
+        count *= config.fanout;
+      }
+      return count;
+    }
+  };
+
+  [[nodiscard]] auto check(const char* scenario, const Stress& stress, const fx::u64 expected) -> bool
+  {
+    const auto leaves{ stress.leaves.load() };
+    if (leaves != expected) {
+      std::cerr << "foxy_job_stress: " << scenario << " finished " << leaves << " of " << expected << " leaves\n";
+      return false;
+    }
+    return true;
+  }
+}
+
+auto main(const int argc, char** argv) -> int
+{
+  Config config;
+  for (int i{ 1 }; i < argc; ++i) {
+    const std::string_view arg{ argv[i] };
+    const auto value{ [&] { return static_cast<fx::u32>(std::max(std::atoi(argv[++i]), 1)); } };
+    if (arg == "--depth" && i + 1 < argc) {
+      config.depth = value();
+    } else if (arg == "--fanout" && i + 1 < argc) {
+      config.fanout = std::max(value(), 2U);
+    } else if (arg == "--rounds" && i + 1 < argc) {
+      config.rounds = value();
+    } else if (arg == "--workers" && i + 1 < argc) {
+      config.workers = value();
+    } else {
+      std::cerr << "usage: foxy_job_stress [--depth <levels>] [--fanout <jobs>] [--rounds <count>] [--workers <count>]\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  fx::JobSystem job_system{ config.workers > 0 ? config.workers : fx::JobSystem::default_worker_count() };
+
+  // Anything still running after this is stuck, not slow
+  std::atomic done{ false };
+  std::jthread watchdog{ [&done](const std::stop_token& stop_token) {
+    const auto deadline{ Clock::now() + std::chrono::minutes{ 2 } };
+    while (!stop_token.stop_requested() && !done.load()) {
+      if (Clock::now() > deadline) {
+        std::cerr << "foxy_job_stress: timed out, nested waits deadlocked\n";
+        std::_Exit(EXIT_FAILURE);
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds{ 100 });
+    }
+  } };
+
+  std::cout << "depth " << config.depth << ", fanout " << config.fanout << ", " << job_system.worker_count() << " workers\n";
+  const auto start{ Clock::now() };
+  bool passed{ true };
+  fx::u64 main_thread_leaves{ 0 };
+  for (fx::u32 round{ 0 }; round < config.rounds && passed; ++round) {
+    // Forked straight from the main thread
+    {
+      Stress stress{ job_system, config };
+      stress.fork(config.depth, 0);
+      passed &= check("main thread fork", stress, stress.expected(1));
+      main_thread_leaves += stress.main_thread_leaves;
+    }
+
+    // Several roots forked from worker jobs at once, so workers wait inside waits inside waits
+    {
+      Stress stress{ job_system, config };
+      fx::JobSystem::Counter roots{};
+      for (fx::u32 i{ 0 }; i < config.fanout; ++i) {
+        job_system.submit([&stress, i] { stress.fork(stress.config.depth, i + 1); }, &roots);
+      }
+      job_system.wait(roots);
+      passed &= check("worker fork", stress, stress.expected(config.fanout));
+      main_thread_leaves += stress.main_thread_leaves;
+    }
+
+    // Forked from a main thread job, whose wait has to keep draining main thread jobs it is itself part of
+    {
+      Stress stress{ job_system, config };
+      fx::JobSystem::Counter root{};
+      job_system.submit_to_main_thread([&stress] { stress.fork(stress.config.depth, 0); }, &root);
+      job_system.wait(root);
+      passed &= check("main thread job fork", stress, stress.expected(1));
+      main_thread_leaves += stress.main_thread_leaves;
+    }
+
+    // Background roots forking background children, more roots than there are background slots
+    {
+      Stress stress{ job_system, config, true };
+      fx::JobSystem::Counter roots{};
+      for (fx::u32 i{ 0 }; i < config.fanout; ++i) {
+        job_system.submit([&stress, i] { stress.fork(stress.config.depth, i + 1); }, &roots, fx::JobSystem::Priority::Background);
+      }
+      job_system.wait(roots);
+      passed &= check("background fork", stress, stress.expected(config.fanout));
+      main_thread_leaves += stress.main_thread_leaves;
+    }
+  }
+  done = true;
+
+  if (!passed) {
+    return EXIT_FAILURE;
+  }
+  const auto seconds{ std::chrono::duration<double>(Clock::now() - start).count() };
+  std::cout << config.rounds << " rounds passed in " << seconds << " s (" << main_thread_leaves << " leaves ran on the main thread)\n";
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,86 @@
+//
+// Main thread CPU use with the window polled every iteration against blocking in wait_events, i.e. the before
+// and after of App::CreateInfo::wait_for_events. Runs App's main loop on a real window for each mode in turn
+// while a stand-in game thread drains input at 60 Hz and queues a main thread job once a second. Move the
+// mouse over the window or type into it to see the cost of waking up for OS events as well.
+//
+//   foxy_main_loop_bench [--seconds <count>]
+//
+
+#include "inferno/window.hpp"
+#include "inferno/input.hpp"
+#include "inu/job_system.hpp"
+#include "kitsune/cpu_time.hpp"
+
+namespace {
+  using Clock = std::chrono::steady_clock;
+
+  struct RunStats {
+    fx::kitsune::ThreadCpuMeter::Sample cpu;
+    fx::u64 iterations{ 0 };
+  };
+
+  [[nodiscard]] auto run(fx::Window& window, fx::JobSystem& job_system, const bool wait_for_events, const double seconds) -> RunStats
+  {
+    std::atomic running{ true };
+    std::jthread game_thread{ [&] {
+      fx::InputState input;
+      const auto end{ Clock::now() + std::chrono::duration<double>(seconds) };
+      for (fx::u32 frame{ 1 }; Clock::now() < end; ++frame) {
+        window.drain_input(input);
+        if (frame % 60 == 0) {
+          job_system.submit_to_main_thread([] {});
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds{ 16 });
+      }
+      running = false;
+      window.wake();
+    } };
+
+    // The same work as App's main loop update, minus the stage callbacks
+    const fx::kitsune::ThreadCpuMeter meter{};
+    RunStats stats;
+    while (running.load(std::memory_order_relaxed) && window.should_continue()) {
+      if (wait_for_events) {
+        window.wait_events(0.25);
+      } else {
+        window.poll_events();
+      }
+      job_system.run_main_thread_jobs();
+      ++stats.iterations;
+    }
+    stats.cpu = meter.sample();
+    return stats;
+  }
+}
+
+auto main(const int argc, char** argv) -> int
+{
+  double seconds{ 5. };
+  for (int i{ 1 }; i < argc; ++i) {
+    const std::string_view arg{ argv[i] };
+    if (arg == "--seconds" && i + 1 < argc) {
+      seconds = std::max(std::atof(argv[++i]), 0.1);
+    } else {
+      std::cerr << "usage: foxy_main_loop_bench [--seconds <count>]\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  fx::Window window{ fx::Window::CreateInfo{ .title = "foxy_main_loop_bench", .width = 640, .height = 360 } };
+  window.set_hidden(false);
+  fx::JobSystem job_system{};
+  job_system.set_main_thread_notifier([&window] { window.wake(); });
+
+  std::cout << std::fixed << std::setprecision(1);
+  for (const bool wait_for_events: { false, true }) {
+    const auto [cpu, iterations]{ run(window, job_system, wait_for_events, seconds) };
+    std::cout << (wait_for_events ? "waiting on events: " : "polling:           ")
+              << cpu.cpu_ms << " ms CPU over " << cpu.wall_ms << " ms wall, "
+              << cpu.utilization * 100. << "% of a core, " << iterations << " loop iterations\n";
+    if (!window.should_continue()) {
+      break;
+    }
+  }
+  return EXIT_SUCCESS;
+}
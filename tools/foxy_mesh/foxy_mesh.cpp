@@ -0,0 +1,202 @@
+//
+// Imports an OBJ into Foxy's compact mesh format (.fxm) and reports what it saved: size on disk and per
+// vertex against unpacked float attributes, the bandwidth that works out to when the mesh is streamed every
+// frame, the precision lost to quantization, and how long each form takes to load. Meshes are optimized for
+// the vertex cache, overdraw, and vertex fetch and get a chain of simplified LODs and meshlets unless told
+// otherwise, with ACMR/ATVR reported before and after, and how many meshlets cone culling rejects from random
+// viewpoints around the mesh.
+//
+//   foxy_mesh [--no-optimize] [--lods <count>] <input.obj> <output.fxm>
+//
+
+#include "ookami/mesh/obj_importer.hpp"
+#include "ookami/mesh/mesh_optimizer.hpp"
+#include "ookami/mesh/cluster_culling.hpp"
+
+namespace {
+  using Clock = std::chrono::steady_clock;
+
+  [[nodiscard]] auto elapsed_ms(const Clock::time_point start) -> double
+  {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  }
+
+  [[nodiscard]] auto length(const fx::vec3& v) -> float
+  {
+    return std::sqrt(v.x * v.x + v.y * v.y + v.z * v.z);
+  }
+
+  [[nodiscard]] auto read_text(const std::filesystem::path& path) -> std::optional<std::string>
+  {
+    std::ifstream file{ path, std::ios::binary };
+    if (!file) {
+      return std::nullopt;
+    }
+    return std::string{ std::istreambuf_iterator<char>{ file }, {} };
+  }
+
+  void print_cache_stats(const char* label, const fx::VertexCacheStats& stats)
+  {
+    std::cout << "  " << label << " ACMR " << stats.acmr << ", ATVR " << stats.atvr << ", overfetch " << stats.overfetch << "\n";
+  }
+
+  // Backface culling only, from viewpoints spread evenly over a sphere a few times the mesh's size
+  void print_meshlet_stats(const fx::MeshView& view, const float diagonal)
+  {
+    const auto meshlets{ view.meshlets() };
+    if (meshlets.empty()) {
+      return;
+    }
+    const auto triangles{ std::accumulate(meshlets.begin(), meshlets.end(), 0.0, [](const double sum, const fx::Meshlet& meshlet) {
+      return sum + meshlet.triangle_count;
+    }) };
+    const auto h{ view.header() };
+    const fx::vec3 center{
+      (h.bounds_min[0] + h.bounds_max[0]) * 0.5f,
+      (h.bounds_min[1] + h.bounds_max[1]) * 0.5f,
+      (h.bounds_min[2] + h.bounds_max[2]) * 0.5f,
+    };
+
+    constexpr fx::u32 viewpoints{ 256 };
+    fx::ClusterCullStats stats;
+    std::vector<fx::DrawIndexedIndirectCommand> draws;
+    std::size_t draw_count{ 0 };
+    for (fx::u32 i{ 0 }; i < viewpoints; ++i) {
+      // Fibonacci sphere
+      const auto y{ 1.f - 2.f * (static_cast<float>(i) + 0.5f) / viewpoints };
+      const auto r{ std::sqrt(1.f - y * y) };
+      const auto angle{ 2.39996323f * static_cast<float>(i) };
+      fx::ClusterCullInfo info{
+        .eye = fx::vec3{
+          center.x + std::cos(angle) * r * diagonal * 2.f,
+          center.y + y * diagonal * 2.f,
+          center.z + std::sin(angle) * r * diagonal * 2.f,
+        },
+        .frustum_culling = false,
+      };
+      draws.clear();
+      stats += fx::cull_meshlets(meshlets, view.meshlet_bounds(), info, 0, 0, draws);
+      draw_count += draws.size();
+    }
+    std::cout << "  " << meshlets.size() << " meshlets, " << static_cast<double>(view.meshlet_vertices().size()) / meshlets.size()
+      << " vertices and " << triangles / meshlets.size() << " triangles each on average\n"
+      << "  cone culling rejects " << 100. * stats.backface_culled / (stats.visible + stats.backface_culled)
+      << "% of meshlets from outside, " << static_cast<double>(draw_count) / viewpoints << " merged draws per view\n";
+  }
+}
+
+auto main(const int argc, char** argv) -> int
+{
+  bool optimize{ true };
+  fx::MeshOptimizeInfo optimize_info{};
+  std::vector<const char*> paths;
+  for (int i{ 1 }; i < argc; ++i) {
+    const std::string_view arg{ argv[i] };
+    if (arg == "--no-optimize") {
+      optimize = false;
+    } else if (arg == "--lods" && i + 1 < argc) {
+      optimize_info.lod_count = static_cast<fx::u32>(std::max(std::atoi(argv[++i]), 1));
+    } else {
+      paths.push_back(argv[i]);
+    }
+  }
+  if (paths.size() != 2) {
+    std::cerr << "usage: foxy_mesh [--no-optimize] [--lods <count>] <input.obj> <output.fxm>\n";
+    return EXIT_FAILURE;
+  }
+  const auto* input_path{ paths[0] };
+  const auto* output_path{ paths[1] };
+
+  const auto source{ read_text(input_path) };
+  if (!source) {
+    std::cerr << "foxy_mesh: can't read " << input_path << "\n";
+    return EXIT_FAILURE;
+  }
+
+  auto start{ Clock::now() };
+  auto mesh{ fx::import_obj(*source) };
+  const auto import_ms{ elapsed_ms(start) };
+  if (!mesh) {
+    std::cerr << "foxy_mesh: " << input_path << " isn't a usable OBJ\n";
+    return EXIT_FAILURE;
+  }
+
+  std::optional<fx::MeshOptimizeReport> report;
+  double optimize_ms{ 0. };
+  if (optimize) {
+    start = Clock::now();
+    report = fx::optimize_mesh(*mesh, optimize_info);
+    optimize_ms = elapsed_ms(start);
+  }
+
+  const auto bytes{ fx::encode_mesh(*mesh) };
+  if (bytes.empty()) {
+    return EXIT_FAILURE;
+  }
+  {
+    std::ofstream out{ output_path, std::ios::binary | std::ios::trunc };
+    if (!out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()))) {
+      std::cerr << "foxy_mesh: can't write " << output_path << "\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  start = Clock::now();
+  const auto loaded{ fx::Mesh::from_bytes(bytes) };
+  const auto load_ms{ elapsed_ms(start) };
+  if (!loaded) {
+    std::cerr << "foxy_mesh: encoded mesh failed validation\n";
+    return EXIT_FAILURE;
+  }
+  const auto& view{ loaded->view() };
+
+  // What the same mesh costs as plain float attributes and 32 bit indices
+  const auto vertex_count{ static_cast<double>(mesh->positions.size()) };
+  const auto unpacked_vertex_size{ sizeof(fx::vec3) + sizeof(fx::vec3) + (mesh->colors.empty() ? 0 : sizeof(fx::vec4)) };
+  const auto unpacked_bytes{ vertex_count * static_cast<double>(unpacked_vertex_size) + static_cast<double>(mesh->indices.size() * sizeof(fx::u32)) };
+  const auto packed_bytes{ static_cast<double>(view.vertex_bytes().size() + view.index_bytes().size()) };
+
+  const auto diagonal{ length(fx::vec3{
+    view.header().bounds_max[0] - view.header().bounds_min[0],
+    view.header().bounds_max[1] - view.header().bounds_min[1],
+    view.header().bounds_max[2] - view.header().bounds_min[2],
+  }) };
+  float max_position_error{ 0.f };
+  float max_normal_error{ 0.f };
+  for (fx::u32 i{ 0 }; i < view.vertex_count(); ++i) {
+    const auto p{ view.position(i) };
+    const auto& original{ mesh->positions[i] };
+    max_position_error = std::max(max_position_error, length(fx::vec3{ p.x - original.x, p.y - original.y, p.z - original.z }));
+    const auto n{ view.normal(i) };
+    const auto& expected{ mesh->normals[i] };
+    const auto cosine{ (n.x * expected.x + n.y * expected.y + n.z * expected.z) / std::max(length(expected), 1e-8f) };
+    max_normal_error = std::max(max_normal_error, std::acos(std::clamp(cosine, -1.f, 1.f)) * 57.29578f);
+  }
+
+  constexpr double mib{ 1024. * 1024. };
+  std::cout << std::fixed << std::setprecision(2)
+    << input_path << ": " << view.vertex_count() << " vertices, " << view.lod(0).index_count / 3 << " triangles, "
+    << (view.indices16().empty() ? 32 : 16) << " bit indices\n"
+    << "  unpacked  " << unpacked_bytes / 1024. << " KiB (" << unpacked_vertex_size << " B/vertex)\n"
+    << "  packed    " << packed_bytes / 1024. << " KiB (" << sizeof(fx::PackedVertex) << " B/vertex), "
+    << unpacked_bytes / std::max(packed_bytes, 1.) << "x smaller\n"
+    << "  streamed at 60 Hz: " << unpacked_bytes * 60. / mib << " MiB/s unpacked, " << packed_bytes * 60. / mib << " MiB/s packed\n"
+    << std::setprecision(6)
+    << "  max position error " << max_position_error << " (" << max_position_error / std::max(diagonal, 1e-8f) * 100.f
+    << "% of the bounds diagonal), max normal error " << max_normal_error << " degrees\n"
+    << std::setprecision(3)
+    << "  load: OBJ import " << import_ms << " ms, .fxm validate + copy " << load_ms << " ms\n";
+
+  if (report) {
+    std::cout << "  optimized in " << optimize_ms << " ms\n";
+    print_cache_stats("before", report->before);
+    print_cache_stats("after ", report->after);
+    for (fx::u32 level{ 0 }; level < view.lod_count(); ++level) {
+      const auto lod{ view.lod(level) };
+      std::cout << "  LOD " << level << ": " << lod.index_count / 3 << " triangles, error " << std::setprecision(6) << lod.error << "\n";
+    }
+    std::cout << std::setprecision(2);
+    print_meshlet_stats(view, diagonal);
+  }
+  return EXIT_SUCCESS;
+}
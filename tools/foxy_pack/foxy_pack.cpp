@@ -0,0 +1,65 @@
+//
+// Packs a resource directory into a Foxy archive (.pak).
+//
+//   foxy_pack <directory> <output.pak> [--lz4] [--align <bytes>] [--prefix <path>]
+//
+// --lz4 compresses every entry that shrinks enough to be worth it. Compressed entries load through a copy
+// instead of straight out of the mapped archive, so leave it off for anything read every launch.
+//
+
+#include "foxy/archive.hpp"
+
+#include <charconv>
+
+namespace {
+  void print_usage()
+  {
+    std::cerr << "usage: foxy_pack <directory> <output.pak> [--lz4] [--align <bytes>] [--prefix <path>]\n";
+  }
+}
+
+auto main(const int argc, char** argv) -> int
+{
+  if (argc < 3) {
+    print_usage();
+    return EXIT_FAILURE;
+  }
+
+  const std::filesystem::path directory{ argv[1] };
+  const std::filesystem::path output{ argv[2] };
+  fx::ArchiveWriter::CreateInfo create_info{};
+  std::filesystem::path prefix{};
+  for (int i{ 3 }; i < argc; ++i) {
+    const std::string_view arg{ argv[i] };
+    if (arg == "--lz4") {
+      create_info.compress = true;
+    } else if (arg == "--align" && i + 1 < argc) {
+      const std::string_view value{ argv[++i] };
+      const auto [end, error]{ std::from_chars(value.data(), value.data() + value.size(), create_info.alignment) };
+      // Rounded up to a power of two when packing, which has to fit in 32 bits
+      if (error != std::errc{} || end != value.data() + value.size()
+          || create_info.alignment == 0 || create_info.alignment > 1U << 31) {
+        std::cerr << "foxy_pack: --align expects a byte count between 1 and " << (1U << 31) << ", got \"" << value << "\"\n";
+        print_usage();
+        return EXIT_FAILURE;
+      }
+    } else if (arg == "--prefix" && i + 1 < argc) {
+      prefix = argv[++i];
+    } else {
+      print_usage();
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (!is_directory(directory)) {
+    std::cerr << "foxy_pack: " << directory.string() << " is not a directory\n";
+    return EXIT_FAILURE;
+  }
+
+  fx::ArchiveWriter writer{ create_info };
+  writer.add_directory(directory, prefix);
+  if (output.has_parent_path()) {
+    create_directories(output.parent_path());
+  }
+  return writer.write(output) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,170 @@
+//
+// Runs the ECS parallel-for workload (CameraSystem's: every entity's view matrix rebuilt from its transform)
+// on the job system with workers left to the OS scheduler and with them pinned by CpuTopology, and reports
+// frame times for both. Entities are split the way the old parallelFor did (one batch per worker) and into
+// small batches that lean on stealing, which is where sharing a cache with the victim matters.
+//
+//   foxy_topology_bench [--entities <count>] [--frames <count>] [--workers <count>]
+//
+
+#include "inu/job_system.hpp"
+#include "inu/cpu_topology.hpp"
+
+namespace {
+  using Clock = std::chrono::steady_clock;
+
+  struct Transform {
+    std::array<float, 3> position{};
+    // x, y, z, w
+    std::array<float, 4> rotation{ 0.f, 0.f, 0.f, 1.f };
+    std::array<float, 3> scale{ 1.f, 1.f, 1.f };
+  };
+
+  struct Camera {
+    // Column major, like glm
+    std::array<float, 16> view{};
+  };
+
+  // inverse(translate * rotate * scale) = scale^-1 * transpose(rotate) * translate^-1
+  void update_camera(const Transform& transform, Camera& camera)
+  {
+    const auto [x, y, z, w]{ transform.rotation };
+    const std::array<float, 9> r{
+      1.f - 2.f * (y * y + z * z), 2.f * (x * y + w * z), 2.f * (x * z - w * y),
+      2.f * (x * y - w * z), 1.f - 2.f * (x * x + z * z), 2.f * (y * z + w * x),
+      2.f * (x * z + w * y), 2.f * (y * z - w * x), 1.f - 2.f * (x * x + y * y),
+    };
+    const auto& p{ transform.position };
+    auto& v{ camera.view };
+    for (int row{ 0 }; row < 3; ++row) {
+      const auto inverse_scale{ 1.f / transform.scale[row] };
+      // Row `row` of the inverse is column `row` of the rotation
+      for (int column{ 0 }; column < 3; ++column) {
+        v[column * 4 + row] = r[row * 3 + column] * inverse_scale;
+      }
+      v[12 + row] = -(v[row] * p[0] + v[4 + row] * p[1] + v[8 + row] * p[2]);
+      v[row * 4 + 3] = 0.f;
+    }
+    v[15] = 1.f;
+  }
+
+  struct World {
+    std::vector<Transform> transforms;
+    std::vector<Camera> cameras;
+
+    explicit World(const fx::u32 count):
+      transforms(count),
+      cameras(count)
+    {
+      std::mt19937 random{ 42 };
+      std::uniform_real_distribution<float> unit{ -1.f, 1.f };
+      for (auto& transform: transforms) {
+        transform.position = { unit(random) * 100.f, unit(random) * 100.f, unit(random) * 100.f };
+        std::array rotation{ unit(random), unit(random), unit(random), unit(random) };
+        const auto length{ std::sqrt(rotation[0] * rotation[0] + rotation[1] * rotation[1] + rotation[2] * rotation[2] + rotation[3] * rotation[3]) };
+        for (auto& component: rotation) {
+          component /= std::max(length, 1e-6f);
+        }
+        transform.rotation = rotation;
+        transform.scale = { 1.f + unit(random) * 0.5f, 1.f + unit(random) * 0.5f, 1.f + unit(random) * 0.5f };
+      }
+    }
+  };
+
+  // Jobs capture the world and their range, 16 bytes, so submitting doesn't allocate
+  void parallel_for(fx::JobSystem& job_system, World& world, const fx::u32 batch_size)
+  {
+    const auto count{ static_cast<fx::u32>(world.transforms.size()) };
+    fx::JobSystem::Counter counter{};
+    for (fx::u32 begin{ 0 }; begin < count; begin += batch_size) {
+      const auto end{ std::min(begin + batch_size, count) };
+      job_system.submit([&world, begin, end] {
+        for (auto i{ begin }; i < end; ++i) {
+          update_camera(world.transforms[i], world.cameras[i]);
+        }
+      }, &counter, fx::JobSystem::Priority::High);
+    }
+    job_system.wait(counter);
+  }
+
+  struct Result {
+    double mean_ms{ 0. };
+    double p99_ms{ 0. };
+    double ns_per_entity{ 0. };
+  };
+
+  [[nodiscard]] auto run(fx::JobSystem& job_system, World& world, const fx::u32 batch_size, const fx::u32 frames) -> Result
+  {
+    // Warm up the caches and wake every worker
+    for (fx::u32 i{ 0 }; i < 10; ++i) {
+      parallel_for(job_system, world, batch_size);
+    }
+
+    std::vector<double> times;
+    times.reserve(frames);
+    for (fx::u32 i{ 0 }; i < frames; ++i) {
+      const auto start{ Clock::now() };
+      parallel_for(job_system, world, batch_size);
+      times.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+    }
+    const auto mean{ std::accumulate(times.begin(), times.end(), 0.) / static_cast<double>(frames) };
+    std::ranges::sort(times);
+    return Result{
+      .mean_ms = mean,
+      .p99_ms = times[std::min<std::size_t>(frames - 1, frames * 99 / 100)],
+      .ns_per_entity = mean * 1'000'000. / static_cast<double>(world.transforms.size()),
+    };
+  }
+}
+
+auto main(const int argc, char** argv) -> int
+{
+  fx::u32 entity_count{ 1 << 20 };
+  fx::u32 frames{ 200 };
+  fx::u32 worker_count{ fx::JobSystem::default_worker_count() };
+  for (int i{ 1 }; i < argc; ++i) {
+    const std::string_view arg{ argv[i] };
+    const auto value{ [&] { return static_cast<fx::u32>(std::max(std::atoi(argv[++i]), 1)); } };
+    if (arg == "--entities" && i + 1 < argc) {
+      entity_count = value();
+    } else if (arg == "--frames" && i + 1 < argc) {
+      frames = value();
+    } else if (arg == "--workers" && i + 1 < argc) {
+      worker_count = value();
+    } else {
+      std::cerr << "usage: foxy_topology_bench [--entities <count>] [--frames <count>] [--workers <count>]\n";
+      return EXIT_FAILURE;
+    }
+  }
+
+  const auto topology{ fx::CpuTopology::detect() };
+  std::set<fx::u32> l3s, nodes;
+  for (const auto& cpu: topology.cpus) {
+    l3s.insert(cpu.l3);
+    nodes.insert(cpu.numa_node);
+  }
+  std::cout << topology.cpus.size() << " logical cpus, " << topology.physical_core_count() << " cores, "
+            << l3s.size() << " L3 domains, " << nodes.size() << " NUMA nodes\n";
+  std::cout << entity_count << " entities, " << frames << " frames, " << worker_count << " workers\n";
+
+  World world{ entity_count };
+  const std::array batch_sizes{ std::max(entity_count / worker_count, 1U), 1024U };
+
+  std::cout << std::fixed << std::setprecision(3);
+  std::cout << "placement   batch     mean ms   p99 ms    ns/entity\n";
+  for (const bool pinned: { false, true }) {
+    fx::JobSystem job_system{ fx::JobSystem::CreateInfo{ .worker_count = worker_count, .pin_workers = pinned } };
+    for (const auto batch_size: batch_sizes) {
+      const auto [mean_ms, p99_ms, ns_per_entity]{ run(job_system, world, batch_size, frames) };
+      std::cout << std::left << std::setw(12) << (pinned ? "pinned" : "unpinned") << std::setw(10) << batch_size << std::right
+                << std::setw(7) << mean_ms << std::setw(10) << p99_ms << std::setw(10) << ns_per_entity << "\n";
+    }
+  }
+
+  // Keeps the results observable
+  const auto checksum{ std::accumulate(world.cameras.begin(), world.cameras.end(), 0.f, [](const float sum, const Camera& camera) {
+    return sum + camera.view[12];
+  }) };
+  std::cout << "(checksum " << checksum << ")\n";
+  return EXIT_SUCCESS;
+}